@@ -0,0 +1,213 @@
+/**
+ * @file autotune.c
+ * @brief Runtime tuning of the tiles of a loop nest, with a tuning database
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include "autotune.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENACC
+#include <openacc.h>
+#endif
+
+static void copy_field(char *dst, size_t size, const char *src)
+{
+    // No tabs and newlines in the fields of the database
+    size_t n = 0;
+    for (; src[n] != '\0' && n + 1 < size; n++) {
+        dst[n] = src[n] == '\t' || src[n] == '\n' ? ' ' : src[n];
+    }
+    dst[n] = '\0';
+}
+
+void autotune_device(char *name, size_t size)
+{
+#ifdef _OPENACC
+    if (acc_get_device_type() == acc_device_nvidia) {
+        const char *gpu = acc_get_property_string(acc_get_device_num(acc_device_nvidia), acc_device_nvidia,
+                                                  acc_property_name);
+        char buf[256];
+        snprintf(buf, sizeof(buf), "gpu:%s", gpu != NULL ? gpu : "unknown");
+        copy_field(name, size, buf);
+        return;
+    }
+#endif
+    char model[256] = "unknown";
+    FILE *fp = fopen("/proc/cpuinfo", "r");
+    if (fp != NULL) {
+        char line[512];
+        while (fgets(line, sizeof(line), fp) != NULL) {
+            if (strncmp(line, "model name", 10) == 0 || strncmp(line, "Processor", 9) == 0 ||
+                strncmp(line, "cpu model", 9) == 0) {
+                const char *v = strchr(line, ':');
+                if (v == NULL) continue;
+                v++;
+                while (*v == ' ') v++;
+                snprintf(model, sizeof(model), "%s", v);
+                model[strcspn(model, "\n")] = '\0';
+                break;
+            }
+        }
+        fclose(fp);
+    }
+    char buf[300];
+    snprintf(buf, sizeof(buf), "cpu:%s", model);
+    copy_field(name, size, buf);
+}
+
+int autotune_candidates(const int extent[2], int nxs, const int *xs, int nys, const int *ys,
+                        int (*tiles)[2])
+{
+    int n = 0;
+    tiles[n][0] = 0;
+    tiles[n][1] = 0;
+    n++;
+    for (int b=0; b<nys; b++) {
+        for (int a=0; a<nxs; a++) {
+            const int tx = xs[a] < extent[0] ? xs[a] : 0;
+            const int ty = ys[b] < extent[1] ? ys[b] : 0;
+            bool found = false;
+            for (int k=0; k<n; k++) {
+                found = found || (tiles[k][0] == tx && tiles[k][1] == ty);
+            }
+            if (!found && n < AUTOTUNE_MAX_CANDIDATES) {
+                tiles[n][0] = tx;
+                tiles[n][1] = ty;
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+static double autotune_clock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1.0e-9;
+}
+
+double autotune_time(void (*run)(const int tile[2], void *arg), void *arg, const int tile[2],
+                     int nwarmup, int nrep)
+{
+    for (int r=0; r<nwarmup; r++) {
+        run(tile, arg);
+    }
+    double best = 1.0e30;
+    for (int r=0; r<nrep; r++) {
+        const double t0 = autotune_clock();
+        run(tile, arg);
+#ifdef _OPENACC
+#pragma acc wait
+#endif
+        const double t = autotune_clock() - t0;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+bool autotune_lookup(const char *db, const char *device, const char *kernel, const char *size, int tile[2])
+{
+    FILE *fp = fopen(db, "r");
+    if (fp == NULL) return false;
+
+    char key_device[256], key_kernel[256], key_size[256];
+    copy_field(key_device, sizeof(key_device), device);
+    copy_field(key_kernel, sizeof(key_kernel), kernel);
+    copy_field(key_size,   sizeof(key_size),   size);
+
+    bool found = false;
+    char line[1024];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (line[0] == '#') continue;
+        char *saveptr;
+        const char *d = strtok_r(line, "\t", &saveptr);
+        const char *k = strtok_r(NULL, "\t", &saveptr);
+        const char *s = strtok_r(NULL, "\t", &saveptr);
+        const char *t = strtok_r(NULL, "\t", &saveptr);
+        int tx, ty;
+        if (d == NULL || k == NULL || s == NULL || t == NULL || sscanf(t, "%d %d", &tx, &ty) != 2) continue;
+        if (strcmp(d, key_device) == 0 && strcmp(k, key_kernel) == 0 && strcmp(s, key_size) == 0) {
+            tile[0] = tx;
+            tile[1] = ty;
+            found = true;
+        }
+    }
+    fclose(fp);
+    return found;
+}
+
+bool autotune_store(const char *db, const char *device, const char *kernel, const char *size,
+                    const int tile[2], double time)
+{
+    FILE *fp = fopen(db, "a");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", db);
+        return false;
+    }
+    char f_device[256], f_kernel[256], f_size[256];
+    copy_field(f_device, sizeof(f_device), device);
+    copy_field(f_kernel, sizeof(f_kernel), kernel);
+    copy_field(f_size,   sizeof(f_size),   size);
+
+    // One write per line, so that concurrent runs do not interleave
+    char line[1024];
+    snprintf(line, sizeof(line), "%s\t%s\t%s\t%d %d\t%.3f\n", f_device, f_kernel, f_size, tile[0], tile[1], time*1.0e6);
+    fputs(line, fp);
+    fclose(fp);
+    return true;
+}
+
+bool autotune_tile(const char *db, int mode, const char *kernel, const char *size,
+                   int ncandidates, const int (*candidates)[2],
+                   void (*run)(const int tile[2], void *arg), void *arg,
+                   int nwarmup, int nrep, int tile[2])
+{
+    if (mode == AUTOTUNE_OFF) return false;
+
+    char device[256];
+    autotune_device(device, sizeof(device));
+    if (mode == AUTOTUNE_AUTO && autotune_lookup(db, device, kernel, size, tile)) {
+        fprintf(stdout, "autotune: %s %s: tile %d x %d (%s)\n", kernel, size, tile[0], tile[1], db);
+        return false;
+    }
+
+    int    best      = 0;
+    double best_time = 1.0e30;
+    double base_time = 0.0;
+    for (int c=0; c<ncandidates; c++) {
+        const double t = autotune_time(run, arg, candidates[c], nwarmup, nrep);
+        if (c == 0) base_time = t;
+        if (t < best_time) {
+            best_time = t;
+            best      = c;
+        }
+    }
+    tile[0] = candidates[best][0];
+    tile[1] = candidates[best][1];
+    fprintf(stdout, "autotune: %s %s: tile %d x %d, %.1f [usec] (untiled %.1f [usec], %d candidates)\n",
+            kernel, size, tile[0], tile[1], best_time*1.0e6, base_time*1.0e6, ncandidates);
+    autotune_store(db, device, kernel, size, tile, best_time);
+    return true;
+}
+
+int autotune_env(const char **db)
+{
+    const char *v = getenv("AUTOTUNE_DB");
+    *db = v != NULL && v[0] != '\0' ? v : "tuning.db";
+
+    const char *mode = getenv("AUTOTUNE");
+    if (mode == NULL || strcmp(mode, "off") == 0 || strcmp(mode, "0") == 0 || mode[0] == '\0') return AUTOTUNE_OFF;
+    if (strcmp(mode, "force") == 0) return AUTOTUNE_FORCE;
+    return AUTOTUNE_AUTO;
+}
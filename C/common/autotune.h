@@ -0,0 +1,92 @@
+/**
+ * @file autotune.h
+ * @brief Runtime tuning of the tiles of a loop nest, with a tuning database
+ *
+ * A kernel whose loop nest is split into tile[0] x tile[1] tiles (one
+ * gang per tile, its cells over the vector lanes; on the host, cache
+ * blocks) is timed with each candidate tile on a short warm-up of the
+ * actual problem size, and the fastest tile is appended to a text
+ * database, one line per result:
+ *
+ *   <device> TAB <kernel> TAB <size> TAB <tile[0]> <tile[1]> TAB <usec per call>
+ *
+ * where device is the GPU (gpu:<name>) or the CPU model (cpu:<model name>
+ * of /proc/cpuinfo).  Later runs on the same device and size take the
+ * tile from the database; the last line of a key wins.  A tile of 0 is
+ * the whole extent, i.e. the original loop nest.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUTOTUNE_MAX_CANDIDATES 64
+
+enum AutotuneMode {
+    AUTOTUNE_OFF   = 0, // the original loop nests
+    AUTOTUNE_AUTO  = 1, // the tile of the database, tuned when it is not there
+    AUTOTUNE_FORCE = 2  // tuned again, and the database updated
+};
+
+// The device of the compute regions: gpu:<name> or cpu:<model name>
+void autotune_device(char *name, size_t size);
+
+/**
+ * @brief candidate tiles of a loop nest of extent[0] x extent[1]
+ *
+ * The whole extent (0, 0) first, then the tiles of xs x ys smaller than the
+ * extent.
+ *
+ * @return number of candidates
+ */
+int autotune_candidates(const int extent[2], int nxs, const int *xs, int nys, const int *ys,
+                        int (*tiles)[2]);
+
+/**
+ * @brief time of one call of run(tile, arg), the fastest of nrep calls after nwarmup calls
+ *
+ * @return [sec]
+ */
+double autotune_time(void (*run)(const int tile[2], void *arg), void *arg, const int tile[2],
+                     int nwarmup, int nrep);
+
+bool autotune_lookup(const char *db, const char *device, const char *kernel, const char *size, int tile[2]);
+bool autotune_store(const char *db, const char *device, const char *kernel, const char *size,
+                    const int tile[2], double time);
+
+/**
+ * @brief the tile of a kernel on this device for a problem size
+ *
+ * Without MPI: the tile of db (AUTOTUNE_AUTO), otherwise the fastest of
+ * the candidates, stored in db.  tile is unchanged with AUTOTUNE_OFF.
+ *
+ * @return true when the tile was tuned now (false: from db, or off)
+ */
+bool autotune_tile(const char *db, int mode, const char *kernel, const char *size,
+                   int ncandidates, const int (*candidates)[2],
+                   void (*run)(const int tile[2], void *arg), void *arg,
+                   int nwarmup, int nrep, int tile[2]);
+
+/**
+ * @brief the mode and database of the environment: AUTOTUNE (off, auto or force)
+ *        and AUTOTUNE_DB (default tuning.db)
+ */
+int autotune_env(const char **db);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AUTOTUNE_H */
@@ -0,0 +1,271 @@
+/**
+ * @file perf_counters.c
+ * @brief Hardware performance counters of the kernels (Linux perf_event_open)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perf_counters.h"
+
+#define PERF_MAX_KERNELS 32
+#define PERF_NAME_LEN    32
+#define PERF_LINE_BYTES  64
+
+enum PerfEvent {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_REFERENCES,
+    PERF_LLC_MISSES,
+    PERF_NEVENTS
+};
+
+static const struct {
+    const char *name;
+    uint64_t   config;
+} perf_events[PERF_NEVENTS] = {
+    { "cycles",         PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions",   PERF_COUNT_HW_INSTRUCTIONS },
+    { "llc_references", PERF_COUNT_HW_CACHE_REFERENCES },
+    { "llc_misses",     PERF_COUNT_HW_CACHE_MISSES }
+};
+
+struct PerfKernel {
+    char     name[PERF_NAME_LEN];
+    long     calls;
+    double   elapsed;               // [s]
+    double   count[PERF_NEVENTS];   // scaled by the running time
+    double   begin_time;
+    uint64_t begin[PERF_NEVENTS][3]; // value, time enabled, time running
+};
+
+static struct {
+    bool initialized;
+    int  rank;                      // -1: no MPI
+    int  fd[PERF_NEVENTS];          // -1: not available
+    int  nkernels;
+    struct PerfKernel kernels[PERF_MAX_KERNELS];
+} perf = { false };
+
+
+static double perf_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1.0e-9*ts.tv_nsec;
+}
+
+
+static int perf_open(uint64_t config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.config         = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // calling thread, any cpu
+    const int fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd < 0) return -1;
+
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    return fd;
+}
+
+
+static void perf_read(uint64_t value[PERF_NEVENTS][3])
+{
+    for (int e=0; e<PERF_NEVENTS; e++) {
+        value[e][0] = value[e][1] = value[e][2] = 0;
+        if (perf.fd[e] < 0) continue;
+        if (read(perf.fd[e], value[e], sizeof(value[e])) != (ssize_t)sizeof(value[e])) {
+            value[e][0] = value[e][1] = value[e][2] = 0;
+        }
+    }
+}
+
+
+static void perf_counters_exit(void)
+{
+    // the table of each rank in one write
+    char   *table = NULL;
+    size_t size   = 0;
+    FILE   *mem   = open_memstream(&table, &size);
+    if (mem != NULL) {
+        perf_counters_report(mem);
+        fclose(mem);
+        fputs(table, stdout);
+        fflush(stdout);
+        free(table);
+    } else {
+        perf_counters_report(stdout);
+    }
+
+    const char *csv = getenv("PERF_COUNTERS_CSV");
+    if (csv != NULL && csv[0] != '\0') {
+        char filename[256];
+        // one file per rank
+        if (perf.rank >= 0) {
+            snprintf(filename, sizeof(filename), "%s.%04d", csv, perf.rank);
+        } else {
+            snprintf(filename, sizeof(filename), "%s", csv);
+        }
+
+        FILE *fp = fopen(filename, "w");
+        if (fp == NULL) {
+            fprintf(stderr, "perf_counters: cannot open %s\n", filename);
+        } else {
+            fprintf(fp, "kernel,calls,time");
+            for (int e=0; e<PERF_NEVENTS; e++) fprintf(fp, ",%s", perf_events[e].name);
+            fprintf(fp, ",ipc,llc_miss_rate,dram_gbytes_per_s\n");
+            for (int k=0; k<perf.nkernels; k++) {
+                const struct PerfKernel *p = &perf.kernels[k];
+                fprintf(fp, "%s,%ld,%.6e", p->name, p->calls, p->elapsed);
+                for (int e=0; e<PERF_NEVENTS; e++) {
+                    if (perf.fd[e] < 0) fprintf(fp, ",");
+                    else                fprintf(fp, ",%.0f", p->count[e]);
+                }
+                if (perf.fd[PERF_CYCLES] >= 0 && perf.fd[PERF_INSTRUCTIONS] >= 0 && p->count[PERF_CYCLES] > 0.0) {
+                    fprintf(fp, ",%.3f", p->count[PERF_INSTRUCTIONS]/p->count[PERF_CYCLES]);
+                } else {
+                    fprintf(fp, ",");
+                }
+                if (perf.fd[PERF_LLC_REFERENCES] >= 0 && perf.fd[PERF_LLC_MISSES] >= 0 && p->count[PERF_LLC_REFERENCES] > 0.0) {
+                    fprintf(fp, ",%.4f", p->count[PERF_LLC_MISSES]/p->count[PERF_LLC_REFERENCES]);
+                } else {
+                    fprintf(fp, ",");
+                }
+                if (perf.fd[PERF_LLC_MISSES] >= 0 && p->elapsed > 0.0) {
+                    fprintf(fp, ",%.3f\n", PERF_LINE_BYTES*p->count[PERF_LLC_MISSES]/p->elapsed*1.0e-09);
+                } else {
+                    fprintf(fp, ",\n");
+                }
+            }
+            fclose(fp);
+        }
+    }
+
+    for (int e=0; e<PERF_NEVENTS; e++) {
+        if (perf.fd[e] >= 0) close(perf.fd[e]);
+        perf.fd[e] = -1;
+    }
+}
+
+
+void perf_counters_init(int rank)
+{
+    if (perf.initialized) return;
+    perf.initialized = true;
+    perf.nkernels = 0;
+    perf.rank = rank;
+
+    int navailable = 0;
+    for (int e=0; e<PERF_NEVENTS; e++) {
+        perf.fd[e] = perf_open(perf_events[e].config);
+        if (perf.fd[e] >= 0) navailable++;
+    }
+    if (navailable == 0) {
+        fprintf(stderr, "perf_counters: no hardware counter is available "
+                "(see /proc/sys/kernel/perf_event_paranoid); only the time is measured\n");
+    }
+
+    atexit(perf_counters_exit);
+}
+
+
+int perf_counters_begin(const char *name)
+{
+    if (!perf.initialized) perf_counters_init(-1);
+
+    int id;
+    for (id=0; id<perf.nkernels; id++) {
+        if (strcmp(perf.kernels[id].name, name) == 0) break;
+    }
+    if (id == perf.nkernels) {
+        if (perf.nkernels == PERF_MAX_KERNELS) return -1;
+        struct PerfKernel *p = &perf.kernels[perf.nkernels++];
+        memset(p, 0, sizeof(*p));
+        snprintf(p->name, sizeof(p->name), "%s", name);
+    }
+
+    struct PerfKernel *p = &perf.kernels[id];
+    perf_read(p->begin);
+    p->begin_time = perf_time();
+    return id;
+}
+
+
+void perf_counters_end(int id)
+{
+    if (id < 0 || id >= perf.nkernels) return;
+
+    uint64_t end[PERF_NEVENTS][3];
+    const double end_time = perf_time();
+    perf_read(end);
+
+    struct PerfKernel *p = &perf.kernels[id];
+    p->calls++;
+    p->elapsed += end_time - p->begin_time;
+    for (int e=0; e<PERF_NEVENTS; e++) {
+        const uint64_t value   = end[e][0] - p->begin[e][0];
+        const uint64_t enabled = end[e][1] - p->begin[e][1];
+        const uint64_t running = end[e][2] - p->begin[e][2];
+        // the counter was multiplexed for a part of the interval
+        if (running > 0) p->count[e] += (double)value*((double)enabled/running);
+    }
+}
+
+
+void perf_counters_report(FILE *fp)
+{
+    if (!perf.initialized || perf.nkernels == 0) return;
+
+    if (perf.rank >= 0) fprintf(fp, "Hardware counters of rank %d\n", perf.rank);
+    else                fprintf(fp, "Hardware counters\n");
+    fprintf(fp, "  %-18s %8s %12s %14s %14s %6s %12s %9s %10s\n",
+            "kernel", "calls", "time [s]", "cycles", "instructions", "IPC",
+            "LLC misses", "miss rate", "DRAM GB/s");
+
+    for (int k=0; k<perf.nkernels; k++) {
+        const struct PerfKernel *p = &perf.kernels[k];
+        char cycles[32] = "n/a", instructions[32] = "n/a", ipc[16] = "n/a";
+        char misses[32] = "n/a", rate[16] = "n/a", bandwidth[16] = "n/a";
+
+        if (perf.fd[PERF_CYCLES] >= 0)       snprintf(cycles, sizeof(cycles), "%.4e", p->count[PERF_CYCLES]);
+        if (perf.fd[PERF_INSTRUCTIONS] >= 0) snprintf(instructions, sizeof(instructions), "%.4e", p->count[PERF_INSTRUCTIONS]);
+        if (perf.fd[PERF_LLC_MISSES] >= 0)   snprintf(misses, sizeof(misses), "%.4e", p->count[PERF_LLC_MISSES]);
+        if (perf.fd[PERF_CYCLES] >= 0 && perf.fd[PERF_INSTRUCTIONS] >= 0 && p->count[PERF_CYCLES] > 0.0) {
+            snprintf(ipc, sizeof(ipc), "%.2f", p->count[PERF_INSTRUCTIONS]/p->count[PERF_CYCLES]);
+        }
+        if (perf.fd[PERF_LLC_REFERENCES] >= 0 && perf.fd[PERF_LLC_MISSES] >= 0 && p->count[PERF_LLC_REFERENCES] > 0.0) {
+            snprintf(rate, sizeof(rate), "%.1f%%", 100.0*p->count[PERF_LLC_MISSES]/p->count[PERF_LLC_REFERENCES]);
+        }
+        // every LLC miss is one cache line read from (or written back to) DRAM
+        if (perf.fd[PERF_LLC_MISSES] >= 0 && p->elapsed > 0.0) {
+            snprintf(bandwidth, sizeof(bandwidth), "%.3f", PERF_LINE_BYTES*p->count[PERF_LLC_MISSES]/p->elapsed*1.0e-09);
+        }
+
+        fprintf(fp, "  %-18s %8ld %12.4e %14s %14s %6s %12s %9s %10s\n",
+                p->name, p->calls, p->elapsed, cycles, instructions, ipc,
+                misses, rate, bandwidth);
+    }
+    fflush(fp);
+}
@@ -0,0 +1,61 @@
+/**
+ * @file perf_counters.h
+ * @brief Hardware performance counters of the kernels (Linux perf_event_open)
+ *
+ * Built with -DUSE_PERF_COUNTERS (make PERF_COUNTERS=1), PERF_BEGIN and
+ * PERF_END around a kernel call accumulate, per kernel name,
+ *
+ *   cycles, instructions, LLC references, LLC misses and the time
+ *
+ * of the calling thread, and a table with IPC, LLC miss rate and the
+ * DRAM bandwidth estimated from the LLC misses (64 bytes each) is
+ * printed at exit.  PERF_COUNTERS_CSV=<file> also writes it as CSV.
+ * Otherwise the macros expand to nothing.
+ *
+ * Only the system call is used (no libpfm or PAPI).  Events the kernel
+ * or the machine does not provide (virtual machines,
+ * perf_event_paranoid) are reported as n/a; multiplexed counts are
+ * scaled by their running time.  For kernels offloaded with OpenACC the
+ * counters see the host thread waiting for the device.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief open the counters of the calling thread and print the table at exit
+ *
+ * @param rank MPI rank printed with the table (and suffix of the CSV file), or -1
+ */
+void perf_counters_init(int rank);
+int  perf_counters_begin(const char *name);
+void perf_counters_end(int id);
+void perf_counters_report(FILE *fp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef USE_PERF_COUNTERS
+#define PERF_INIT(rank)  perf_counters_init(rank)
+#define PERF_BEGIN(name) const int perf_id_##name = perf_counters_begin(#name)
+#define PERF_END(name)   perf_counters_end(perf_id_##name)
+#else
+#define PERF_INIT(rank)
+#define PERF_BEGIN(name)
+#define PERF_END(name)
+#endif
+
+#endif /* PERF_COUNTERS_H */
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/time.h>
+#include "perf_counters.h"
 
 
 void   init_cpu(unsigned int n, float *a);
@@ -30,6 +31,8 @@ int main(int argc, char *argv[])
 
     const float b0 = 2.0;
 
+    PERF_INIT(-1);
+
     struct timeval tv0;
     gettimeofday(&tv0, NULL);
 
@@ -45,7 +48,9 @@ int main(int argc, char *argv[])
     }
 
     for (unsigned int icnt=0; icnt<nt; icnt++) {
+	PERF_BEGIN(calc);
 	calc(nx, ny, a, b, c);
+	PERF_END(calc);
     }
 
     double sum = 0;
@@ -13,6 +13,7 @@
 
 #include "misc.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/time.h>
 
 static time_t sec_org = 0;
@@ -46,3 +47,53 @@ double get_elapsed_time()
 }
 
 
+double stream_bandwidth(int n)
+{
+    float *a = (float *)malloc(sizeof(float)*n);
+    float *b = (float *)malloc(sizeof(float)*n);
+    float *c = (float *)malloc(sizeof(float)*n);
+    const float s = 3.0;
+    double best = 0.0;
+
+#pragma acc data create(a[0:n], b[0:n], c[0:n])
+    {
+#pragma acc kernels present(a, b, c)
+#pragma acc loop independent
+        for (int i = 0; i < n; i++) {
+            a[i] = 0.0;
+            b[i] = 1.0;
+            c[i] = 2.0;
+        }
+
+        /* The first pass is not timed */
+        for (int r = 0; r < 6; r++) {
+            start_timer();
+#pragma acc kernels present(a, b, c)
+#pragma acc loop independent
+            for (int i = 0; i < n; i++) {
+                a[i] = b[i] + s*c[i];
+            }
+            const double t = get_elapsed_time();
+            if (r > 0 && (best == 0.0 || t < best)) best = t;
+        }
+    }
+
+    free(a);
+    free(b);
+    free(c);
+
+    return 3.0*sizeof(float)*(double)n/best;
+}
+
+void report_roofline(const char *name, double flop, double bytes, double elapsed_time, double bandwidth)
+{
+    const char  *env  = getenv("ROOFLINE_PEAK_GFLOPS");
+    const double peak = env != NULL ? atof(env)*1.0e9 : 0.0;
+
+    const double ai         = flop/bytes;
+    const double attainable = peak > 0.0 && peak < ai*bandwidth ? peak : ai*bandwidth;
+    const double achieved   = flop/elapsed_time;
+
+    fprintf(stdout, "%s: %7.2f [GFlops], %7.2f [GB/s], %5.3f [Flop/Byte], roofline %7.2f [GFlops] (%5.1f %%)\n",
+            name, achieved*1.0e-9, bytes/elapsed_time*1.0e-9, ai, attainable*1.0e-9, 100.0*achieved/attainable);
+}
@@ -6,6 +6,17 @@
 
 double diffusion3d(int nx, int ny, int nz, float dx, float dy, float dz, float dt, float kappa,
                    const float *f, float *fn);
+double diffusion3d_bytes(int nx, int ny, int nz);
+
+/*
+ * Tile of the x-y plane of diffusion3d; { 0, 0 } is the original loop
+ * nest.  diffusion3d_tune() sets the tile of the tuning database, or the
+ * fastest one on this node, when the environment variable AUTOTUNE is
+ * auto or force (autotune.h).
+ */
+void diffusion3d_set_tile(const int tile[2]);
+void diffusion3d_tune(int nx, int ny, int nz, float dx, float dy, float dz, float dt, float kappa,
+                      const float *f, float *fn);
 void init(int nx, int ny, int nz, float dx, float dy, float dz, float *f);
 double accuracy(double time, int nx, int ny, int nz, float dx, float dy, float dz, float kappa, const float *f);
 
@@ -19,6 +19,17 @@ void swap(float **f, float **fn);
 void start_timer();
 double get_elapsed_time();
 
+/* Bandwidth [bytes/sec] of the STREAM triad a = b + s*c over n floats */
+double stream_bandwidth(int n);
+
+/*
+ * Print the performance of a kernel against the roofline
+ * min(peak, flop/bytes * bandwidth); the peak [GFlops] is taken from the
+ * environment variable ROOFLINE_PEAK_GFLOPS, otherwise only the
+ * bandwidth roof is used.
+ */
+void report_roofline(const char *name, double flop, double bytes, double elapsed_time, double bandwidth);
+
 
 #endif /* MISC_H */
 
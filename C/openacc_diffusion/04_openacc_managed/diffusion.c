@@ -2,6 +2,15 @@
 
 #include <stdio.h>
 #include <math.h>
+#include "diffusion.h"
+#include "autotune.h"
+
+/* Set by diffusion3d_set_tile(); { 0, 0 }: the original loop nest */
+static int diffusion3d_tile[2];
+
+static void diffusion3d_tiled(int nx, int ny, int nz, const int tile[2],
+                              float cc, float ce, float cw, float cn, float cs, float ct, float cb,
+                              const float *f, float *fn);
 
 
 double diffusion3d(int nx, int ny, int nz, float dx, float dy, float dz, float dt, float kappa,
@@ -16,6 +25,11 @@ double diffusion3d(int nx, int ny, int nz, float dx, float dy, float dz, float d
 
     const float cc = 1.0 - (ce + cw + cn + cs + ct + cb);
 
+    if (diffusion3d_tile[0] > 0 || diffusion3d_tile[1] > 0) {
+        diffusion3d_tiled(nx, ny, nz, diffusion3d_tile, cc, ce, cw, cn, cs, ct, cb, f, fn);
+        return (double)(nx*ny*nz)*13.0;
+    }
+
 #pragma acc kernels //present(f, fn)
 #pragma acc loop independent    
     for(int k = 0; k < nz; k++) {
@@ -39,6 +53,100 @@ double diffusion3d(int nx, int ny, int nz, float dx, float dy, float dz, float d
     return (double)(nx*ny*nz)*13.0;
 }
 
+/*
+ * The same update over tiles of tile[0] x tile[1] cells in the x-y plane,
+ * each swept along z, so that the planes k-1, k and k+1 of a tile stay in
+ * the caches; on the GPU one gang per tile, the cells of a tile over the
+ * vector lanes.
+ */
+static void diffusion3d_tiled(int nx, int ny, int nz, const int tile[2],
+                              float cc, float ce, float cw, float cn, float cs, float ct, float cb,
+                              const float *f, float *fn)
+{
+    const int tx  = tile[0] > 0 && tile[0] < nx ? tile[0] : nx;
+    const int ty  = tile[1] > 0 && tile[1] < ny ? tile[1] : ny;
+    const int ntx = (nx + tx - 1)/tx;
+    const int nty = (ny + ty - 1)/ty;
+
+#pragma acc kernels //present(f, fn)
+#pragma acc loop independent gang collapse(2)
+    for (int tj = 0; tj < nty; tj++) {
+        for (int ti = 0; ti < ntx; ti++) {
+            const int i0 = ti*tx;
+            const int j0 = tj*ty;
+            const int i1 = i0 + tx < nx ? i0 + tx : nx;
+            const int j1 = j0 + ty < ny ? j0 + ty : ny;
+#pragma acc loop seq
+            for (int k = 0; k < nz; k++) {
+#pragma acc loop independent vector collapse(2)
+                for (int j = j0; j < j1; j++) {
+                    for (int i = i0; i < i1; i++) {
+                        const int ix = nx*ny*k + nx*j + i;
+                        const int ip = i == nx - 1 ? ix : ix + 1;
+                        const int im = i == 0      ? ix : ix - 1;
+                        const int jp = j == ny - 1 ? ix : ix + nx;
+                        const int jm = j == 0      ? ix : ix - nx;
+                        const int kp = k == nz - 1 ? ix : ix + nx*ny;
+                        const int km = k == 0      ? ix : ix - nx*ny;
+
+                        fn[ix] = cc*f[ix] + ce*f[ip] + cw*f[im] + cn*f[jp] + cs*f[jm] + ct*f[kp] + cb*f[km];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void diffusion3d_set_tile(const int tile[2])
+{
+    diffusion3d_tile[0] = tile[0] > 0 ? tile[0] : 0;
+    diffusion3d_tile[1] = tile[1] > 0 ? tile[1] : 0;
+}
+
+struct TuneArgs {
+    int nx, ny, nz;
+    float dx, dy, dz, dt, kappa;
+    const float *f;
+    float *fn;
+};
+
+static void run_diffusion3d(const int tile[2], void *arg)
+{
+    const struct TuneArgs *a = (const struct TuneArgs *)arg;
+    diffusion3d_set_tile(tile);
+    diffusion3d(a->nx, a->ny, a->nz, a->dx, a->dy, a->dz, a->dt, a->kappa, a->f, a->fn);
+}
+
+void diffusion3d_tune(int nx, int ny, int nz, float dx, float dy, float dz, float dt, float kappa,
+                      const float *f, float *fn)
+{
+    const char *db;
+    const int mode = autotune_env(&db);
+    if (mode == AUTOTUNE_OFF) return;
+
+    /* Tiles along x and y; only fn is written, and overwritten by the first step */
+    const int xs[] = { 256, 128, 64, 32, 16 };
+    const int ys[] = { 32, 16, 8, 4, 1 };
+    const int extent[2] = { nx, ny };
+    int tiles[AUTOTUNE_MAX_CANDIDATES][2];
+    const int ncandidates = autotune_candidates(extent, sizeof(xs)/sizeof(xs[0]), xs,
+                                                sizeof(ys)/sizeof(ys[0]), ys, tiles);
+
+    char size[64];
+    snprintf(size, sizeof(size), "%dx%dx%d", nx, ny, nz);
+    struct TuneArgs a = { nx, ny, nz, dx, dy, dz, dt, kappa, f, fn };
+    int tile[2] = { 0, 0 };
+    autotune_tile(db, mode, "diffusion3d", size, ncandidates, (const int (*)[2])tiles,
+                  run_diffusion3d, &a, 1, 3, tile);
+    diffusion3d_set_tile(tile);
+}
+
+double diffusion3d_bytes(int nx, int ny, int nz)
+{
+    /* f read and fn written once per cell; the neighbours are reused from the caches */
+    return (double)(nx*ny*nz)*2.0*sizeof(float);
+}
+
 
 void init(int nx, int ny, int nz, float dx, float dy, float dz, float *f)
 {
@@ -5,6 +5,7 @@
 #include <math.h>
 #include "diffusion.h"
 #include "misc.h"
+#include "perf_counters.h"
 
 int main(int argc, char *argv[])
 {
@@ -28,21 +29,34 @@ int main(int argc, char *argv[])
     double time = 0.0;
     int    icnt = 0;
     double flop = 0.0;
+    double bytes = 0.0;
     double elapsed_time = 0.0;
     
     float *f  = (float *)malloc(sizeof(float)*n);
     float *fn = (float *)malloc(sizeof(float)*n);
 
+    /* Bandwidth of this node, over arrays larger than the caches */
+    const double bandwidth = stream_bandwidth(n > (1 << 25) ? n : (1 << 25));
+    fprintf(stdout, "Bandwidth = %7.2f [GB/s] (STREAM triad)\n", bandwidth*1.0e-09);
+
+    PERF_INIT(-1);
+
     init(nx, ny, nz, dx, dy, dz, f);
 
 /* #pragma acc data copy(f[0:n]) create(fn[0:n]) */
 /*     { */
+        /* Tile of diffusion3d for this grid and node (AUTOTUNE, AUTOTUNE_DB) */
+        diffusion3d_tune(nx, ny, nz, dx, dy, dz, dt, kappa, f, fn);
+
         start_timer();
     
         for (; icnt<nt && time + 0.5*dt < 0.1; icnt++) {
 	  if (icnt % 100 == 0) fprintf(stdout, "time(%4d) = %7.5f\n", icnt, time);
             
+            PERF_BEGIN(diffusion3d);
             flop += diffusion3d(nx, ny, nz, dx, dy, dz, dt, kappa, f, fn);
+            PERF_END(diffusion3d);
+            bytes += diffusion3d_bytes(nx, ny, nz);
             
             swap(&f, &fn);
 
@@ -54,6 +68,7 @@ int main(int argc, char *argv[])
     
     fprintf(stdout, "Time = %8.3f [sec]\n", elapsed_time);
     fprintf(stdout, "Performance= %7.2f [GFlops]\n",flop/elapsed_time*1.0e-09);
+    report_roofline("diffusion3d", flop, bytes, elapsed_time, bandwidth);
     
     const double ferr = accuracy(time, nx, ny, nz, dx, dy, dz, kappa, f);
     fprintf(stdout, "Error[%d][%d][%d] = %10.6e\n", nx, ny, nz, ferr);
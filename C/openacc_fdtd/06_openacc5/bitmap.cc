@@ -14,8 +14,36 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <vector>
+#include <algorithm>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "bitmap_palette-def.h"
 
+namespace {
+
+template <typename T>
+inline void put(unsigned char *&p, const T &v)
+{
+    memcpy(p, &v, sizeof(T));
+    p += sizeof(T);
+}
+
+template <typename T>
+inline bool get(const unsigned char *&p, const unsigned char *end, T *v)
+{
+    if (p + sizeof(T) > end) return false;
+    memcpy(v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+} // namespace
+
 BitmapHeader::BitmapHeader()
 {
     is_bitmap_ = false;
@@ -156,6 +184,88 @@ bool BitmapHeader::write(FILE *fp) const
     return true;
 }
 
+bool BitmapHeader::read(const unsigned char *buf, size_t size)
+{
+    if (buf == NULL) return false;
+    is_bitmap_ = false;
+
+    const unsigned char *p   = buf;
+    const unsigned char *end = buf + size;
+    
+    // read Bitmap File Header
+    if ((! get(p, end, &bfType_)) ||
+        (strncmp((const char*)&bfType_, "BM", 2) != 0)) { return false; }
+
+    if (! get(p, end, &bfSize_     )) { return false; }
+    if (! get(p, end, &bfReserved1_)) { return false; }
+    if (! get(p, end, &bfReserved2_)) { return false; }
+    if (! get(p, end, &bfOffBits_  )) { return false; }
+
+    // read Bitmap Information Header
+    if ((! get(p, end, &biSize_  )) || (biSize_ != 40)) { return false; }    
+    if (  ! get(p, end, &biWidth_ )) { return false; }
+    if (  ! get(p, end, &biHeight_)) { return false; }
+    if ((! get(p, end, &biPlanes_)) || (biPlanes_!= 1)) { return false; }
+    
+    if ((! get(p, end, &biBitCount_)) ||
+        (bit_count_is_supported(biBitCount_) == 0)) { return false; }
+    
+    if ((! get(p, end, &biCompression_ )) || (biCompression_ != 0)) { return false; }
+    if (  ! get(p, end, &biSizeImage_   )) { return false; }
+    if (  ! get(p, end, &biXPixPerMeter_)) { return false; }
+    if (  ! get(p, end, &biYPixPerMeter_)) { return false; }
+    if ((! get(p, end, &biClrUsed_     )) || (biClrUsed_ != 0)) { return false; }
+    if ((! get(p, end, &biCirImportant_)) || (biCirImportant_ != 0)) { return false; }
+    
+    const size_t n = palette_size();
+    if (n > 0) {
+        if (p + n > end) { return false; }
+        delete [] palette_;
+        palette_ = new unsigned char[n];
+        memcpy(palette_, p, n);
+    }
+    
+    is_bitmap_ = true;
+    
+    return true;
+}
+
+size_t BitmapHeader::write(unsigned char *buf) const
+{
+    if (! is_bitmap()) return 0;
+    if (buf == NULL) return 0;
+
+    unsigned char *p = buf;
+    
+    // Bitmap File Header (14 byte)
+    put(p, bfType_     );
+    put(p, bfSize_     );
+    put(p, bfReserved1_);
+    put(p, bfReserved2_);
+    put(p, bfOffBits_  );
+
+    // Bitmap Information Header (40 byte)
+    put(p, biSize_        );
+    put(p, biWidth_       );
+    put(p, biHeight_      );
+    put(p, biPlanes_      );
+    put(p, biBitCount_    );
+    put(p, biCompression_ );
+    put(p, biSizeImage_   );
+    put(p, biXPixPerMeter_);
+    put(p, biYPixPerMeter_);
+    put(p, biClrUsed_     );
+    put(p, biCirImportant_);
+
+    // Bitmap Palette Data (RGBQUAD)
+    if (palette_size() > 0) {
+        memcpy(p, palette_, palette_size());
+        p += palette_size();
+    }
+
+    return p - buf;
+}
+
 int BitmapHeader::width() const              { return biWidth_; }
 int BitmapHeader::height() const             { return biHeight_; }
 int BitmapHeader::bit_count() const          { return biBitCount_; }
@@ -290,10 +400,13 @@ void BitmapBase::clear_error()
 // functions for BitmapWriter, BitmapReader, BitmapPalette, RGBPalette
 namespace {
 
+// (unsigned char)(fmin(fmax(f, 0.0), 1.0)*255), NaN to 0; clamped after
+// the conversion to int so that loops over it are vectorised
 template <typename T>
 inline unsigned char f2u(T f)
 {
-    return (unsigned char)(fmin(fmax(f, 0.0), 1.0)*255);
+    const double v = f*255.0;
+    return (unsigned char)(v >= 0.0 ? (v < 255.0 ? (int)v : 255) : 0);
 }
     
     
@@ -318,37 +431,16 @@ void pixel2rgb(const unsigned char *p, T *r, T *g, T *b)
 template void pixel2rgb(const unsigned char *p, float *r, float *g, float *b);
 template void pixel2rgb(const unsigned char *p, double *r, double *g, double *b);
 
-void rgb2pixel(const unsigned char *r, const unsigned char *g, const unsigned char *b,
-               unsigned char *p)
-{
-    *p     = *b;    
-    *(p+1) = *g;    
-    *(p+2) = *r;
-}
-
-template <typename T>
-void rgb2pixel(const T *r, const T *g, const T *b, unsigned char *p)
+void rgbline2pixelline(int n, const unsigned char *r, const unsigned char *g, const unsigned char *b,
+                       int bc, unsigned char *p, unsigned char * /* work */)
 {
-//     *p     = (unsigned char)(fmin(fmax((*b), 0.0), 1.0)*255);
-//     *(p+1) = (unsigned char)(fmin(fmax((*g), 0.0), 1.0)*255);
-//     *(p+2) = (unsigned char)(fmin(fmax((*r), 0.0), 1.0)*255);    
-
-//     *p     = *b <= 0.0 ? 0 : (*b >= 1.0 ? 255 : (unsigned char)(*b*255));
-//     *(p+1) = *g <= 0.0 ? 0 : (*g >= 1.0 ? 255 : (unsigned char)(*g*255));
-//     *(p+2) = *r <= 0.0 ? 0 : (*r >= 1.0 ? 255 : (unsigned char)(*r*255));
-
-//     const int bi = (int)(*b * 255); *p     = bi < 0 ? 0 : (bi > 255 ? 255 : (unsigned char)bi);
-//     const int gi = (int)(*g * 255); *(p+1) = gi < 0 ? 0 : (gi > 255 ? 255 : (unsigned char)gi);
-//     const int ri = (int)(*r * 255); *(p+2) = ri < 0 ? 0 : (ri > 255 ? 255 : (unsigned char)ri);
-    
-    *p     = f2u(*b);
-    *(p+1) = f2u(*g);
-    *(p+2) = f2u(*r);
+    for (int i=0; i<n; i++) {
+        p[bc*i  ] = b[i];
+        p[bc*i+1] = g[i];
+        p[bc*i+2] = r[i];
+    }
 }
 
-template void rgb2pixel(const float *r, const float *g, const float *b, unsigned char *p);
-template void rgb2pixel(const double *r, const double *g, const double *b, unsigned char *p);
-
 
 
 void pixelline2array(int n, const unsigned char *p, unsigned char *a)
@@ -376,13 +468,53 @@ template <typename T>
 void array2pixelline(int n, const T *a, unsigned char *p)
 {
     for (int i=0; i<n; i++) {
-        p[i] = (unsigned char)(fmin(fmax((a[i]), 0.0), 1.0)*255);
+        p[i] = f2u(a[i]);
     }
 }
 
 template void array2pixelline(int n, const float *a, unsigned char *p);
 template void array2pixelline(int n, const double *a, unsigned char *p);
 
+// work: 3n bytes; each channel is converted by array2pixelline, then interleaved
+template <typename T>
+void rgbline2pixelline(int n, const T *r, const T *g, const T *b, int bc, unsigned char *p, unsigned char *work)
+{
+    array2pixelline(n, r, &work[0  ]);
+    array2pixelline(n, g, &work[n  ]);
+    array2pixelline(n, b, &work[2*n]);
+    rgbline2pixelline(n, &work[0], &work[n], &work[2*n], bc, p, NULL);
+}
+
+template void rgbline2pixelline(int n, const float *r, const float *g, const float *b, int bc, unsigned char *p, unsigned char *work);
+template void rgbline2pixelline(int n, const double *r, const double *g, const double *b, int bc, unsigned char *p, unsigned char *work);
+
+
+
+// Entries of a table of nmax+1 colors for vmin + (vmax - vmin)*k/nmax, rounded
+template <typename T>
+void array2lutindex(int n, const T *a, double vmin, double vmax, int nmax, int *k)
+{
+    const double scale = vmax > vmin ? nmax/(vmax - vmin) : 0.0;
+    for (int i=0; i<n; i++) {
+        const double v = (a[i] - vmin)*scale + 0.5;
+        k[i] = v >= 0.0 ? (v < nmax ? (int)v : nmax) : 0;
+    }
+}
+
+template void array2lutindex(int n, const float *a, double vmin, double vmax, int nmax, int *k);
+template void array2lutindex(int n, const double *a, double vmin, double vmax, int nmax, int *k);
+
+// lut: RGBQUAD
+void lutindex2pixelline(int n, const int *k, const unsigned char *lut, int bc, unsigned char *p)
+{
+    for (int i=0; i<n; i++) {
+        const unsigned char *c = &lut[4*k[i]];
+        p[bc*i  ] = c[0];
+        p[bc*i+1] = c[1];
+        p[bc*i+2] = c[2];
+    }
+}
+
 
 } // namespace
 
@@ -390,12 +522,12 @@ template void array2pixelline(int n, const double *a, unsigned char *p);
 
 
 BitmapWriter::BitmapWriter()
-    : BitmapBase()
+    : BitmapBase(), direct_(false)
 {
 }
 
 BitmapWriter::BitmapWriter(const char *file)
-    : BitmapBase(file)
+    : BitmapBase(file), direct_(false)
 {
 }
 
@@ -403,6 +535,72 @@ BitmapWriter::~BitmapWriter()
 {
 }
 
+void BitmapWriter::set_direct_io(bool direct) { direct_ = direct; }
+
+namespace {
+
+const size_t image_alignment = 4096;
+
+} // namespace
+
+unsigned char *BitmapWriter::allocate_image() const
+{
+    const size_t size = header_->total_data_size();
+    const size_t cap  = (size + image_alignment - 1)/image_alignment*image_alignment;
+    
+    void *image = NULL;
+    if (posix_memalign(&image, image_alignment, cap) != 0) return NULL;
+
+    // header, and zeros after the last row up to the alignment
+    header_->write((unsigned char *)image);
+    memset((unsigned char *)image + size, 0, cap - size);
+    return (unsigned char *)image;
+}
+
+bool BitmapWriter::write_image(unsigned char *image) const
+{
+    const size_t size  = header_->total_data_size();
+    const int    flags = O_WRONLY | O_CREAT | O_TRUNC;
+
+    int  fd     = -1;
+    bool direct = false;
+#ifdef O_DIRECT
+    if (direct_) {
+        fd = ::open(file_, flags | O_DIRECT, 0666);
+        direct = fd >= 0;
+    }
+#endif
+    if (fd < 0) fd = ::open(file_, flags, 0666);
+    if (fd < 0) {
+        free(image);
+        return false;
+    }
+
+    // O_DIRECT writes whole blocks; the file is cut to its size afterwards
+    const size_t n = direct ? (size + image_alignment - 1)/image_alignment*image_alignment : size;
+    size_t done = 0;
+    while (done < n) {
+        const ssize_t ret = pwrite(fd, image + done, n - done, done);
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret < 0 && direct && done == 0) {
+            // O_DIRECT not supported by the file system
+            ::close(fd);
+            fd = ::open(file_, flags, 0666);
+            if (fd < 0) break;
+            direct = false;
+            continue;
+        }
+        if (ret <= 0) break;
+        done += ret;
+    }
+    bool ok = fd >= 0 && done >= size;
+    if (ok && direct && ftruncate(fd, size) != 0) ok = false;
+    if (fd >= 0) ::close(fd);
+
+    free(image);
+    return ok;
+}
+
 template int BitmapWriter::write_rgb(int,  int ,
                                      const unsigned char *, const unsigned char *, const unsigned char *,
                                      int);
@@ -424,33 +622,28 @@ int BitmapWriter::write_rgb(int width, int height,
     
     header_->set(width, height, bit_count, NULL);
 
-    FILE *fp = fopen(file_, "w");
-    if (fp == NULL) return -5;
-
-    header_->write(fp);
+    unsigned char *image = allocate_image();
+    if (image == NULL) return -1;
 
     // write data
-    size_t len = header_->linesize();
-
-    unsigned char* line = new unsigned char[len];
-    if (line == NULL) return -1;
-    memset(line, 0, len);
+    const size_t len = header_->linesize();
+    const size_t off = header_->image_offset();
 
     const int h = abs(height);
     const int w = width;
 
+    unsigned char* work = new unsigned char[3*w];
+
     const int bc = header_->bit_count() / 8; // 3 or 4
     for (int j=0; j<h; j++) {
-        for (int i=0; i<w; i++) {            
-            const int id = j*w + i;
-            rgb2pixel(&r[id], &g[id], &b[id], &line[bc*i]);
-        }
-        fwrite(line, sizeof(unsigned char), len, fp);
+        const int id = j*w;
+        unsigned char *line = &image[off + j*len];
+        memset(line, 0, len);
+        rgbline2pixelline(w, &r[id], &g[id], &b[id], bc, line, work);
     }
 
-    delete [] line; line = NULL;
-    fclose(fp);
-    return w*h;
+    delete [] work; work = NULL;
+    return write_image(image) ? w*h : -5;
 }
 
 //template int BitmapWriter::write_rgb(int , int , const unsigned char *, const RGBPalette &, int);
@@ -465,21 +658,36 @@ int BitmapWriter::write_rgb(int width, int height, const T *p, T pmin, T pmax,
 
     if (header_->bit_count_is_supported(bit_count)         != 2    ) return -3;
     if (header_->width_height_are_supported(width, height) == false) return -4;
+
+    // The palette is sampled at RGB_LUT_SIZE points (the color of p is
+    // that of the nearest point) instead of being evaluated per pixel
+    unsigned char *lut = new unsigned char[4*RGB_LUT_SIZE];
+    palette.generate_bitmap_rgbquad_palette(RGB_LUT_SIZE, lut);
     
-    const int n = width * height;
-    T *r = new T[n];
-    T *g = new T[n];
-    T *b = new T[n];
+    header_->set(width, height, bit_count, NULL);
+
+    unsigned char *image = allocate_image();
+    if (image == NULL) { delete [] lut; return -1; }
 
-    for (int i=0; i<n; i++) palette.rgb(p[i], pmin, pmax, &r[i], &g[i], &b[i]);
+    // write data
+    const size_t len = header_->linesize();
+    const size_t off = header_->image_offset();
 
-    int ret = write_rgb(width, height, r, g, b, bit_count);
+    const int h = abs(height);
+    const int w = width;
+    int *k = new int[w];
 
-    delete [] r; r = NULL;
-    delete [] g; g = NULL;
-    delete [] b; b = NULL;
+    const int bc = header_->bit_count() / 8; // 3 or 4
+    for (int j=0; j<h; j++) {
+        unsigned char *line = &image[off + j*len];
+        memset(line, 0, len);
+        array2lutindex(w, &p[j*w], pmin, pmax, RGB_LUT_SIZE - 1, k);
+        lutindex2pixelline(w, k, lut, bc, line);
+    }
 
-    return ret;
+    delete [] k;    k    = NULL;
+    delete [] lut;  lut  = NULL;
+    return write_image(image) ? w*h : -5;
 }
 
 //template int BitmapWriter::write_rgb(int , int , const unsigned char *, const RGBPalette &, int);
@@ -498,8 +706,8 @@ int BitmapWriter::write_rgb(int width, int height, const T *p, const RGBPalette
     T pmin = p[0];
     T pmax = p[0];
     for (int i=0; i<n; i++) {
-        pmin = fmin(p[i], pmin);
-        pmax = fmax(p[i], pmax);
+        pmin = p[i] < pmin ? p[i] : pmin;
+        pmax = p[i] > pmax ? p[i] : pmax;
     }
 
     return write_rgb(width, height, p, pmin, pmax, palette, bit_count);
@@ -520,29 +728,23 @@ int BitmapWriter::write_8bit(int width, int height, const T *p, const unsigned c
     
     header_->set(width, height, bit_count, palette);
 
-    FILE *fp = fopen(file_, "w");
-    if (fp == NULL) return -5;
-
-    header_->write(fp);
+    unsigned char *image = allocate_image();
+    if (image == NULL) return -1;
 
     // write data
-    size_t len = header_->linesize();
-
-    unsigned char* line = new unsigned char[len];
-    if (line == NULL) return -1;
-    memset(line, 0, len);
+    const size_t len = header_->linesize();
+    const size_t off = header_->image_offset();
 
     const int h = abs(height);
     const int w = width;
 
     for (int j=0; j<h; j++) {
+        unsigned char *line = &image[off + j*len];
+        memset(&line[w], 0, len - w);
         array2pixelline(w, &p[j*w], line);
-        fwrite(line, sizeof(unsigned char), len, fp);    
     }
 
-    delete [] line; line = NULL;
-    fclose(fp);
-    return w*h;
+    return write_image(image) ? w*h : -5;
 }
 
 
@@ -560,22 +762,25 @@ int BitmapWriter::write_8bit(int width, int height, const T *p, const BitmapPale
 
 
 BitmapReader::BitmapReader()
-    : BitmapBase()
+    : BitmapBase(), map_(NULL), map_size_(0)
 {   
 }
 
 BitmapReader::BitmapReader(const char *file)
-    : BitmapBase(file)
+    : BitmapBase(file), map_(NULL), map_size_(0)
 {
     open(file);
 }
 
 BitmapReader::~BitmapReader()
 {
+    close();
 }
 
 bool BitmapReader::open(const char *file)
 {
+    close();
+    if (! BitmapBase::open(file)) return false;
     if (is_failure()) return false;
     if (! read_header()) {
         set_error();
@@ -584,19 +789,49 @@ bool BitmapReader::open(const char *file)
     return true;
 }
 
+void BitmapReader::close()
+{
+    if (map_ != NULL) munmap((void *)map_, map_size_);
+    map_      = NULL;
+    map_size_ = 0;
+}
+
 bool BitmapReader::read_header()
 {
     if (is_failure()) return false;
 
-    FILE *fp = fopen(file_, "r");
-    if (fp == NULL) return false;
+    const int fd = ::open(file_, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
     
-    header_->read(fp);
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+
+    map_      = (const unsigned char *)map;
+    map_size_ = st.st_size;
+    
+    if (! header_->read(map_, map_size_)) return false;
+
+    // all the rows must be in the file
+    const size_t h = abs(header_->height());
+    if (header_->image_offset() + h*header_->linesize() > map_size_) return false;
 
-    fclose(fp); fp = NULL;
     return true;
 }
 
+const unsigned char *BitmapReader::row(int j) const
+{
+    if (map_ == NULL || ! header_->is_bitmap()) return NULL;
+    if (j < 0 || j >= abs(header_->height()))   return NULL;
+    return map_ + header_->image_offset() + j*header_->linesize();
+}
+
 template int BitmapReader::read_rgb(int, unsigned char *, unsigned char *, unsigned char *);
 template int BitmapReader::read_rgb(int, float *, float *, float *);
 template int BitmapReader::read_rgb(int, double *, double *, double *);
@@ -614,26 +849,15 @@ int BitmapReader::read_rgb(int size, T *r, T *g, T *b)
 
     if (size < w*h) return 0;
 
-    FILE *fp = fopen(file_, "r");
-    if (fp == NULL) return -5;
-
-    fseek(fp, header_->image_offset(), SEEK_SET);
-
-    size_t len = header_->linesize();
-    unsigned char* line = new unsigned char[len];
-
     const int bc = header_->bit_count()/8; // 3 or 4
     for (int j=0; j<h; j++) {
-        fread(line, sizeof(unsigned char), len, fp);
+        const unsigned char *line = row(j);
         for (int i=0; i<w; i++) {
             const int id = j*w + i;
             pixel2rgb(&line[bc*i], &r[id], &g[id], &b[id]);
         }
     }
 
-    delete [] line;
-    fclose(fp);
-
     return w*h;
 }
 
@@ -657,25 +881,531 @@ int BitmapReader::read_8bit(int size, T *p, unsigned char *palette)
 
     if (palette) memcpy(palette, header_->palette(), palette_size());
     
-    FILE *fp = fopen(file_, "r");
+    for (int j=0; j<h; j++) {
+        pixelline2array(w, row(j), &p[j*w]);
+    }
+
+    return w*h;
+}
+
+
+
+
+
+
+
+// functions for PngWriter (deflate with the fixed Huffman codes, zlib and PNG chunks)
+namespace {
+
+class BitStream {
+public:
+    explicit BitStream(std::vector<unsigned char> &out) : out_(out), bits_(0), nbits_(0) {}
+
+    // n bits of v, LSB first
+    void put(uint32_t v, int n)
+    {
+        bits_  |= v << nbits_;
+        nbits_ += n;
+        while (nbits_ >= 8) {
+            out_.push_back((unsigned char)bits_);
+            bits_  >>= 8;
+            nbits_  -= 8;
+        }
+    }
+
+    // Huffman code of n bits, MSB first
+    void put_code(uint32_t code, int n)
+    {
+        uint32_t r = 0;
+        for (int i=0; i<n; i++) { r = (r << 1) | ((code >> i) & 1); }
+        put(r, n);
+    }
+
+    void align() { if (nbits_ > 0) put(0, 8 - nbits_); }
+
+private:
+    std::vector<unsigned char> &out_;
+    uint32_t bits_;
+    int nbits_;
+};
+
+const int length_base [29] = {   3,   4,   5,   6,   7,   8,   9,  10,  11,  13,  15,  17,  19,  23,  27,
+                                31,  35,  43,  51,  59,  67,  83,  99, 115, 131, 163, 195, 227, 258 };
+const int length_extra[29] = {   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,   2,   2,   2,
+                                 2,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   0 };
+const int dist_base   [30] = {   1,    2,    3,    4,    5,    7,    9,   13,    17,    25,    33,    49,    65,    97,   129,
+                               193,  257,  385,  513,  769, 1025, 1537, 2049, 3073,  4097,  6145,  8193, 12289, 16385, 24577 };
+const int dist_extra  [30] = {   0,    0,    0,    0,    1,    1,    2,    2,    3,     3,     4,     4,     5,     5,     6,
+                                 6,    7,    7,    8,    8,    9,    9,   10,   10,    11,    11,    12,    12,    13,    13 };
+
+void put_literal(BitStream &bs, int v)
+{
+    if      (v < 144) bs.put_code(0x30  +  v       , 8);
+    else if (v < 256) bs.put_code(0x190 + (v - 144), 9);
+    else if (v < 280) bs.put_code(         v - 256 , 7);
+    else              bs.put_code(0xc0  + (v - 280), 8);
+}
+
+void put_match(BitStream &bs, int len, int dist)
+{
+    int l = 28;
+    while (length_base[l] > len) l--;
+    put_literal(bs, 257 + l);
+    bs.put(len - length_base[l], length_extra[l]);
+
+    int d = 29;
+    while (dist_base[d] > dist) d--;
+    bs.put_code(d, 5);
+    bs.put(dist - dist_base[d], dist_extra[d]);
+}
+
+inline uint32_t hash3(const unsigned char *p)
+{
+    return (((uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2]) * 2654435761u) >> (32 - 15);
+}
+
+// stored (uncompressed) blocks of at most 65535 bytes
+void store_band(const unsigned char *src, int n, bool last, std::vector<unsigned char> &out)
+{
+    int i = 0;
+    do {
+        const int  len   = std::min(n - i, 65535);
+        const bool final = last && i + len == n;
+        const unsigned char head[5] = { (unsigned char)(final ? 1 : 0),
+                                        (unsigned char)(len      ), (unsigned char)(len >> 8),
+                                        (unsigned char)(~len     ), (unsigned char)(~len >> 8) };
+        out.insert(out.end(), head, head + 5);
+        out.insert(out.end(), src + i, src + i + len);
+        i += len;
+    } while (i < n);
+}
+
+/**
+ * @brief deflate one band by itself (LZ77 with hash chains, fixed Huffman codes)
+ *
+ * The output ends on a byte boundary; unless it is the last band an
+ * empty stored block is appended, so the bands can be concatenated.
+ * A band which does not shrink is stored instead.
+ */
+void deflate_band(const unsigned char *src, int n, bool last, std::vector<unsigned char> &out)
+{
+    const int window    = 32768;
+    const int max_chain = 32;
+    const int min_match = 3;
+    const int max_match = 258;
+    
+    std::vector<int> head(1 << 15, -1);
+    std::vector<int> prev(n > 0 ? n : 1);
+    BitStream bs(out);
+    
+    bs.put(last ? 1 : 0, 1);
+    bs.put(1, 2);
+
+    int i = 0;
+    while (i < n) {
+        int best_len  = 0;
+        int best_dist = 0;
+        if (i + min_match <= n) {
+            const uint32_t h = hash3(&src[i]);
+            const int limit = std::min(max_match, n - i);
+            int cand  = head[h];
+            int chain = max_chain;
+            while (cand >= 0 && i - cand <= window && chain-- > 0) {
+                if (src[cand + best_len] == src[i + best_len]) {
+                    int len = 0;
+                    while (len < limit && src[cand + len] == src[i + len]) len++;
+                    if (len > best_len) {
+                        best_len  = len;
+                        best_dist = i - cand;
+                        if (len == limit) break;
+                    }
+                }
+                cand = prev[cand];
+            }
+            prev[i] = head[h];
+            head[h] = i;
+        }
+
+        if (best_len >= min_match) {
+            put_match(bs, best_len, best_dist);
+            for (int k=i+1; k<i+best_len && k+min_match<=n; k++) {
+                const uint32_t h = hash3(&src[k]);
+                prev[k] = head[h];
+                head[h] = k;
+            }
+            i += best_len;
+        } else {
+            put_literal(bs, src[i]);
+            i++;
+        }
+    }
+    put_literal(bs, 256);
+
+    if (last) {
+        bs.align();
+    } else {
+        bs.put(0, 3);
+        bs.align();
+        const unsigned char stored[4] = { 0x00, 0x00, 0xff, 0xff };
+        out.insert(out.end(), stored, stored + 4);
+    }
+
+    if (out.size() > (size_t)n + 5*(n/65535 + 1)) {
+        out.clear();
+        store_band(src, n, last, out);
+    }
+}
+
+uint32_t adler32(const unsigned char *p, size_t n)
+{
+    uint32_t a = 1, b = 0;
+    while (n > 0) {
+        const size_t m = std::min(n, (size_t)5552);
+        for (size_t i=0; i<m; i++) {
+            a += p[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        p += m;
+        n -= m;
+    }
+    return (b << 16) | a;
+}
+
+// Adler-32 of the concatenation, from that of the parts (as zlib adler32_combine)
+uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2)
+{
+    const uint32_t base = 65521;
+    const uint32_t rem  = len2 % base;
+    uint32_t sum1 = adler1 & 0xffff;
+    uint32_t sum2 = (rem * sum1) % base;
+    sum1 += (adler2 & 0xffff) + base - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + base - rem;
+    if (sum1 >= base) sum1 -= base;
+    if (sum1 >= base) sum1 -= base;
+    if (sum2 >= (base << 1)) sum2 -= (base << 1);
+    if (sum2 >= base) sum2 -= base;
+    return sum1 | (sum2 << 16);
+}
+
+struct Crc32Table {
+    uint32_t t[256];
+    Crc32Table()
+    {
+        for (uint32_t n=0; n<256; n++) {
+            uint32_t c = n;
+            for (int k=0; k<8; k++) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+    }
+};
+
+const Crc32Table crc32_table;
+
+uint32_t crc32_update(uint32_t crc, const unsigned char *p, size_t n)
+{
+    for (size_t i=0; i<n; i++) crc = crc32_table.t[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+void put_be32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >>  8);
+    p[3] = (unsigned char)(v      );
+}
+
+void write_chunk(FILE *fp, const char *type, const unsigned char *data, size_t n)
+{
+    unsigned char be[4];
+    put_be32(be, (uint32_t)n);
+    fwrite(be, 1, 4, fp);
+    fwrite(type, 1, 4, fp);
+    if (n > 0) fwrite(data, 1, n, fp);
+    
+    uint32_t crc = crc32_update(0xffffffffu, (const unsigned char *)type, 4);
+    crc = crc32_update(crc, data, n);
+    put_be32(be, crc ^ 0xffffffffu);
+    fwrite(be, 1, 4, fp);
+}
+
+template <typename T>
+struct PngBand {
+    const T *p;
+    int width, height; // height < 0: rows from the top
+    int row0, nrows;   // image rows from the top
+    bool last;
+    std::vector<unsigned char> out;
+    uint32_t adler;
+    size_t   raw;
+};
+
+template <typename T>
+struct PngQueue {
+    pthread_mutex_t mutex;
+    std::vector<PngBand<T> > *bands;
+    int next;
+};
+
+template <typename T>
+void encode_png_band(PngBand<T> &b)
+{
+    const int w = b.width;
+    const int h = abs(b.height);
+    std::vector<unsigned char> raw((size_t)(w + 1)*b.nrows);
+    for (int r=0; r<b.nrows; r++) {
+        const int j = b.height > 0 ? h - 1 - (b.row0 + r) : b.row0 + r;
+        unsigned char *line = &raw[(size_t)(w + 1)*r];
+        line[0] = 0; // filter: none
+        array2pixelline(w, &b.p[(size_t)j*w], line + 1);
+    }
+    b.raw   = raw.size();
+    b.adler = adler32(&raw[0], raw.size());
+    deflate_band(&raw[0], (int)raw.size(), b.last, b.out);
+}
+
+template <typename T>
+void *encode_png_thread(void *arg)
+{
+    PngQueue<T> *q = (PngQueue<T> *)arg;
+    for (;;) {
+        pthread_mutex_lock(&q->mutex);
+        const int k = q->next++;
+        pthread_mutex_unlock(&q->mutex);
+        if (k >= (int)q->bands->size()) break;
+        encode_png_band((*q->bands)[k]);
+    }
+    return NULL;
+}
+
+} // namespace
+
+
+
+
+PngWriter::PngWriter()
+    : file_(NULL)
+{
+}
+
+PngWriter::PngWriter(const char *file)
+    : file_(file)
+{
+}
+
+PngWriter::~PngWriter()
+{
+}
+
+void PngWriter::open(const char *file) { file_ = file; }
+const char *PngWriter::file_name() const { return file_; }
+
+template int PngWriter::write_8bit(int , int , const unsigned char *, const unsigned char *, int);
+template int PngWriter::write_8bit(int , int , const float *, const unsigned char *, int);
+template int PngWriter::write_8bit(int , int , const double *, const unsigned char *, int);
+
+template <typename T>
+int PngWriter::write_8bit(int width, int height, const T *p, const unsigned char *palette, int nthreads)
+{
+    if (file_ == NULL) return -2;
+
+    const int h = abs(height);
+    const int w = width;
+    if (w <= 0 || h <= 0) return -4;
+    
+    if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads <= 0) nthreads = 1;
+
+    // bands of about 128 KiB of raw data, at least one per thread
+    int rows = (131072 + w)/(w + 1);
+    rows = std::min(rows, (h + nthreads - 1)/nthreads);
+    rows = std::max(rows, 1);
+    const int nbands = (h + rows - 1)/rows;
+
+    std::vector<PngBand<T> > bands(nbands);
+    for (int b=0; b<nbands; b++) {
+        bands[b].p      = p;
+        bands[b].width  = w;
+        bands[b].height = height;
+        bands[b].row0   = b*rows;
+        bands[b].nrows  = std::min(rows, h - b*rows);
+        bands[b].last   = b == nbands - 1;
+    }
+
+    PngQueue<T> queue;
+    pthread_mutex_init(&queue.mutex, NULL);
+    queue.bands = &bands;
+    queue.next  = 0;
+    nthreads = std::min(nthreads, nbands);
+    std::vector<pthread_t> threads(nthreads);
+    for (int t=1; t<nthreads; t++) {
+        pthread_create(&threads[t], NULL, encode_png_thread<T>, &queue);
+    }
+    encode_png_thread<T>(&queue);
+    for (int t=1; t<nthreads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    pthread_mutex_destroy(&queue.mutex);
+
+    FILE *fp = fopen(file_, "wb");
     if (fp == NULL) return -5;
 
-    fseek(fp, header_->image_offset(), SEEK_SET);
+    const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    fwrite(signature, 1, 8, fp);
+
+    unsigned char ihdr[13];
+    put_be32(&ihdr[0], w);
+    put_be32(&ihdr[4], h);
+    ihdr[8]  = 8; // bit depth
+    ihdr[9]  = 3; // indexed color
+    ihdr[10] = 0;
+    ihdr[11] = 0;
+    ihdr[12] = 0;
+    write_chunk(fp, "IHDR", ihdr, sizeof(ihdr));
+
+    unsigned char plte[256*3];
+    for (int k=0; k<256; k++) {
+        plte[3*k    ] = palette[4*k + 2];
+        plte[3*k + 1] = palette[4*k + 1];
+        plte[3*k + 2] = palette[4*k    ];
+    }
+    write_chunk(fp, "PLTE", plte, sizeof(plte));
+
+    // one IDAT: zlib header, the bands, Adler-32
+    size_t   size  = 2 + 4;
+    uint32_t adler = 1;
+    for (int b=0; b<nbands; b++) {
+        size += bands[b].out.size();
+        adler = b == 0 ? bands[b].adler : adler32_combine(adler, bands[b].adler, bands[b].raw);
+    }
+    const unsigned char zhead[2] = { 0x78, 0x01 };
+    unsigned char be[4];
+    put_be32(be, (uint32_t)size);
+    fwrite(be, 1, 4, fp);
+    fwrite("IDAT", 1, 4, fp);
+    fwrite(zhead, 1, 2, fp);
+    uint32_t crc = crc32_update(0xffffffffu, (const unsigned char *)"IDAT", 4);
+    crc = crc32_update(crc, zhead, 2);
+    for (int b=0; b<nbands; b++) {
+        fwrite(&bands[b].out[0], 1, bands[b].out.size(), fp);
+        crc = crc32_update(crc, &bands[b].out[0], bands[b].out.size());
+    }
+    put_be32(be, adler);
+    fwrite(be, 1, 4, fp);
+    crc = crc32_update(crc, be, 4);
+    put_be32(be, crc ^ 0xffffffffu);
+    fwrite(be, 1, 4, fp);
 
-    size_t len = header_->linesize();
-    unsigned char* line = new unsigned char[len];
+    write_chunk(fp, "IEND", NULL, 0);
 
-    for (int j=0; j<h; j++) {
-        fread(line, sizeof(unsigned char), len, fp);
-        pixelline2array(w, line, &p[j*w]);
+    const bool failed = ferror(fp) != 0;
+    fclose(fp);
+    return failed ? -5 : w*h;
+}
+
+template int PngWriter::write_8bit(int , int , const unsigned char *, const BitmapPalette &, int);
+template int PngWriter::write_8bit(int , int , const float *, const BitmapPalette &, int);
+template int PngWriter::write_8bit(int , int , const double *, const BitmapPalette &, int);
+
+template <typename T>
+int PngWriter::write_8bit(int width, int height, const T *p, const BitmapPalette &palette, int nthreads)
+{
+    return write_8bit(width, height, p, palette.data(), nthreads);
+}
+
+
+
+
+Y4MWriter::Y4MWriter()
+    : fp_(NULL), is_pipe_(false), width_(0), height_(0), plane_(NULL)
+{
+}
+
+Y4MWriter::~Y4MWriter()
+{
+    close();
+}
+
+bool Y4MWriter::open(const char *stream, int width, int height, int fps)
+{
+    close();
+    if (width <= 0 || height == 0 || fps <= 0) return false;
+
+    is_pipe_ = stream[0] == '|';
+    fp_ = is_pipe_ ? popen(stream + 1, "w") : fopen(stream, "wb");
+    if (fp_ == NULL) return false;
+
+    width_  = width;
+    height_ = height;
+    plane_  = new unsigned char[(size_t)3*width*abs(height)];
+    fprintf(fp_, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, abs(height), fps);
+    return true;
+}
+
+void Y4MWriter::close()
+{
+    if (fp_ != NULL) {
+        if (is_pipe_) pclose(fp_); else fclose(fp_);
+        fp_ = NULL;
+    }
+    delete [] plane_;
+    plane_ = NULL;
+}
+
+bool Y4MWriter::is_open() const { return fp_ != NULL; }
+
+template int Y4MWriter::write_8bit(const unsigned char *, const unsigned char *);
+template int Y4MWriter::write_8bit(const float *, const unsigned char *);
+template int Y4MWriter::write_8bit(const double *, const unsigned char *);
+
+template <typename T>
+int Y4MWriter::write_8bit(const T *p, const unsigned char *palette)
+{
+    if (fp_ == NULL) return -2;
+
+    // palette (RGBQUAD) to studio-range BT.601 Y'CbCr
+    unsigned char yuv[256][3];
+    for (int k=0; k<256; k++) {
+        const double b = palette[4*k], g = palette[4*k + 1], r = palette[4*k + 2];
+        yuv[k][0] = (unsigned char)lround( 16.0 + 0.257*r + 0.504*g + 0.098*b);
+        yuv[k][1] = (unsigned char)lround(128.0 - 0.148*r - 0.291*g + 0.439*b);
+        yuv[k][2] = (unsigned char)lround(128.0 + 0.439*r - 0.368*g - 0.071*b);
     }
 
+    const int w = width_;
+    const int h = abs(height_);
+    const size_t n = (size_t)w*h;
+    unsigned char* line = new unsigned char[w];
+    for (int r=0; r<h; r++) {
+        const int j = height_ > 0 ? h - 1 - r : r;
+        array2pixelline(w, &p[(size_t)j*w], line);
+        for (int i=0; i<w; i++) {
+            const size_t id = (size_t)r*w + i;
+            plane_[id      ] = yuv[line[i]][0];
+            plane_[id +   n] = yuv[line[i]][1];
+            plane_[id + 2*n] = yuv[line[i]][2];
+        }
+    }
     delete [] line;
-    fclose(fp);
 
+    fputs("FRAME\n", fp_);
+    if (fwrite(plane_, 1, 3*n, fp_) != 3*n) return -5;
+    fflush(fp_);
     return w*h;
 }
 
+template int Y4MWriter::write_8bit(const unsigned char *, const BitmapPalette &);
+template int Y4MWriter::write_8bit(const float *, const BitmapPalette &);
+template int Y4MWriter::write_8bit(const double *, const BitmapPalette &);
+
+template <typename T>
+int Y4MWriter::write_8bit(const T *p, const BitmapPalette &palette)
+{
+    return write_8bit(p, palette.data());
+}
+
 
 
 
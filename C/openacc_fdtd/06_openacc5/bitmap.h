@@ -49,6 +49,12 @@ public:
     bool set(int width, int height, int bit_count, const unsigned char *palette);
     bool read(FILE *fp);
     bool write(FILE *fp) const;
+    bool read(const unsigned char *buf, size_t size);
+    /**
+     * @brief serialize the header and the palette (image_offset() bytes)
+     * @return number of bytes written, 0 on failure
+     */
+    size_t write(unsigned char *buf) const;
     
     int width() const;
     int height() const;
@@ -168,6 +174,9 @@ private:
 class BitmapPalette;
 class RGBPalette;
 
+//! number of colors sampled from an RGBPalette by BitmapWriter::write_rgb
+#define RGB_LUT_SIZE 4096
+
 /**
  * @brief Bitmap Writer
  * 
@@ -183,7 +192,7 @@ public:
     // 0.0 <= r, g, b, <= 1.0
     template <typename T>
     int write_rgb(int width, int height, const T *r, const T *g, const T *b, int bit_count = 24);
-    // pmin <= p <= pmax
+    // pmin <= p <= pmax, colors from a table of RGB_LUT_SIZE entries
     template <typename T>
     int write_rgb(int width, int height, const T *p, T pmin, T pmax,
                   const RGBPalette &palette, int bit_count = 24);
@@ -197,6 +206,21 @@ public:
     // 0.0 <= p <= 1.0
     template <typename T>
     int write_8bit(int width, int height, const T *p, const BitmapPalette &palette);
+
+    /**
+     * @brief write with O_DIRECT (bypassing the page cache) where supported
+     *
+     * The whole file is always assembled in one page-aligned buffer and
+     * written by a single pwrite().
+     */
+    void set_direct_io(bool direct);
+
+private:
+    unsigned char *allocate_image() const;
+    bool write_image(unsigned char *image) const;
+
+private:
+    bool direct_;
     
 private:
     // Disallow the copy constructor and assignment operator
@@ -221,16 +245,31 @@ public:
     ~BitmapReader();
 
 public:
+    // the file is mapped into memory until close()
     bool open(const char *file);
+    void close();
     
 private:
     bool read_header();
     
 public:
+    /**
+     * @brief row j of the image data as stored in the file (zero copy)
+     *
+     * Rows are from the bottom when height() > 0, linesize() bytes each
+     * (B, G, R[, 0] or palette indices).  Valid until close().
+     * @retval NULL j is out of range or no file is open
+     */
+    const unsigned char *row(int j) const;
+    
     template <typename T>
     int read_rgb(int size, T *r, T *g, T *b);
     template <typename T>
     int read_8bit(int size, T *p, unsigned char *palette = NULL);
+
+private:
+    const unsigned char *map_;
+    size_t map_size_;
     
 private:
     // Disallow the copy constructor and assignment operator
@@ -356,6 +395,84 @@ private:
 
 
 
+/**
+ * @brief PNG Writer for 8-bit palette images
+ * 
+ * Writes the same data as BitmapWriter::write_8bit (rows from the
+ * bottom, 0.0 <= p <= 1.0, RGBQUAD palette) as an indexed-color PNG.
+ * The rows are cut into bands which are deflated in parallel, each
+ * band ending on a byte boundary, and concatenated into one zlib
+ * stream (the Adler-32 of the bands is combined).
+ */
+class PngWriter {
+public:
+    PngWriter();
+    explicit PngWriter(const char *file);
+    ~PngWriter();
+
+    void open(const char *file);
+    const char *file_name() const;
+    
+    // 0.0 <= p <= 1.0, nthreads = 0: number of online processors
+    template <typename T>
+    int write_8bit(int width, int height, const T *p, const unsigned char *palette, int nthreads = 0);
+    template <typename T>
+    int write_8bit(int width, int height, const T *p, const BitmapPalette &palette, int nthreads = 0);
+
+private:
+    const char *file_;
+    
+private:
+    // Disallow the copy constructor and assignment operator
+    PngWriter(const PngWriter&);
+    void operator=(const PngWriter&);
+};
+
+
+
+/**
+ * @brief YUV4MPEG2 (Y4M) video stream Writer
+ * 
+ * Appends 8-bit palette images as C444 frames to one stream, a file or
+ * the standard input of a command given as "|command", e.g.
+ * "|ffmpeg -y -i - out.mp4".
+ */
+class Y4MWriter {
+public:
+    Y4MWriter();
+    ~Y4MWriter();
+
+    /**
+     * @brief open the stream and write the stream header
+     * @param[in] stream file name, or "|command"
+     * @retval 1 success
+     * @retval 0 failure
+     */
+    bool open(const char *stream, int width, int height, int fps);
+    void close();
+    bool is_open() const;
+    
+    // 0.0 <= p <= 1.0, rows from the bottom
+    template <typename T>
+    int write_8bit(const T *p, const unsigned char *palette);
+    template <typename T>
+    int write_8bit(const T *p, const BitmapPalette &palette);
+
+private:
+    FILE *fp_;
+    bool is_pipe_;
+    int width_;
+    int height_;
+    unsigned char *plane_;
+    
+private:
+    // Disallow the copy constructor and assignment operator
+    Y4MWriter(const Y4MWriter&);
+    void operator=(const Y4MWriter&);
+};
+
+
+
 #endif /* BITMAP_H */
 
 
@@ -0,0 +1,112 @@
+/**
+ * @file bitmap_bench.cc
+ * @brief Throughput of the color mapping of BitmapWriter
+ *
+ * Usage: ./bitmap_bench [width] [height] [repeat]
+ *
+ * Maps a float field to BMP files written to /dev/null and prints
+ * Mpixels/s of each path, next to the per-pixel conversion (fmin/fmax
+ * and RGBPalette::rgb for every pixel) which the library used before.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <sys/time.h>
+#include "bitmap.h"
+
+namespace {
+
+double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec*1.0e-6;
+}
+
+void report(const char *name, int n, int repeat, double elapsed)
+{
+    fprintf(stdout, "%-32s %10.2f Mpixels/s\n", name, 1.0e-6*n*repeat/elapsed);
+}
+
+// The conversions of BitmapWriter before the lookup tables
+int reference_8bit(int w, int h, const float *p, unsigned char *line)
+{
+    for (int j=0; j<h; j++) {
+        for (int i=0; i<w; i++) {
+            line[i] = (unsigned char)(fmin(fmax(p[j*w + i], 0.0), 1.0)*255);
+        }
+    }
+    return w*h;
+}
+
+int reference_rgb(int w, int h, const float *p, float pmin, float pmax, const RGBPalette &palette,
+                  unsigned char *line)
+{
+    for (int j=0; j<h; j++) {
+        for (int i=0; i<w; i++) {
+            float r, g, b;
+            palette.rgb(p[j*w + i], pmin, pmax, &r, &g, &b);
+            line[3*i  ] = (unsigned char)(fmin(fmax(b, 0.0), 1.0)*255);
+            line[3*i+1] = (unsigned char)(fmin(fmax(g, 0.0), 1.0)*255);
+            line[3*i+2] = (unsigned char)(fmin(fmax(r, 0.0), 1.0)*255);
+        }
+    }
+    return w*h;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const int w      = argc > 1 ? atoi(argv[1]) : 4096;
+    const int h      = argc > 2 ? atoi(argv[2]) : 4096;
+    const int repeat = argc > 3 ? atoi(argv[3]) : 3;
+    const int n      = w*h;
+
+    float *p = new float[n];
+    for (int j=0; j<h; j++) {
+        for (int i=0; i<w; i++) {
+            p[j*w + i] = 0.5 + 0.6*sin(0.01*i)*cos(0.013*j);
+        }
+    }
+    unsigned char *line = new unsigned char[3*w];
+
+    BitmapPalette palette(BitmapPalette::SEISMIC);
+    RGBPalette rgbpalette(RGBPalette::HOT_AND_COLD);
+
+    fprintf(stdout, "%d x %d, repeat %d\n", w, h, repeat);
+
+    double t0 = now();
+    for (int r=0; r<repeat; r++) reference_8bit(w, h, p, line);
+    report("8bit, per pixel (reference)", n, repeat, now() - t0);
+
+    t0 = now();
+    for (int r=0; r<repeat; r++) {
+        BitmapWriter writer("/dev/null");
+        writer.write_8bit(w, h, p, palette);
+    }
+    report("BitmapWriter::write_8bit", n, repeat, now() - t0);
+
+    t0 = now();
+    for (int r=0; r<repeat; r++) reference_rgb(w, h, p, 0.0f, 1.0f, rgbpalette, line);
+    report("rgb, per pixel (reference)", n, repeat, now() - t0);
+
+    t0 = now();
+    for (int r=0; r<repeat; r++) {
+        BitmapWriter writer("/dev/null");
+        writer.write_rgb(w, h, p, 0.0f, 1.0f, rgbpalette);
+    }
+    report("BitmapWriter::write_rgb (table)", n, repeat, now() - t0);
+
+    delete [] line;
+    delete [] p;
+
+    return 0;
+}
@@ -17,7 +17,9 @@
 #include <stdio.h>
 #include <mpi.h>
 
-#ifdef USE_FLOAT
+// Fields and coefficients in single precision unless USE_DOUBLE; the time,
+// dt and the phases of the sources are double whatever FLOAT is
+#if defined(USE_FLOAT) || !defined(USE_DOUBLE)
 typedef float FLOAT;
 #define MPI_FLOAT_T MPI_FLOAT
 #else
@@ -30,6 +32,12 @@ struct Range {
     int begin [2];
 };
 
+enum FieldComponent {
+    FIELD_EX = 0,
+    FIELD_EY = 1,
+    FIELD_HZ = 2
+};
+
 struct Constant {
     const FLOAT pi;
     const FLOAT c;
@@ -0,0 +1,249 @@
+/**
+ * @file dft_monitor.c
+ * @brief On-the-fly DFT monitors
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$ 
+ */
+
+#include "dft_monitor.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static int max_int(int a, int b) { return a > b ? a : b; }
+static int min_int(int a, int b) { return a < b ? a : b; }
+
+static void fill_twiddle(struct DFTMonitor *m, int step_begin)
+{
+    const double pi     = constant.pi;
+    const double offset = m->comp == FIELD_HZ ? 0.5 : 0.0;
+    
+    for (int n=0; n<m->nwindow; n++) {
+        const double t = (step_begin + n + offset)*m->dt;
+        for (int f=0; f<m->nfreq; f++) {
+            const double phase = 2.0*pi*fmod(m->freq[f]*t, 1.0);
+            m->twiddle[2*(n*m->nfreq + f) + 0] =  cos(phase)*m->dt;
+            m->twiddle[2*(n*m->nfreq + f) + 1] = -sin(phase)*m->dt;
+        }
+    }
+    m->window_begin = step_begin;
+}
+
+void dft_monitor_init(struct DFTMonitor *m, int comp, const struct Range *region,
+                      int nfreq, const double *freq,
+                      const struct Range *whole, const struct Range *inside, double dt, int nwindow)
+{
+    memset(m, 0, sizeof(struct DFTMonitor));
+
+    m->comp    = comp;
+    m->nfreq   = nfreq;
+    m->region  = *region;
+    m->dt      = dt;
+    m->nwindow = nwindow;
+    m->lnx     = whole->length[0];
+    m->freq    = (double *)malloc(sizeof(double)*nfreq);
+    memcpy(m->freq, freq, sizeof(double)*nfreq);
+
+    for (int d=0; d<2; d++) {
+        const int b = max_int(region->begin[d], inside->begin[d]);
+        const int e = min_int(region->begin[d] + region->length[d], inside->begin[d] + inside->length[d]);
+        m->local.begin [d] = b;
+        m->local.length[d] = max_int(e - b, 0);
+    }
+    m->nlocal = m->local.length[0] * m->local.length[1];
+    m->offset = (m->local.begin[1] - whole->begin[1])*m->lnx + (m->local.begin[0] - whole->begin[0]);
+
+    const int ntw = 2*nwindow*nfreq;
+    const int nacc = nfreq*m->nlocal;
+    m->twiddle = (FLOAT  *)malloc(sizeof(FLOAT )*ntw);
+    m->re      = (double *)calloc(nacc + 1, sizeof(double));
+    m->im      = (double *)calloc(nacc + 1, sizeof(double));
+
+    fill_twiddle(m, 0);
+
+    FLOAT  *twiddle = m->twiddle;
+    double *re      = m->re;
+    double *im      = m->im;
+#pragma acc enter data copyin(twiddle[0:ntw], re[0:nacc], im[0:nacc])
+}
+
+void dft_monitor_free(struct DFTMonitor *m)
+{
+    const int ntw  = 2*m->nwindow*m->nfreq;
+    const int nacc = m->nfreq*m->nlocal;
+    FLOAT  *twiddle = m->twiddle;
+    double *re      = m->re;
+    double *im      = m->im;
+#pragma acc exit data delete(twiddle[0:ntw], re[0:nacc], im[0:nacc])
+
+    free(m->freq);
+    free(m->twiddle);
+    free(m->re);
+    free(m->im);
+    memset(m, 0, sizeof(struct DFTMonitor));
+}
+
+void dft_monitor_update(struct DFTMonitor *m, int step, const FLOAT *field)
+{
+    if (m->nlocal == 0 || m->nfreq == 0) return;
+
+    if (step < m->window_begin || step >= m->window_begin + m->nwindow) {
+        fill_twiddle(m, step);
+        const int ntw = 2*m->nwindow*m->nfreq;
+        FLOAT *twiddle = m->twiddle;
+#pragma acc update device(twiddle[0:ntw])
+    }
+
+    const int nfreq  = m->nfreq;
+    const int nlocal = m->nlocal;
+    const int nx     = m->local.length[0];
+    const int ny     = m->local.length[1];
+    const int lnx    = m->lnx;
+    const int offset = m->offset;
+    const int tw0    = 2*(step - m->window_begin)*nfreq;
+    const FLOAT *twiddle = m->twiddle;
+    double *re       = m->re;
+    double *im       = m->im;
+
+#pragma acc kernels present(twiddle, re, im, field)
+#pragma acc loop independent
+    for (int f=0; f<nfreq; f++) {
+#pragma acc loop independent
+        for (int j=0; j<ny; j++) {
+#pragma acc loop independent
+            for (int i=0; i<nx; i++) {
+                const int    k   = f*nlocal + j*nx + i;
+                const double v   = field[offset + j*lnx + i];
+                re[k] += v*twiddle[tw0 + 2*f + 0];
+                im[k] += v*twiddle[tw0 + 2*f + 1];
+            }
+        }
+    }
+}
+
+void dft_monitors_update_e(struct DFTMonitor *m, int n, int step, const FLOAT *ex, const FLOAT *ey)
+{
+    for (int k=0; k<n; k++) {
+        if (m[k].comp != FIELD_HZ) dft_monitor_update(&m[k], step, m[k].comp == FIELD_EX ? ex : ey);
+    }
+}
+
+void dft_monitors_update_h(struct DFTMonitor *m, int n, int step, const FLOAT *hz)
+{
+    for (int k=0; k<n; k++) {
+        if (m[k].comp == FIELD_HZ) dft_monitor_update(&m[k], step, hz);
+    }
+}
+
+bool dft_monitor_write(const struct DFTMonitor *m, const char *filename)
+{
+    if (m->nfreq == 0) return true;
+
+    int rank = 0;
+    int nprocs = 1;
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if (initialized) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+    }
+
+    const int nfreq  = m->nfreq;
+    const int nlocal = m->nlocal;
+    const int nacc   = nfreq*nlocal;
+    double *re = m->re;
+    double *im = m->im;
+#pragma acc update self(re[0:nacc], im[0:nacc])
+
+    // The local parts of the ranks (begin, length) and their offsets in the gathered accumulators
+    const int mine[4] = { m->local.begin[0], m->local.begin[1], m->local.length[0], m->local.length[1] };
+    int *parts  = NULL;
+    int *counts = NULL;
+    int *displs = NULL;
+    int total   = 0;
+    if (rank == 0) {
+        parts  = (int *)malloc(sizeof(int)*4*nprocs);
+        counts = (int *)malloc(sizeof(int)*nprocs);
+        displs = (int *)malloc(sizeof(int)*nprocs);
+    }
+    if (initialized) {
+        MPI_Gather(mine, 4, MPI_INT, parts, 4, MPI_INT, 0, MPI_COMM_WORLD);
+    } else {
+        memcpy(parts, mine, sizeof(mine));
+    }
+    if (rank == 0) {
+        for (int r=0; r<nprocs; r++) {
+            counts[r] = nfreq*parts[4*r + 2]*parts[4*r + 3];
+            displs[r] = total;
+            total += counts[r];
+        }
+    }
+
+    const double *recv_re = re;
+    const double *recv_im = im;
+    double *recv = NULL;
+    if (initialized) {
+        recv = rank == 0 ? (double *)malloc(sizeof(double)*(2*total + 1)) : NULL;
+        MPI_Gatherv(re, nacc, MPI_DOUBLE, recv, counts, displs, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        MPI_Gatherv(im, nacc, MPI_DOUBLE, rank == 0 ? recv + total : NULL, counts, displs, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        recv_re = recv;
+        recv_im = recv + total;
+    }
+
+    bool ret = true;
+    if (rank == 0) {
+        // Place the parts of the ranks in the whole region; they are disjoint
+        const int rnx = m->region.length[0];
+        const int rny = m->region.length[1];
+        const int n   = nfreq*rnx*rny;
+        double *buf = (double *)calloc(2*n + 1, sizeof(double));
+        for (int r=0; r<nprocs; r++) {
+            const int    *part = &parts[4*r];
+            const int    lnx   = part[2];
+            const int    lny   = part[3];
+            const double *pre  = recv_re + displs[r];
+            const double *pim  = recv_im + displs[r];
+            for (int f=0; f<nfreq; f++) {
+                for (int j=0; j<lny; j++) {
+                    for (int i=0; i<lnx; i++) {
+                        const int k  = (f*lny + j)*lnx + i;
+                        const int jj = j + part[1] - m->region.begin[1];
+                        const int ii = i + part[0] - m->region.begin[0];
+                        const int g  = f*rnx*rny + jj*rnx + ii;
+                        buf[g    ] = pre[k];
+                        buf[g + n] = pim[k];
+                    }
+                }
+            }
+        }
+
+        // Header: "DFT1", comp, nfreq, region, freq[nfreq], then re and im [nfreq][rny][rnx]
+        FILE *fp = fopen(filename, "wb");
+        if (fp == NULL) {
+            fprintf(stderr, "Error: cannot open %s\n", filename);
+            ret = false;
+        } else {
+            const int header[] = { m->comp, nfreq,
+                                   m->region.begin[0], m->region.begin[1], rnx, rny };
+            fwrite("DFT1", 1, 4, fp);
+            fwrite(header, sizeof(int), 6, fp);
+            fwrite(m->freq, sizeof(double), nfreq, fp);
+            ret = fwrite(buf, sizeof(double), 2*n, fp) == (size_t)(2*n);
+            fclose(fp);
+        }
+        free(buf);
+    }
+
+    free(recv);
+    free(parts);
+    free(counts);
+    free(displs);
+
+    return ret;
+}
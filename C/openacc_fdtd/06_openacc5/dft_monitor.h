@@ -0,0 +1,60 @@
+/**
+ * @file dft_monitor.h
+ * @brief On-the-fly DFT monitors
+ *
+ * Running DFT accumulators of a field component over a region for a set
+ * of frequencies.  The accumulators are updated in the time loop and
+ * written once at the end of the run.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$ 
+ */
+
+#ifndef DFT_MONITOR_H
+#define DFT_MONITOR_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "config.h"
+
+/**
+ * @brief DFT monitor of one field component
+ *
+ * F(x, f) = sum_n field(x, t_n) exp(-2 pi i f t_n) dt, where t_n = n*dt for
+ * ex/ey and (n+0.5)*dt for hz.  The phasors exp(-2 pi i f t_n) are
+ * precomputed for a window of nwindow steps.  A monitor of no frequency
+ * (nfreq = 0) is off: it records and writes nothing.
+ */
+struct DFTMonitor {
+    int    comp;         // FIELD_EX, FIELD_EY or FIELD_HZ
+    int    nfreq;
+    double *freq;        // [Hz]
+    struct Range region; // global cells
+    struct Range local;  // cells of region owned by this rank
+    int    nlocal;
+    int    offset;       // local.begin - whole.begin
+    int    lnx;
+
+    double dt;
+    int    nwindow;
+    int    window_begin;
+    FLOAT  *twiddle;     // [nwindow][nfreq][2]
+    double *re;          // [nfreq][nlocal]
+    double *im;
+};
+
+void dft_monitor_init(struct DFTMonitor *m, int comp, const struct Range *region,
+                      int nfreq, const double *freq,
+                      const struct Range *whole, const struct Range *inside, double dt, int nwindow);
+void dft_monitor_free(struct DFTMonitor *m);
+void dft_monitor_update(struct DFTMonitor *m, int step, const FLOAT *field);
+
+// The monitors m[0:n] of ex and ey after the E update, of hz after the H update
+void dft_monitors_update_e(struct DFTMonitor *m, int n, int step, const FLOAT *ex, const FLOAT *ey);
+void dft_monitors_update_h(struct DFTMonitor *m, int n, int step, const FLOAT *hz);
+bool dft_monitor_write(const struct DFTMonitor *m, const char *filename);
+
+#endif /* DFT_MONITOR_H */
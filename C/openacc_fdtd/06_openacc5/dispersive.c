@@ -0,0 +1,209 @@
+/**
+ * @file dispersive.c
+ * @brief Lossy and dispersive materials
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$ 
+ */
+
+#include "dispersive.h"
+#include "setup.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void dispersive_init(struct Dispersive *d)
+{
+    memset(d, 0, sizeof(struct Dispersive));
+}
+
+int dispersive_add_material(struct Dispersive *d, const struct Material *m)
+{
+    if (d->nmaterials >= 255) {
+        fprintf(stderr, "dispersive: too many materials (max 255)\n");
+        return 0;
+    }
+    d->materials = (struct Material *)realloc(d->materials, sizeof(struct Material)*(d->nmaterials + 1));
+    d->materials[d->nmaterials] = *m;
+    return ++d->nmaterials;
+}
+
+void dispersive_apply_er(const struct Dispersive *d, const int length[], const unsigned char *mat, FLOAT *er)
+{
+    const int n = length[0]*length[1];
+    for (int i=0; i<n; i++) {
+        const int m = mat[i];
+        if (m > 0 && m <= d->nmaterials) {
+            er[i] = d->materials[m-1].eps_inf;
+        }
+    }
+}
+
+void dispersive_setup(struct Dispersive *d, const struct Range *whole, const struct Range *inside,
+                      FLOAT dt, FLOAT e0, const unsigned char *mat, const unsigned int *obj_mask, const FLOAT *er,
+                      FLOAT *cexly, FLOAT *ceylx)
+{
+    const int nm = d->nmaterials;
+    d->dt = dt;
+    d->kj = (FLOAT *)calloc(nm + 1, sizeof(FLOAT));
+    d->ba = (FLOAT *)calloc(nm + 1, sizeof(FLOAT));
+    d->bw = (FLOAT *)calloc(nm + 1, sizeof(FLOAT));
+    
+    for (int m=1; m<=nm; m++) {
+        const struct Material *mt = &d->materials[m-1];
+        const FLOAT g  = mt->type == MATERIAL_DIELECTRIC ? 0.0 : mt->gamma;
+        const FLOAT bj = dt / (1.0 + 0.5*g*dt);
+        const FLOAT a  = mt->type == MATERIAL_DRUDE   ? e0*mt->omega_p*mt->omega_p :
+                         mt->type == MATERIAL_LORENTZ ? e0*mt->delta_eps*mt->omega_0*mt->omega_0 : 0.0;
+        const FLOAT w2 = mt->type == MATERIAL_LORENTZ ? mt->omega_0*mt->omega_0 : 0.0;
+        
+        d->kj[m] = mt->type == MATERIAL_DIELECTRIC ? 0.0 : (1.0 - 0.5*g*dt) / (1.0 + 0.5*g*dt);
+        d->ba[m] = bj*a;
+        d->bw[m] = bj*w2;
+    }
+
+    const int lnx = whole->length[0];
+    const int b0  = inside->begin[0] - whole->begin[0];
+    const int b1  = inside->begin[1] - whole->begin[1];
+    const int nx  = inside->length[0];
+    const int ny  = inside->length[1];
+    
+    for (int c=0; c<2; c++) {
+        // Neighbour cell sharing the ex (ey) point
+        const int nb = c == 0 ? lnx : 1;
+        
+        for (int pass=0; pass<2; pass++) {
+            int n = 0;
+            for (int j=b1; j<b1+ny; j++) {
+                for (int i=b0; i<b0+nx; i++) {
+                    const int ix = j*lnx + i;
+                    const int m  = mat[ix] > 0 ? mat[ix] : mat[ix - nb];
+                    if (m <= 0 || m > nm) continue;
+                    if (OBJECT_MASK_GET(obj_mask, ix) || OBJECT_MASK_GET(obj_mask, ix - nb)) continue;
+                    if (d->materials[m-1].type  == MATERIAL_DIELECTRIC &&
+                        d->materials[m-1].sigma == 0.0) continue;
+
+                    if (pass == 1) {
+                        const struct Material *mt = &d->materials[m-1];
+                        const FLOAT eps = e0*0.5*(er[ix] + er[ix - nb]);
+                        const FLOAT s   = 0.5*mt->sigma*dt/eps;
+                        d->index[c][n] = ix;
+                        d->mat  [c][n] = m;
+                        d->ca   [c][n] = (1.0 - s)/(1.0 + s);
+                        d->cb   [c][n] = dt/eps/(1.0 + s);
+                        d->j    [c][n] = 0.0;
+                        d->p    [c][n] = 0.0;
+                    }
+                    n++;
+                }
+            }
+            if (pass == 0) {
+                d->n    [c] = n;
+                d->index[c] = (int   *)malloc(sizeof(int  )*(n + 1));
+                d->mat  [c] = (int   *)malloc(sizeof(int  )*(n + 1));
+                d->ca   [c] = (FLOAT *)malloc(sizeof(FLOAT)*(n + 1));
+                d->cb   [c] = (FLOAT *)malloc(sizeof(FLOAT)*(n + 1));
+                d->j    [c] = (FLOAT *)malloc(sizeof(FLOAT)*(n + 1));
+                d->p    [c] = (FLOAT *)malloc(sizeof(FLOAT)*(n + 1));
+            }
+        }
+    }
+
+    FLOAT *kj = d->kj;
+    FLOAT *ba = d->ba;
+    FLOAT *bw = d->bw;
+#pragma acc enter data copyin(kj[0:nm+1], ba[0:nm+1], bw[0:nm+1])
+
+    for (int c=0; c<2; c++) {
+        const int n = d->n[c];
+        int   *index = d->index[c];
+        int   *mt    = d->mat[c];
+        FLOAT *ca    = d->ca[c];
+        FLOAT *cb    = d->cb[c];
+        FLOAT *jp    = d->j[c];
+        FLOAT *pp    = d->p[c];
+        FLOAT *ce    = c == 0 ? cexly : ceylx;
+#pragma acc enter data copyin(index[0:n], mt[0:n], ca[0:n], cb[0:n], jp[0:n], pp[0:n])
+
+        // cb*rot H is added by calc_ex_ey: rescale its coefficient by 1/(1 + sigma dt/(2 eps))
+#pragma acc kernels present(index, ca, ce)
+#pragma acc loop independent
+        for (int k=0; k<n; k++) {
+            ce[index[k]] *= 0.5*(1.0 + ca[k]);
+        }
+    }
+}
+
+void dispersive_update_e(struct Dispersive *d, FLOAT *ex, FLOAT *ey)
+{
+    const FLOAT  dt = d->dt;
+    const FLOAT *kj = d->kj;
+    const FLOAT *ba = d->ba;
+    const FLOAT *bw = d->bw;
+    
+    for (int c=0; c<2; c++) {
+        const int n = d->n[c];
+        if (n == 0) continue;
+        
+        const int   *index = d->index[c];
+        const int   *mt    = d->mat[c];
+        const FLOAT *ca    = d->ca[c];
+        const FLOAT *cb    = d->cb[c];
+        FLOAT       *jp    = d->j[c];
+        FLOAT       *pp    = d->p[c];
+        FLOAT       *e     = c == 0 ? ex : ey;
+
+#pragma acc kernels present(kj, ba, bw, index, mt, ca, cb, jp, pp, e)
+#pragma acc loop independent
+        for (int k=0; k<n; k++) {
+            const int   ix = index[k];
+            const int   m  = mt[k];
+            const FLOAT e0 = e[ix];
+            const FLOAT jn = kj[m]*jp[k] + ba[m]*e0 - bw[m]*pp[k];
+            pp[k] += dt*jn;
+            jp[k]  = jn;
+            e[ix]  = ca[k]*e0 - cb[k]*jn;
+        }
+    }
+}
+
+void dispersive_free(struct Dispersive *d)
+{
+    const int nm = d->nmaterials;
+    FLOAT *kj = d->kj;
+    FLOAT *ba = d->ba;
+    FLOAT *bw = d->bw;
+    if (kj != NULL) {
+#pragma acc exit data delete(kj[0:nm+1], ba[0:nm+1], bw[0:nm+1])
+    }
+    
+    for (int c=0; c<2; c++) {
+        const int n = d->n[c];
+        int   *index = d->index[c];
+        int   *mt    = d->mat[c];
+        FLOAT *ca    = d->ca[c];
+        FLOAT *cb    = d->cb[c];
+        FLOAT *jp    = d->j[c];
+        FLOAT *pp    = d->p[c];
+        if (index != NULL) {
+#pragma acc exit data delete(index[0:n], mt[0:n], ca[0:n], cb[0:n], jp[0:n], pp[0:n])
+        }
+        free(index);
+        free(mt);
+        free(ca);
+        free(cb);
+        free(jp);
+        free(pp);
+    }
+
+    free(d->materials);
+    free(kj);
+    free(ba);
+    free(bw);
+    dispersive_init(d);
+}
@@ -0,0 +1,82 @@
+/**
+ * @file dispersive.h
+ * @brief Lossy and dispersive materials
+ *
+ * Conductivity and Drude/Lorentz dispersion by the auxiliary
+ * differential equation (ADE) method.  The polarization currents are
+ * stored only for the cells of these materials.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$ 
+ */
+
+#ifndef DISPERSIVE_H
+#define DISPERSIVE_H
+
+#include <stdio.h>
+#include "config.h"
+
+enum MaterialType {
+    MATERIAL_DIELECTRIC = 0, // eps_inf and sigma only
+    MATERIAL_DRUDE      = 1, // eps_inf - omega_p^2/(omega^2 - i gamma omega)
+    MATERIAL_LORENTZ    = 2  // eps_inf + delta_eps omega_0^2/(omega_0^2 - omega^2 + i gamma omega)
+};
+
+struct Material {
+    int   type;
+    FLOAT eps_inf;   // relative permittivity at infinite frequency
+    FLOAT sigma;     // conductivity [S/m]
+    FLOAT omega_p;   // Drude plasma frequency [rad/s]
+    FLOAT delta_eps; // Lorentz strength
+    FLOAT omega_0;   // Lorentz resonance frequency [rad/s]
+    FLOAT gamma;     // damping [1/s]
+};
+
+/**
+ * @brief Sparse ADE storage
+ *
+ * The material of a cell is given by a material map (0: none, k: the
+ * k-th added material, at most 255 materials).  Only the ex and ey points in the inside range
+ * which touch a material cell get an entry with the update coefficients
+ * and the polarization current J and polarization P of that point:
+ *
+ *   J^{n+1/2} = kj J^{n-1/2} + bj (a E^n - omega_0^2 P^n)
+ *   P^{n+1}   = P^n + dt J^{n+1/2}
+ *   E^{n+1}   = ca E^n + cb (rot H - J^{n+1/2})
+ *
+ * dispersive_update_e() applies the first three terms before calc_ex_ey(),
+ * which adds cb*rot H using the rescaled cexly/ceylx.
+ */
+struct Dispersive {
+    int nmaterials;
+    struct Material *materials;
+    FLOAT dt;
+    
+    // Per material, [nmaterials+1], entry 0 is unused
+    FLOAT *kj;
+    FLOAT *ba; // bj*a
+    FLOAT *bw; // bj*omega_0^2
+
+    // Per point, [0]: ex, [1]: ey
+    int   n[2];
+    int   *index[2];
+    int   *mat[2];
+    FLOAT *ca[2];
+    FLOAT *cb[2];
+    FLOAT *j[2];
+    FLOAT *p[2];
+};
+
+void dispersive_init(struct Dispersive *d);
+int  dispersive_add_material(struct Dispersive *d, const struct Material *m);
+void dispersive_apply_er(const struct Dispersive *d, const int length[], const unsigned char *mat, FLOAT *er);
+void dispersive_setup(struct Dispersive *d, const struct Range *whole, const struct Range *inside,
+                      FLOAT dt, FLOAT e0, const unsigned char *mat, const unsigned int *obj_mask, const FLOAT *er,
+                      FLOAT *cexly, FLOAT *ceylx);
+void dispersive_update_e(struct Dispersive *d, FLOAT *ex, FLOAT *ey);
+void dispersive_free(struct Dispersive *d);
+
+#endif /* DISPERSIVE_H */
@@ -0,0 +1,310 @@
+/**
+ * @file ensemble.c
+ * @brief Many independent small runs in one process
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include "ensemble.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "stats.h"
+
+void ensemble_init(struct Ensemble *e)
+{
+    memset(e, 0, sizeof(struct Ensemble));
+}
+
+void ensemble_free(struct Ensemble *e)
+{
+    free(e->cases);
+    free(e->labels);
+    free(e->results);
+    memset(e, 0, sizeof(struct Ensemble));
+}
+
+static bool add_case(struct Ensemble *e, const struct Params *p, const char *label)
+{
+    if (e->ncases == e->ncases_max) {
+        const int n = e->ncases_max > 0 ? 2*e->ncases_max : 16;
+        struct Params *cases = (struct Params *)realloc(e->cases, sizeof(struct Params)*n);
+        if (cases != NULL) e->cases = cases;
+        char (*labels)[PARAMS_STRING_LEN] = (char (*)[PARAMS_STRING_LEN])realloc(e->labels, PARAMS_STRING_LEN*n);
+        if (labels != NULL) e->labels = labels;
+        if (cases == NULL || labels == NULL) {
+            fprintf(stderr, "Error: cannot allocate %d cases\n", n);
+            return false;
+        }
+        e->ncases_max = n;
+    }
+    e->cases[e->ncases] = *p;
+    snprintf(e->labels[e->ncases], PARAMS_STRING_LEN, "%s", label);
+    e->ncases++;
+    return true;
+}
+
+bool ensemble_load(struct Ensemble *e, const struct Params *base, const char *filename)
+{
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", filename);
+        return false;
+    }
+
+    char line[1024];
+    int  lineno = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), fp) != NULL) {
+        lineno++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+        char *s = line;
+        while (isspace((unsigned char)*s)) s++;
+        char *end = s + strlen(s);
+        while (end > s && isspace((unsigned char)end[-1])) end--;
+        *end = '\0';
+        if (*s == '\0') continue;
+
+        // The overrides of the case, separated by blanks
+        struct Params p = *base;
+        char buf[sizeof(line)];
+        strcpy(buf, s);
+        char *saveptr;
+        for (char *tok = strtok_r(buf, " \t", &saveptr); tok != NULL && ok; tok = strtok_r(NULL, " \t", &saveptr)) {
+            ok = params_assign(&p, tok);
+        }
+        ok = ok && params_check(&p, true) && add_case(e, &p, s);
+        if (!ok) {
+            fprintf(stderr, "Error: %s:%d\n", filename, lineno);
+        }
+    }
+    fclose(fp);
+
+    free(e->results);
+    e->results = (struct EnsembleResult *)calloc(e->ncases > 0 ? e->ncases : 1, sizeof(struct EnsembleResult));
+    return ok;
+}
+
+bool ensemble_workspace_reserve(struct EnsembleWorkspace *ws, const int length[])
+{
+    const size_t nelems   = (size_t)length[0]*length[1];
+    const size_t nelems_x = length[0];
+    const size_t nelems_y = length[1];
+    if (nelems <= ws->nelems && nelems_x <= ws->nelems_x && nelems_y <= ws->nelems_y) {
+        return true;
+    }
+
+    const int thread = ws->thread;
+    const int nallocs = ws->nallocs;
+    ensemble_workspace_free(ws);
+    ws->thread  = thread;
+    ws->nallocs = nallocs + 1;
+
+    FLOAT **fields[] = { &ws->ex, &ws->ey, &ws->hz, &ws->cexly, &ws->ceylx,
+                         &ws->exy, &ws->eyx, &ws->hzx, &ws->hzy,
+                         &ws->er, &ws->rer_ex, &ws->rer_ey };
+    FLOAT **xs[]     = { &ws->chzlx, &ws->ceyx, &ws->chzx, &ws->ceyxl, &ws->chzxl };
+    FLOAT **ys[]     = { &ws->chzly, &ws->cexy, &ws->chzy, &ws->cexyl, &ws->chzyl };
+
+    bool ok = true;
+    for (size_t k=0; k<sizeof(fields)/sizeof(fields[0]); k++) {
+        *fields[k] = (FLOAT *)malloc(sizeof(FLOAT)*nelems);
+        ok = ok && *fields[k] != NULL;
+    }
+    for (size_t k=0; k<sizeof(xs)/sizeof(xs[0]); k++) {
+        *xs[k] = (FLOAT *)malloc(sizeof(FLOAT)*nelems_x);
+        *ys[k] = (FLOAT *)malloc(sizeof(FLOAT)*nelems_y);
+        ok = ok && *xs[k] != NULL && *ys[k] != NULL;
+    }
+    ws->mat      = (unsigned char *)malloc(sizeof(unsigned char)*nelems);
+    ws->obj_mask = (unsigned int  *)malloc(sizeof(unsigned int)*((nelems + 31) >> 5));
+    ok = ok && ws->mat != NULL && ws->obj_mask != NULL;
+
+    if (!ok) {
+        fprintf(stderr, "Error: cannot allocate the workspace of %d x %d cells\n", length[0], length[1]);
+        ensemble_workspace_free(ws);
+        ws->thread = thread;
+        return false;
+    }
+    ws->nelems   = nelems;
+    ws->nelems_x = nelems_x;
+    ws->nelems_y = nelems_y;
+    return true;
+}
+
+void ensemble_workspace_free(struct EnsembleWorkspace *ws)
+{
+    FLOAT *arrays[] = { ws->ex, ws->ey, ws->hz, ws->cexly, ws->ceylx,
+                        ws->exy, ws->eyx, ws->hzx, ws->hzy,
+                        ws->er, ws->rer_ex, ws->rer_ey,
+                        ws->chzlx, ws->ceyx, ws->chzx, ws->ceyxl, ws->chzxl,
+                        ws->chzly, ws->cexy, ws->chzy, ws->cexyl, ws->chzyl };
+    for (size_t k=0; k<sizeof(arrays)/sizeof(arrays[0]); k++) {
+        free(arrays[k]);
+    }
+    free(ws->mat);
+    free(ws->obj_mask);
+    memset(ws, 0, sizeof(struct EnsembleWorkspace));
+}
+
+static double ensemble_clock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1.0e-9;
+}
+
+struct EnsembleQueue {
+    struct Ensemble *e;
+    const int *order;
+    int next;
+    int ndone;
+    pthread_mutex_t mutex;
+    bool (*run_case)(struct EnsembleWorkspace *ws, const struct Params *p, int index, struct EnsembleResult *r);
+};
+
+struct EnsembleThread {
+    pthread_t thread;
+    struct EnsembleWorkspace ws;
+    struct EnsembleQueue *queue;
+};
+
+static void *ensemble_main(void *arg)
+{
+    struct EnsembleThread *t = (struct EnsembleThread *)arg;
+    struct EnsembleQueue  *q = t->queue;
+
+    for (;;) {
+        pthread_mutex_lock(&q->mutex);
+        const int n = q->next < q->e->ncases ? q->order[q->next++] : -1;
+        pthread_mutex_unlock(&q->mutex);
+        if (n < 0) break;
+
+        struct EnsembleResult *r = &q->e->results[n];
+        memset(r, 0, sizeof(struct EnsembleResult));
+        r->thread = t->ws.thread;
+
+        const double t0 = ensemble_clock();
+        r->ok = q->run_case(&t->ws, &q->e->cases[n], n, r);
+        r->elapsed = ensemble_clock() - t0;
+
+        pthread_mutex_lock(&q->mutex);
+        const int ndone = ++q->ndone;
+        pthread_mutex_unlock(&q->mutex);
+        fprintf(stdout, "case %4d done (%d/%d): thread %d, %d steps, %.3f [sec]%s\n",
+                n, ndone, q->e->ncases, r->thread, r->icnt, r->elapsed, r->ok ? "" : ", failed");
+        fflush(stdout);
+    }
+    return NULL;
+}
+
+static const struct Ensemble *sort_ensemble;
+
+static double case_cost(const struct Params *p)
+{
+    return (double)(p->nx + 2*p->pml + 1)*(p->ny + 2*p->pml + 1)*(p->nt > 0 ? p->nt : 1);
+}
+
+// The largest cases first, in the order of the file for the same cost
+static int compare_cost(const void *a, const void *b)
+{
+    const int na = *(const int *)a;
+    const int nb = *(const int *)b;
+    const double ca = case_cost(&sort_ensemble->cases[na]);
+    const double cb = case_cost(&sort_ensemble->cases[nb]);
+    if (ca != cb) return ca > cb ? -1 : 1;
+    return na - nb;
+}
+
+void ensemble_run(struct Ensemble *e, int nthreads,
+                  bool (*run_case)(struct EnsembleWorkspace *ws, const struct Params *p, int index,
+                                   struct EnsembleResult *r))
+{
+    if (e->ncases == 0) return;
+    if (nthreads <= 0) {
+        const long nprocs = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = nprocs > 0 ? (int)nprocs : 1;
+    }
+    if (nthreads > e->ncases) nthreads = e->ncases;
+    e->nthreads = nthreads;
+
+    int *order = (int *)malloc(sizeof(int)*e->ncases);
+    for (int n=0; n<e->ncases; n++) order[n] = n;
+    sort_ensemble = e;
+    qsort(order, e->ncases, sizeof(int), compare_cost);
+    sort_ensemble = NULL;
+
+    struct EnsembleQueue queue;
+    memset(&queue, 0, sizeof(queue));
+    queue.e        = e;
+    queue.order    = order;
+    queue.run_case = run_case;
+    pthread_mutex_init(&queue.mutex, NULL);
+
+    struct EnsembleThread *threads = (struct EnsembleThread *)calloc(nthreads, sizeof(struct EnsembleThread));
+    const double t0 = ensemble_clock();
+    for (int k=0; k<nthreads; k++) {
+        threads[k].ws.thread = k;
+        threads[k].queue     = &queue;
+    }
+    // Thread 0 is the calling thread
+    for (int k=1; k<nthreads; k++) {
+        pthread_create(&threads[k].thread, NULL, ensemble_main, &threads[k]);
+    }
+    ensemble_main(&threads[0]);
+    for (int k=1; k<nthreads; k++) {
+        pthread_join(threads[k].thread, NULL);
+    }
+    e->elapsed = ensemble_clock() - t0;
+
+    for (int k=0; k<nthreads; k++) {
+        if (threads[k].ws.nallocs > 1) {
+            fprintf(stdout, "thread %d: workspace allocated %d times\n", k, threads[k].ws.nallocs);
+        }
+        ensemble_workspace_free(&threads[k].ws);
+    }
+    free(threads);
+    pthread_mutex_destroy(&queue.mutex);
+    free(order);
+}
+
+bool ensemble_write(const struct Ensemble *e, const char *filename)
+{
+    FILE *fp = filename != NULL ? fopen(filename, "w") : stdout;
+    if (fp == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", filename);
+        return false;
+    }
+
+    // All the steps done, stopped by the tolerance or the divergence of the statistics
+    static const char *const status_names[] = {
+        [STATS_RUNNING] = "done", [STATS_CONVERGED] = "converged", [STATS_DIVERGED] = "diverged"
+    };
+    double cells = 0.0;
+    fprintf(fp, "# %d cases on %d threads in %.3f [sec]\n", e->ncases, e->nthreads, e->elapsed);
+    fprintf(fp, "#%5s %6s %-9s %13s %13s %13s %13s %13s %10s %6s  %s\n",
+            "case", "icnt", "status", "time", "energy", "absorbed", "emax", "norm_e", "elapsed", "thread", "overrides");
+    for (int n=0; n<e->ncases; n++) {
+        const struct EnsembleResult *r = &e->results[n];
+        const struct Params *p = &e->cases[n];
+        cells += (double)p->nx*p->ny*r->icnt;
+        fprintf(fp, " %5d %6d %-9s %13.6e %13.6e %13.6e %13.6e %13.6e %10.3f %6d  %s\n",
+                n, r->icnt, r->ok ? status_names[r->status] : "failed", r->time,
+                r->energy, r->absorbed, r->emax, r->norm_e, r->elapsed, r->thread, e->labels[n]);
+    }
+    fprintf(fp, "# %.3e cell updates/sec\n", e->elapsed > 0.0 ? cells/e->elapsed : 0.0);
+
+    if (fp != stdout) fclose(fp);
+    return true;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file ensemble.h
+ * @brief Many independent small runs in one process
+ *
+ * A sweep file lists the cases, one per line, as key=value overrides of
+ * the base parameters (see params.h):
+ *
+ *   wavelength=400e-9
+ *   wavelength=500e-9 geometry=slit2.geom
+ *
+ * ensemble_run() runs the cases on nthreads threads, each taking the next
+ * case when it is done with one.  The cases are taken from the largest
+ * (nx*ny*nt) to the smallest, which balances the threads and lets every
+ * thread keep the arrays of its first case (its workspace) for all the
+ * following ones.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "config.h"
+#include "params.h"
+
+struct EnsembleResult {
+    bool   ok;        // false: the case could not be set up
+    int    icnt;      // steps done
+    int    status;    // STATS_*
+    double time;      // [sec]
+    double energy, absorbed, emax;
+    double norm_e;    // L2 norm of E in the first region of the statistics
+    double elapsed;   // [sec]
+    int    thread;
+};
+
+/**
+ * @brief Arrays of the cases of one thread
+ *
+ * ensemble_workspace_reserve() grows them to the size of a case and never
+ * shrinks them; the contents are not kept.
+ */
+struct EnsembleWorkspace {
+    int    thread;
+    size_t nelems, nelems_x, nelems_y; // capacities
+    int    nallocs;                    // number of times the arrays were (re)allocated
+
+    // [nelems]
+    FLOAT *ex, *ey, *hz, *cexly, *ceylx;
+    FLOAT *exy, *eyx, *hzx, *hzy;
+    FLOAT *er, *rer_ex, *rer_ey;
+    unsigned char *mat;
+    unsigned int  *obj_mask;
+    // [nelems_x]
+    FLOAT *chzlx, *ceyx, *chzx, *ceyxl, *chzxl;
+    // [nelems_y]
+    FLOAT *chzly, *cexy, *chzy, *cexyl, *chzyl;
+};
+
+struct Ensemble {
+    int ncases;
+    int ncases_max;
+    struct Params         *cases;
+    char                 (*labels)[PARAMS_STRING_LEN]; // the line of the sweep file
+    struct EnsembleResult *results;
+    double elapsed;    // [sec] of ensemble_run()
+    int    nthreads;
+};
+
+void ensemble_init(struct Ensemble *e);
+void ensemble_free(struct Ensemble *e);
+
+/**
+ * @brief add the cases of a sweep file to the ensemble
+ *
+ * Each case is base with the overrides of its line; every case is checked
+ * with params_check().
+ */
+bool ensemble_load(struct Ensemble *e, const struct Params *base, const char *filename);
+
+bool ensemble_workspace_reserve(struct EnsembleWorkspace *ws, const int length[]);
+void ensemble_workspace_free(struct EnsembleWorkspace *ws);
+
+/**
+ * @brief run all the cases
+ *
+ * run_case is called concurrently from nthreads threads (0: all the
+ * processors), with the workspace of the calling thread.
+ */
+void ensemble_run(struct Ensemble *e, int nthreads,
+                  bool (*run_case)(struct EnsembleWorkspace *ws, const struct Params *p, int index,
+                                   struct EnsembleResult *r));
+
+/**
+ * @brief table of the results, one line per case in the order of the sweep file
+ */
+bool ensemble_write(const struct Ensemble *e, const char *filename);
+
+#endif /* ENSEMBLE_H */
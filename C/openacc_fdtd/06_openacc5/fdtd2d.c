@@ -12,66 +12,47 @@
  */
 
 #include "fdtd2d.h"
+#include "fdtd2d_kernels.h"
 
-void calc_ex_ey(const struct Range *whole, const struct Range *inside,
-                const FLOAT *hz, const FLOAT *cexly, const FLOAT *ceylx, FLOAT *ex, FLOAT *ey)
+// The kernels of ../kernels (chzlx per column, chzly per row) in the
+// precision of FLOAT; the compute regions run on the device type of
+// acc_set_device_type(), the host included
+#define KERNELS FDTD2D_KERNELS(FLOAT, FDTD2D_LAYOUT_AXIS, FDTD2D_BACKEND_DEVICE)
+
+// Set by fdtd2d_set_tile() (autotune); { 0, 0 }: the original loop nests
+static int fdtd2d_tiles[TILE_NKERNELS][2];
+
+void fdtd2d_set_tile(int kernel, const int tile[2])
 {
-    const int nx    = inside->length[0];
-    const int ny    = inside->length[1];
-    const int mgn[] = { inside->begin[0] - whole->begin[0],
-                        inside->begin[1] - whole->begin[1] };
-    const int lnx   = whole->length[0];
+    fdtd2d_tiles[kernel][0] = tile[0] > 0 ? tile[0] : 0;
+    fdtd2d_tiles[kernel][1] = tile[1] > 0 ? tile[1] : 0;
+}
 
-    const int mgn0  = mgn[0];
-    const int mgn1  = mgn[1];
+void fdtd2d_get_tile(int kernel, int tile[2])
+{
+    tile[0] = fdtd2d_tiles[kernel][0];
+    tile[1] = fdtd2d_tiles[kernel][1];
+}
 
-#pragma acc kernels 
-#pragma acc loop independent
-    for (int j=0; j<ny+1; j++) {
-#pragma acc loop independent
-        for (int i=0; i<nx; i++) {
-            const int ix = (j+mgn1)*lnx + i+mgn0;
-            const int jm = ix - lnx;
-            //ex[ix] += cexly[ix]*(hz[ix]-hz[jm]) - cexlz[ix]*(hy[ix]-hy[km]);
-            ex[ix] += cexly[ix]*(hz[ix]-hz[jm]);
-        }
-    }
-    
-#pragma acc kernels 
-#pragma acc loop independent
-    for (int j=0; j<ny; j++) {
-#pragma acc loop independent
-        for (int i=0; i<nx+1; i++) {
-            const int ix = (j+mgn1)*lnx + i+mgn0;
-            const int im = ix - 1;
-            //ey[ix] += ceylz[ix]*(hx[ix]-hx[km]) - ceylx[ix]*(hz[ix]-hz[im]);
-            ey[ix] += - ceylx[ix]*(hz[ix]-hz[im]);
-        }
+void calc_ex_ey(const struct Range *whole, const struct Range *inside,
+                const FLOAT *hz, const FLOAT *cexly, const FLOAT *ceylx, FLOAT *ex, FLOAT *ey)
+{
+    const int *tile = fdtd2d_tiles[TILE_CALC_EX_EY];
+    if (tile[0] > 0 || tile[1] > 0) {
+        KERNELS->calc_ex_ey_tiled(whole, inside, tile, hz, cexly, ceylx, ex, ey);
+    } else {
+        KERNELS->calc_ex_ey(whole, inside, hz, cexly, ceylx, ex, ey);
     }
 }
 
 void calc_hz(const struct Range *whole, const struct Range *inside,
              const FLOAT *ey, const FLOAT *ex, const FLOAT *chzlx, const FLOAT *chzly, FLOAT *hz)
 {
-    const int nx    = inside->length[0];
-    const int ny    = inside->length[1];
-    const int mgn[] = { inside->begin[0] - whole->begin[0],
-                        inside->begin[1] - whole->begin[1] };
-    const int lnx   = whole->length[0];
-
-    const int mgn0  = mgn[0];
-    const int mgn1  = mgn[1];
-
-#pragma acc kernels 
-#pragma acc loop independent
-    for (int j=0; j<ny; j++) {
-#pragma acc loop independent
-        for (int i=0; i<nx; i++) {
-            const int ix = (j+mgn1)*lnx + i+mgn0;
-            const int ip = ix + 1;
-            const int jp = ix + lnx;
-            hz[ix] += - chzlx[ix]*(ey[ip]-ey[ix]) + chzly[ix]*(ex[jp]-ex[ix]);
-        }
+    const int *tile = fdtd2d_tiles[TILE_CALC_HZ];
+    if (tile[0] > 0 || tile[1] > 0) {
+        KERNELS->calc_hz_tiled(whole, inside, tile, ey, ex, chzlx, chzly, hz);
+    } else {
+        KERNELS->calc_hz(whole, inside, ey, ex, chzlx, chzly, hz);
     }
 }
 
@@ -79,125 +60,20 @@ void pml_boundary_ex(const struct Range *whole, const struct Range *inside,
                      const FLOAT *hz, const FLOAT *cexy, const FLOAT *cexyl, const FLOAT *rer_ex,
                      FLOAT *ex, FLOAT *exy)
 {
-    const int bi[] = { inside->begin[0], inside->begin[1] };
-    const int ei[] = { inside->begin[0] + inside->length[0], inside->begin[1] + inside->length[1] };
-    const int bw[] = { whole->begin[0], whole->begin[1] };
-    const int ew[] = { whole->begin[0] + whole->length[0], whole->begin[1] + whole->length[1] };
-
-    const int r[4][4] = { { bw[0], ew[0], bw[1]+1, bi[1] },
-                          { bw[0], ew[0], ei[1]+1, ew[1] },
-                          { bw[0], bi[0], bi[1]  , ei[1]+1},
-                          { ei[0], ew[0], bi[1]  , ei[1]+1} };
-
-    const int lnx   = whole->length[0];
-    const int bw0 = bw[0];
-    const int bw1 = bw[1];
-    
-#pragma acc kernels 
-#pragma acc loop independent
-    for (int l=0; l<4; l++) {
-
-#pragma acc loop independent
-        for (int j=r[l][2]; j<r[l][3]; j++) {
-#pragma acc loop independent
-            for (int i=r[l][0]; i<r[l][1]; i++) {
-
-                const int jj = j - bw1;
-                const int ii = i - bw0;
-                
-                const int ix  = jj*lnx + ii;
-                const int jm  = ix - lnx;
-                exy[ix] = cexy[jj]*exy[ix] + rer_ex[ix]*cexyl[jj]*(hz[ix] - hz[jm]);
-                ex [ix]  = exy[ix];// + exz[ix];
-            }
-        }
-        
-    }
-    
+    KERNELS->pml_boundary_ex(whole, inside, hz, cexy, cexyl, rer_ex, ex, exy);
 }
 
-
 void pml_boundary_ey(const struct Range *whole, const struct Range *inside,
                      const FLOAT *hz, const FLOAT *ceyx, const FLOAT *ceyxl, const FLOAT *rer_ey,
                      FLOAT *ey, FLOAT *eyx)
 {
-    const int bi[] = { inside->begin[0], inside->begin[1] };
-    const int ei[] = { inside->begin[0] + inside->length[0], inside->begin[1] + inside->length[1] };
-    const int bw[] = { whole->begin[0], whole->begin[1] };
-    const int ew[] = { whole->begin[0] + whole->length[0], whole->begin[1] + whole->length[1] };
-
-    const int r[4][4] = { { bw[0]+1, ew[0], bw[1], bi[1] },
-                          { bw[0]+1, ew[0], ei[1], ew[1] },
-                          { bw[0]+1, bi[0], bi[1], ei[1] },
-                          { ei[0]+1, ew[0], bi[1], ei[1] } };
-
-    const int lnx   = whole->length[0];
-    const int bw0 = bw[0];
-    const int bw1 = bw[1];
-    
-#pragma acc kernels 
-#pragma acc loop independent
-    for (int l=0; l<4; l++) {
-
-#pragma acc loop independent
-        for (int j=r[l][2]; j<r[l][3]; j++) {
-#pragma acc loop independent
-            for (int i=r[l][0]; i<r[l][1]; i++) {
-
-                const int jj = j - bw1;
-                const int ii = i - bw0;
-                
-                const int ix  = jj*lnx + ii;
-                const int im  = ix - 1;
-                eyx[ix] = ceyx[ii]*eyx[ix] - rer_ey[ix]*ceyxl[ii]*(hz[ix]-hz[im]);
-                ey [ix]  = eyx[ix];// + eyz[ixp];
-            }
-        }
-        
-    }    
+    KERNELS->pml_boundary_ey(whole, inside, hz, ceyx, ceyxl, rer_ey, ey, eyx);
 }
 
-
 void pml_boundary_hz(const struct Range *whole, const struct Range *inside,
                      const FLOAT *ey, const FLOAT *ex,
                      const FLOAT *chzx, const FLOAT *chzxl, const FLOAT *chzy, const FLOAT *chzyl,
                      FLOAT *hz, FLOAT *hzx, FLOAT *hzy)
 {
-    const int bi[] = { inside->begin[0], inside->begin[1] };
-    const int ei[] = { inside->begin[0] + inside->length[0], inside->begin[1] + inside->length[1] };
-    const int bw[] = { whole->begin[0], whole->begin[1] };
-    const int ew[] = { whole->begin[0] + whole->length[0], whole->begin[1] + whole->length[1] };
-
-    const int r[4][4] = { { bw[0], ew[0]-1, bw[1], bi[1] },
-                          { bw[0], ew[0]-1, ei[1], ew[1]-1 },
-                          { bw[0], bi[0]  , bi[1], ei[1] },
-                          { ei[0], ew[0]-1, bi[1], ei[1] } };
-
-    const int lnx   = whole->length[0];
-    const int bw0 = bw[0];
-    const int bw1 = bw[1];
-    
-#pragma acc kernels 
-#pragma acc loop independent
-    for (int l=0; l<4; l++) {
-
-#pragma acc loop independent
-        for (int j=r[l][2]; j<r[l][3]; j++) {
-#pragma acc loop independent
-            for (int i=r[l][0]; i<r[l][1]; i++) {
-                
-                const int jj = j - bw1;
-                const int ii = i - bw0;
-                
-                const int ix  = jj*lnx + ii;
-                const int ip  = ix + 1;
-                const int jp  = ix + lnx;
-                hzx[ix] = chzx[ii]*hzx[ix] - chzxl[ii]*(ey[ip]-ey[ix]);
-                hzy[ix] = chzy[jj]*hzy[ix] + chzyl[jj]*(ex[jp]-ex[ix]);
-                hz [ix]  = hzx[ix] + hzy[ix];
-            }
-        }
-        
-    }
-    
+    KERNELS->pml_boundary_hz(whole, inside, ey, ex, chzx, chzxl, chzy, chzyl, hz, hzx, hzy);
 }
@@ -17,6 +17,21 @@
 #include <stdio.h>
 #include "config.h"
 
+/*
+ * Tiles of the loop nests of calc_ex_ey and calc_hz: one gang per tile of
+ * tile[0] x tile[1] cells, the cells of a tile over the vector lanes (on
+ * the host, cache blocks).  A tile of 0 is the whole extent; with no tile
+ * set the kernels are the original loop nests.  See autotune.h.
+ */
+enum Fdtd2dTiled {
+    TILE_CALC_EX_EY = 0,
+    TILE_CALC_HZ    = 1,
+    TILE_NKERNELS   = 2
+};
+
+void fdtd2d_set_tile(int kernel, const int tile[2]);
+void fdtd2d_get_tile(int kernel, int tile[2]);
+
 void calc_ex_ey(const struct Range *whole, const struct Range *inside,
                 const FLOAT *hz, const FLOAT *cexly, const FLOAT *ceylx, FLOAT *ex, FLOAT *ey);
 void calc_hz(const struct Range *whole, const struct Range *inside,
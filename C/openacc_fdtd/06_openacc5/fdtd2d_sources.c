@@ -12,38 +12,320 @@
  */
 
 #include "fdtd2d_sources.h"
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include "setup.h"
 
-void plane_wave_incidence(const struct Range *whole, const struct Range *inside, 
-                          FLOAT time, int jpos, FLOAT wavelength, FLOAT *ex, FLOAT *ey)
+#ifndef M_PI
+#define M_PI 3.14159265358979323846 /* pi */
+#endif
+
+// sin(2 pi x + phase) with x reduced to [0, 1) first: the argument stays
+// small however many periods x counts
+static double sin_cycles(double x, double phase)
 {
-    const FLOAT pi = constant.pi;
-    const FLOAT c  = constant.c;
+    return sin(2.0*M_PI*(x - floor(x)) + phase);
+}
+
+void sources_init(struct Sources *s)
+{
+    memset(s, 0, sizeof(struct Sources));
+}
+
+void sources_free(struct Sources *s)
+{
+    for (int h=0; h<2; h++) {
+        const int nc = s->ncells[h];
+        const int ne = s->nentries[h];
+        const int nt = s->nwaveforms * s->nwindow;
+        int   *cell_index   = s->cell_index[h];
+        int   *cell_comp    = s->cell_comp[h];
+        FLOAT *cell_keep    = s->cell_keep[h];
+        int   *cell_offset  = s->cell_offset[h];
+        int   *entry_wave   = s->entry_wave[h];
+        FLOAT *entry_weight = s->entry_weight[h];
+        FLOAT *table        = s->table[h];
+        
+        if (cell_index != NULL) {
+#pragma acc exit data delete(cell_index[0:nc], cell_comp[0:nc], cell_keep[0:nc], cell_offset[0:nc+1])
+#pragma acc exit data delete(entry_wave[0:ne], entry_weight[0:ne], table[0:nt])
+        }
+        free(cell_index);
+        free(cell_comp);
+        free(cell_keep);
+        free(cell_offset);
+        free(entry_wave);
+        free(entry_weight);
+        free(table);
+    }
+
+    free(s->waveforms);
+    free(s->point_i);
+    free(s->point_j);
+    free(s->point_comp);
+    free(s->point_wave);
+    free(s->point_hard);
+    free(s->point_weight);
 
+    sources_init(s);
+}
+
+int sources_add_waveform(struct Sources *s, const struct Waveform *w)
+{
+    if (s->nwaveforms == s->nwaveforms_max) {
+        s->nwaveforms_max = s->nwaveforms_max > 0 ? 2*s->nwaveforms_max : 16;
+        s->waveforms = (struct Waveform *)realloc(s->waveforms, sizeof(struct Waveform)*s->nwaveforms_max);
+    }
+    s->waveforms[s->nwaveforms] = *w;
+    return s->nwaveforms++;
+}
+
+void sources_add_point(struct Sources *s, int comp, int i, int j, int wave, FLOAT weight, int hard)
+{
+    if (s->npoints == s->npoints_max) {
+        s->npoints_max  = s->npoints_max > 0 ? 2*s->npoints_max : 256;
+        s->point_i      = (int   *)realloc(s->point_i     , sizeof(int  )*s->npoints_max);
+        s->point_j      = (int   *)realloc(s->point_j     , sizeof(int  )*s->npoints_max);
+        s->point_comp   = (int   *)realloc(s->point_comp  , sizeof(int  )*s->npoints_max);
+        s->point_wave   = (int   *)realloc(s->point_wave  , sizeof(int  )*s->npoints_max);
+        s->point_hard   = (int   *)realloc(s->point_hard  , sizeof(int  )*s->npoints_max);
+        s->point_weight = (FLOAT *)realloc(s->point_weight, sizeof(FLOAT)*s->npoints_max);
+    }
+    const int n = s->npoints++;
+    s->point_i     [n] = i;
+    s->point_j     [n] = j;
+    s->point_comp  [n] = comp;
+    s->point_wave  [n] = wave;
+    s->point_hard  [n] = hard;
+    s->point_weight[n] = weight;
+}
+
+void sources_add_line(struct Sources *s, int comp, int i0, int j0, int i1, int j1,
+                      int wave, FLOAT weight, int hard)
+{
+    const int n = line_cells(i0, j0, i1, j1, NULL, NULL);
+    int *ci = (int *)malloc(sizeof(int)*2*n);
+    line_cells(i0, j0, i1, j1, ci, ci + n);
+    for (int k=0; k<n; k++) {
+        sources_add_point(s, comp, ci[k], ci[n + k], wave, weight, hard);
+    }
+    free(ci);
+}
+
+double waveform_value(const struct Waveform *w, double time)
+{
+    const double t = time - w->t0;
+
+    switch (w->type) {
+    case WAVEFORM_SINUSOID:
+        return t < 0.0 ? 0.0 : w->amplitude*sin_cycles(w->freq*t, w->phase);
+    case WAVEFORM_GAUSSIAN:
+        return w->amplitude*exp(-(t/w->tau)*(t/w->tau));
+    case WAVEFORM_MODULATED_GAUSSIAN:
+        return w->amplitude*exp(-(t/w->tau)*(t/w->tau))*sin_cycles(w->freq*t, w->phase);
+    case WAVEFORM_RICKER: {
+        const double a = M_PI*w->freq*t;
+        return w->amplitude*(1.0 - 2.0*a*a)*exp(-a*a);
+    }
+    default:
+        return 0.0;
+    }
+}
+
+
+struct SourceCell {
+    int   comp;
+    int   ix;
+    int   wave;
+    int   hard;
+    FLOAT weight;
+};
+
+static int compare_source_cell(const void *a, const void *b)
+{
+    const struct SourceCell *ca = (const struct SourceCell *)a;
+    const struct SourceCell *cb = (const struct SourceCell *)b;
+    if (ca->comp != cb->comp) return ca->comp - cb->comp;
+    return (ca->ix > cb->ix) - (ca->ix < cb->ix);
+}
+
+static void fill_tables(struct Sources *s, int step_begin)
+{
+    const int    nw = s->nwindow;
+    const double dt = s->dt;
+    
+    for (int w=0; w<s->nwaveforms; w++) {
+        for (int n=0; n<nw; n++) {
+            const int step = step_begin + n;
+            s->table[0][w*nw + n] = waveform_value(&s->waveforms[w], step*dt);
+            s->table[1][w*nw + n] = waveform_value(&s->waveforms[w], (step + 0.5)*dt);
+        }
+    }
+    s->window_begin = step_begin;
+}
+
+void sources_setup(struct Sources *s, const struct Range *whole, const struct Range *inside,
+                   double dt, int nwindow)
+{
     const int inside_end[] = { inside->begin[0] + inside->length[0],
                                inside->begin[1] + inside->length[1] };
+    const int lnx = whole->length[0];
+
+    s->dt      = dt;
+    s->nwindow = nwindow;
+
+    struct SourceCell *cells = (struct SourceCell *)malloc(sizeof(struct SourceCell)*(s->npoints + 1));
     
-    const FLOAT freq = c / wavelength; // Hz
-    const FLOAT a = 80.0;
+    for (int h=0; h<2; h++) {
 
-    const FLOAT e = a*sin(2.0*pi*freq*time);
+        // Keep the cells owned by this rank
+        int n = 0;
+        for (int p=0; p<s->npoints; p++) {
+            const int i = s->point_i[p];
+            const int j = s->point_j[p];
+            const int is_h = s->point_comp[p] == FIELD_HZ;
+            
+            if (is_h != h) continue;
+            if (i < inside->begin[0] || i >= inside_end[0] ||
+                j < inside->begin[1] || j >= inside_end[1]) continue;
+            if (s->point_wave[p] < 0 || s->point_wave[p] >= s->nwaveforms) continue;
 
-    //printf("e = %8.3f, freq*time = %8.3f\n", e, freq*time);
+            cells[n].comp   = s->point_comp[p];
+            cells[n].ix     = (j - whole->begin[1])*lnx + (i - whole->begin[0]);
+            cells[n].wave   = s->point_wave[p];
+            cells[n].hard   = s->point_hard[p];
+            cells[n].weight = s->point_weight[p];
+            n++;
+        }
+        qsort(cells, n, sizeof(struct SourceCell), compare_source_cell);
 
+        int nc = 0;
+        for (int e=0; e<n; e++) {
+            if (e == 0 || compare_source_cell(&cells[e-1], &cells[e]) != 0) nc++;
+        }
+        
+        s->ncells      [h] = nc;
+        s->nentries    [h] = n;
+        s->cell_index  [h] = (int   *)malloc(sizeof(int  )*(nc + 1));
+        s->cell_comp   [h] = (int   *)malloc(sizeof(int  )*(nc + 1));
+        s->cell_keep   [h] = (FLOAT *)malloc(sizeof(FLOAT)*(nc + 1));
+        s->cell_offset [h] = (int   *)malloc(sizeof(int  )*(nc + 1));
+        s->entry_wave  [h] = (int   *)malloc(sizeof(int  )*(n  + 1));
+        s->entry_weight[h] = (FLOAT *)malloc(sizeof(FLOAT)*(n  + 1));
+        s->table       [h] = (FLOAT *)malloc(sizeof(FLOAT)*(s->nwaveforms*nwindow + 1));
+
+        // Merge the contributions to the same cell (CSR)
+        int c = -1;
+        for (int e=0; e<n; e++) {
+            if (e == 0 || compare_source_cell(&cells[e-1], &cells[e]) != 0) {
+                c++;
+                s->cell_index [h][c] = cells[e].ix;
+                s->cell_comp  [h][c] = cells[e].comp;
+                s->cell_keep  [h][c] = 1.0;
+                s->cell_offset[h][c] = e;
+            }
+            if (cells[e].hard) {
+                s->cell_keep[h][c] = 0.0;
+            }
+            s->entry_wave  [h][e] = cells[e].wave;
+            s->entry_weight[h][e] = cells[e].weight;
+        }
+        s->cell_offset[h][nc] = n;
+    }
+
+    free(cells);
     
-    
-    if (jpos < inside->begin[1] || jpos >= inside_end[1]) {
+    fill_tables(s, 0);
+
+    for (int h=0; h<2; h++) {
+        const int nc = s->ncells[h];
+        const int ne = s->nentries[h];
+        const int nt = s->nwaveforms * s->nwindow;
+        int   *cell_index   = s->cell_index[h];
+        int   *cell_comp    = s->cell_comp[h];
+        FLOAT *cell_keep    = s->cell_keep[h];
+        int   *cell_offset  = s->cell_offset[h];
+        int   *entry_wave   = s->entry_wave[h];
+        FLOAT *entry_weight = s->entry_weight[h];
+        FLOAT *table        = s->table[h];
+        
+#pragma acc enter data copyin(cell_index[0:nc], cell_comp[0:nc], cell_keep[0:nc], cell_offset[0:nc+1])
+#pragma acc enter data copyin(entry_wave[0:ne], entry_weight[0:ne], table[0:nt])
+    }
+}
+
+static void update_window(struct Sources *s, int step)
+{
+    if (step >= s->window_begin && step < s->window_begin + s->nwindow) {
         return;
-    }    
+    }
+    
+    fill_tables(s, step);
 
-    const int jj = jpos - whole->begin[1];
+    const int nt = s->nwaveforms * s->nwindow;
+    FLOAT *table_e = s->table[0];
+    FLOAT *table_h = s->table[1];
+#pragma acc update device(table_e[0:nt], table_h[0:nt])
+}
+
+void inject_sources_e(struct Sources *s, int step, FLOAT *ex, FLOAT *ey)
+{
+    const int nc = s->ncells[0];
+    if (nc == 0) return;
+    
+    update_window(s, step);
     
-#pragma acc kernels
+    const int    nw           = s->nwindow;
+    const int    n            = step - s->window_begin;
+    const int   *cell_index   = s->cell_index[0];
+    const int   *cell_comp    = s->cell_comp[0];
+    const FLOAT *cell_keep    = s->cell_keep[0];
+    const int   *cell_offset  = s->cell_offset[0];
+    const int   *entry_wave   = s->entry_wave[0];
+    const FLOAT *entry_weight = s->entry_weight[0];
+    const FLOAT *table        = s->table[0];
+    
+#pragma acc kernels present(cell_index, cell_comp, cell_keep, cell_offset, entry_wave, entry_weight, table, ex, ey)
 #pragma acc loop independent
-    for (int i=inside->begin[0]; i<inside_end[0]; i++) {
-        const int ii = i    - whole->begin[0];
-        const int ix = jj*whole->length[0] + ii;
-        ex[ix] = e;
+    for (int c=0; c<nc; c++) {
+        FLOAT e = 0.0;
+        for (int k=cell_offset[c]; k<cell_offset[c+1]; k++) {
+            e += entry_weight[k]*table[entry_wave[k]*nw + n];
+        }
+        const int ix = cell_index[c];
+        if (cell_comp[c] == FIELD_EX) {
+            ex[ix] = cell_keep[c]*ex[ix] + e;
+        } else {
+            ey[ix] = cell_keep[c]*ey[ix] + e;
+        }
     }
 }
 
+void inject_sources_h(struct Sources *s, int step, FLOAT *hz)
+{
+    const int nc = s->ncells[1];
+    if (nc == 0) return;
+    
+    update_window(s, step);
+    
+    const int    nw           = s->nwindow;
+    const int    n            = step - s->window_begin;
+    const int   *cell_index   = s->cell_index[1];
+    const FLOAT *cell_keep    = s->cell_keep[1];
+    const int   *cell_offset  = s->cell_offset[1];
+    const int   *entry_wave   = s->entry_wave[1];
+    const FLOAT *entry_weight = s->entry_weight[1];
+    const FLOAT *table        = s->table[1];
+    
+#pragma acc kernels present(cell_index, cell_keep, cell_offset, entry_wave, entry_weight, table, hz)
+#pragma acc loop independent
+    for (int c=0; c<nc; c++) {
+        FLOAT h = 0.0;
+        for (int k=cell_offset[c]; k<cell_offset[c+1]; k++) {
+            h += entry_weight[k]*table[entry_wave[k]*nw + n];
+        }
+        const int ix = cell_index[c];
+        hz[ix] = cell_keep[c]*hz[ix] + h;
+    }
+}
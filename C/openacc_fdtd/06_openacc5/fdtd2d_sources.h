@@ -17,8 +17,77 @@
 #include <stdio.h>
 #include "config.h"
 
-void plane_wave_incidence(const struct Range *whole, const struct Range *inside, 
-                          FLOAT time, int jpos, FLOAT wavelength, FLOAT *ex, FLOAT *ey);
+enum WaveformType {
+    WAVEFORM_SINUSOID           = 0, // a*sin(2*pi*freq*(t-t0) + phase), zero before t0
+    WAVEFORM_GAUSSIAN           = 1, // a*exp(-((t-t0)/tau)^2)
+    WAVEFORM_MODULATED_GAUSSIAN = 2, // gaussian * sin(2*pi*freq*(t-t0) + phase)
+    WAVEFORM_RICKER             = 3  // second derivative of gaussian, no DC (dipole feed)
+};
+
+// Double whatever FLOAT is: freq*t reaches many periods in long runs
+struct Waveform {
+    int    type;
+    double amplitude;
+    double freq;  // [Hz]
+    double t0;    // [sec]
+    double tau;   // [sec]
+    double phase; // [rad]
+};
+
+/**
+ * @brief Set of point sources injected with one kernel per half step
+ *
+ * Sources are registered with global cell indices.  sources_setup() keeps
+ * the cells owned by this rank, sorts them by (component, cell) and merges
+ * the contributions to the same cell, so that the injection kernel is a
+ * race-free gather over a sorted index list.  Waveforms are evaluated on
+ * the host into tables of nwindow steps, which are refilled when the
+ * time step leaves the current window.  The times of the tables are
+ * step*dt in double, never a running sum, so that single precision
+ * fields do not drift in phase over long runs.
+ */
+struct Sources {
+    // Registered sources (global indices)
+    int nwaveforms;
+    int nwaveforms_max;
+    struct Waveform *waveforms;
+
+    int npoints;
+    int npoints_max;
+    int   *point_i;
+    int   *point_j;
+    int   *point_comp;
+    int   *point_wave;
+    int   *point_hard;
+    FLOAT *point_weight;
+
+    // Local injection lists (built by sources_setup)
+    double dt;
+    int   nwindow;
+    int   window_begin;    // first step held in the tables
+    int   ncells[2];       // [0]: ex/ey cells, [1]: hz cells
+    int   nentries[2];
+    int   *cell_index[2];  // sorted local index, ex/ey list is ordered ex first
+    int   *cell_comp[2];
+    FLOAT *cell_keep[2];   // 0.0 for hard sources, 1.0 for soft sources
+    int   *cell_offset[2]; // CSR offsets into entries (ncells+1)
+    int   *entry_wave[2];
+    FLOAT *entry_weight[2];
+    FLOAT *table[2];       // [nwaveforms][nwindow], E at n*dt, H at (n+0.5)*dt
+};
+
+void sources_init(struct Sources *s);
+void sources_free(struct Sources *s);
+int  sources_add_waveform(struct Sources *s, const struct Waveform *w);
+void sources_add_point(struct Sources *s, int comp, int i, int j, int wave, FLOAT weight, int hard);
+void sources_add_line(struct Sources *s, int comp, int i0, int j0, int i1, int j1,
+                      int wave, FLOAT weight, int hard);
+void sources_setup(struct Sources *s, const struct Range *whole, const struct Range *inside,
+                   double dt, int nwindow);
+double waveform_value(const struct Waveform *w, double time);
+
+void inject_sources_e(struct Sources *s, int step, FLOAT *ex, FLOAT *ey);
+void inject_sources_h(struct Sources *s, int step, FLOAT *hz);
 
 #endif /* FDTD2D_SOURCES_H */
 
@@ -0,0 +1,140 @@
+/**
+ * @file fdtd2d_tune.c
+ * @brief Tiles of the FDTD kernels tuned for the subdomain of this rank
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#include "fdtd2d_tune.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "fdtd2d.h"
+#include "autotune.h"
+
+struct TuneArrays {
+    const struct Range *whole;
+    const struct Range *inside;
+    FLOAT *ex, *ey, *hz, *cexly, *ceylx, *chzlx, *chzly;
+};
+
+static void run_calc_ex_ey(const int tile[2], void *arg)
+{
+    struct TuneArrays *a = (struct TuneArrays *)arg;
+    fdtd2d_set_tile(TILE_CALC_EX_EY, tile);
+    calc_ex_ey(a->whole, a->inside, a->hz, a->cexly, a->ceylx, a->ex, a->ey);
+}
+
+static void run_calc_hz(const int tile[2], void *arg)
+{
+    struct TuneArrays *a = (struct TuneArrays *)arg;
+    fdtd2d_set_tile(TILE_CALC_HZ, tile);
+    calc_hz(a->whole, a->inside, a->ey, a->ex, a->chzlx, a->chzly, a->hz);
+}
+
+void fdtd2d_tune(const struct Range *whole, const struct Range *inside, int mode, const char *db)
+{
+    if (mode == AUTOTUNE_OFF) return;
+
+    int rank = 0;
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if (initialized) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    }
+
+    // Tiles along x and y; the warm-up and the timed calls of each candidate
+    const int xs[] = { 1024, 256, 128, 64, 32 };
+    const int ys[] = { 64, 16, 4, 1 };
+    const int nwarmup = 2;
+    const int nrep    = 5;
+
+    char device[256];
+    autotune_device(device, sizeof(device));
+    char size[64];
+    snprintf(size, sizeof(size), "%dx%d/%s", inside->length[0], inside->length[1],
+             sizeof(FLOAT) == sizeof(float) ? "float" : "double");
+
+    const int    nelems = whole->length[0] * whole->length[1];
+    struct TuneArrays a;
+    a.whole  = whole;
+    a.inside = inside;
+    a.ex     = (FLOAT *)calloc(nelems, sizeof(FLOAT));
+    a.ey     = (FLOAT *)calloc(nelems, sizeof(FLOAT));
+    a.hz     = (FLOAT *)calloc(nelems, sizeof(FLOAT));
+    a.cexly  = (FLOAT *)calloc(nelems, sizeof(FLOAT));
+    a.ceylx  = (FLOAT *)calloc(nelems, sizeof(FLOAT));
+    a.chzlx  = (FLOAT *)calloc(whole->length[0], sizeof(FLOAT));
+    a.chzly  = (FLOAT *)calloc(whole->length[1], sizeof(FLOAT));
+    FLOAT *ex = a.ex, *ey = a.ey, *hz = a.hz, *cexly = a.cexly, *ceylx = a.ceylx;
+    FLOAT *chzlx = a.chzlx, *chzly = a.chzly;
+    const int nx = whole->length[0];
+    const int ny = whole->length[1];
+
+    static const char *const names[TILE_NKERNELS] = { "calc_ex_ey", "calc_hz" };
+    void (*const runs[TILE_NKERNELS])(const int tile[2], void *arg) = { run_calc_ex_ey, run_calc_hz };
+
+#pragma acc data copyin(ex[0:nelems], ey[0:nelems], hz[0:nelems], cexly[0:nelems], ceylx[0:nelems], chzlx[0:nx], chzly[0:ny])
+    {
+        for (int k=0; k<TILE_NKERNELS; k++) {
+            const int extent[2] = { inside->length[0] + 1, inside->length[1] + 1 };
+            int tiles[AUTOTUNE_MAX_CANDIDATES][2];
+            const int ncandidates = autotune_candidates(extent, sizeof(xs)/sizeof(xs[0]), xs,
+                                                        sizeof(ys)/sizeof(ys[0]), ys, tiles);
+
+            int tile[2] = { 0, 0 };
+            int found = 0;
+            if (rank == 0 && mode == AUTOTUNE_AUTO) {
+                found = autotune_lookup(db, device, names[k], size, tile);
+            }
+            if (initialized) {
+                MPI_Bcast(&found, 1, MPI_INT, 0, MPI_COMM_WORLD);
+                MPI_Bcast(tile, 2, MPI_INT, 0, MPI_COMM_WORLD);
+            }
+
+            if (found) {
+                if (rank == 0) {
+                    fprintf(stdout, "autotune: %s %s: tile %d x %d (%s)\n", names[k], size, tile[0], tile[1], db);
+                }
+            } else {
+                // All the ranks time the same candidates; the slowest rank counts
+                int    best      = 0;
+                double best_time = 1.0e30;
+                double base_time = 0.0;
+                for (int c=0; c<ncandidates; c++) {
+                    double t = autotune_time(runs[k], &a, tiles[c], nwarmup, nrep);
+                    if (initialized) {
+                        MPI_Allreduce(MPI_IN_PLACE, &t, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+                    }
+                    if (c == 0) base_time = t;
+                    if (t < best_time) {
+                        best_time = t;
+                        best      = c;
+                    }
+                }
+                tile[0] = tiles[best][0];
+                tile[1] = tiles[best][1];
+                if (rank == 0) {
+                    fprintf(stdout, "autotune: %s %s: tile %d x %d, %.1f [usec] (untiled %.1f [usec], %d candidates)\n",
+                            names[k], size, tile[0], tile[1], best_time*1.0e6, base_time*1.0e6, ncandidates);
+                    autotune_store(db, device, names[k], size, tile, best_time);
+                }
+            }
+            fdtd2d_set_tile(k, tile);
+        }
+    }
+
+    free(a.ex);
+    free(a.ey);
+    free(a.hz);
+    free(a.cexly);
+    free(a.ceylx);
+    free(a.chzlx);
+    free(a.chzly);
+}
@@ -0,0 +1,32 @@
+/**
+ * @file fdtd2d_tune.h
+ * @brief Tiles of the FDTD kernels tuned for the subdomain of this rank
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#ifndef FDTD2D_TUNE_H
+#define FDTD2D_TUNE_H
+
+#include <stdio.h>
+#include "config.h"
+
+/**
+ * @brief set the tiles of calc_ex_ey and calc_hz (fdtd2d_set_tile)
+ *
+ * mode is AUTOTUNE_OFF, AUTOTUNE_AUTO or AUTOTUNE_FORCE (autotune.h).  The
+ * candidates are timed on scratch arrays of the size of whole, so the
+ * fields are not touched.  Collective over MPI_COMM_WORLD when MPI is
+ * initialized: rank 0 looks the tiles up in db and stores them, the time
+ * of a candidate is the one of the slowest rank, and every rank gets the
+ * same tiles.
+ */
+void fdtd2d_tune(const struct Range *whole, const struct Range *inside, int mode, const char *db);
+
+#endif /* FDTD2D_TUNE_H */
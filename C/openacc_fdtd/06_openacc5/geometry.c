@@ -0,0 +1,423 @@
+/**
+ * @file geometry.c
+ * @brief Geometry description and voxelization
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$ 
+ */
+
+#include "geometry.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "setup.h"
+
+void geometry_init(struct Geometry *g)
+{
+    memset(g, 0, sizeof(struct Geometry));
+}
+
+void geometry_free(struct Geometry *g)
+{
+    free(g->primitives);
+    free(g->vertices);
+    free(g->pixels);
+    free(g->materials);
+    free(g->material_id);
+    free(g->refinements);
+    free(g->gradings);
+    geometry_init(g);
+}
+
+static bool next_double(char **saveptr, double *v)
+{
+    const char *tok = strtok_r(NULL, " \t\r\n", saveptr);
+    if (tok == NULL) return false;
+    char *end;
+    *v = strtod(tok, &end);
+    return *end == '\0';
+}
+
+static bool read_pgm(const char *filename, int *width, int *height, unsigned char **data)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) return false;
+
+    char magic[3] = { 0 };
+    int  maxval = 0;
+    if (fscanf(fp, "%2s", magic) != 1 ||
+        (strcmp(magic, "P5") != 0 && strcmp(magic, "P2") != 0)) {
+        fclose(fp);
+        return false;
+    }
+    // Header fields, skipping comments
+    int v[3];
+    for (int k=0; k<3; k++) {
+        int ch;
+        while ((ch = fgetc(fp)) != EOF) {
+            if (ch == '#') {
+                while ((ch = fgetc(fp)) != EOF && ch != '\n');
+            } else if (ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n') {
+                ungetc(ch, fp);
+                break;
+            }
+        }
+        if (fscanf(fp, "%d", &v[k]) != 1) {
+            fclose(fp);
+            return false;
+        }
+    }
+    *width  = v[0];
+    *height = v[1];
+    maxval  = v[2];
+    if (*width <= 0 || *height <= 0 || maxval <= 0 || maxval > 255) {
+        fclose(fp);
+        return false;
+    }
+    
+    const size_t n = (size_t)(*width)*(*height);
+    *data = (unsigned char *)malloc(n);
+    bool ok = true;
+    if (magic[1] == '5') {
+        fgetc(fp); // single white space after maxval
+        ok = fread(*data, 1, n, fp) == n;
+    } else {
+        for (size_t k=0; k<n && ok; k++) {
+            int p;
+            ok = fscanf(fp, "%d", &p) == 1;
+            (*data)[k] = (unsigned char)p;
+        }
+    }
+    fclose(fp);
+    
+    if (!ok) {
+        free(*data);
+        *data = NULL;
+    }
+    return ok;
+}
+
+static struct Primitive *new_primitive(struct Geometry *g, int type)
+{
+    g->primitives = (struct Primitive *)realloc(g->primitives, sizeof(struct Primitive)*(g->nprimitives + 1));
+    struct Primitive *p = &g->primitives[g->nprimitives++];
+    memset(p, 0, sizeof(struct Primitive));
+    p->type = type;
+    return p;
+}
+
+static bool parse_attribute(struct Geometry *g, struct Primitive *p, char **saveptr)
+{
+    const char *tok = strtok_r(NULL, " \t\r\n", saveptr);
+    if (tok == NULL) return false;
+
+    double v;
+    if (strcmp(tok, "pec") == 0) {
+        p->attribute = ATTRIBUTE_PEC;
+    } else if (strcmp(tok, "er") == 0) {
+        if (!next_double(saveptr, &v)) return false;
+        p->attribute = ATTRIBUTE_ER;
+        p->er        = v;
+    } else if (strcmp(tok, "material") == 0) {
+        if (!next_double(saveptr, &v)) return false;
+        p->attribute = ATTRIBUTE_MATERIAL;
+        p->material  = (int)v;
+        if (p->material < 1 || p->material > g->nmaterials) return false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool parse_material(struct Geometry *g, char **saveptr)
+{
+    const char *type = strtok_r(NULL, " \t\r\n", saveptr);
+    if (type == NULL) return false;
+
+    struct Material m;
+    memset(&m, 0, sizeof(struct Material));
+    m.eps_inf = 1.0;
+    
+    if      (strcmp(type, "dielectric") == 0) m.type = MATERIAL_DIELECTRIC;
+    else if (strcmp(type, "drude"     ) == 0) m.type = MATERIAL_DRUDE;
+    else if (strcmp(type, "lorentz"   ) == 0) m.type = MATERIAL_LORENTZ;
+    else return false;
+
+    const char *key;
+    while ((key = strtok_r(NULL, " \t\r\n", saveptr)) != NULL) {
+        double v;
+        if (!next_double(saveptr, &v)) return false;
+        if      (strcmp(key, "eps_inf"  ) == 0) m.eps_inf   = v;
+        else if (strcmp(key, "sigma"    ) == 0) m.sigma     = v;
+        else if (strcmp(key, "omega_p"  ) == 0) m.omega_p   = v;
+        else if (strcmp(key, "delta_eps") == 0) m.delta_eps = v;
+        else if (strcmp(key, "omega_0"  ) == 0) m.omega_0   = v;
+        else if (strcmp(key, "gamma"    ) == 0) m.gamma     = v;
+        else return false;
+    }
+
+    g->materials = (struct Material *)realloc(g->materials, sizeof(struct Material)*(g->nmaterials + 1));
+    g->materials[g->nmaterials++] = m;
+    return true;
+}
+
+bool geometry_load(struct Geometry *g, const char *filename)
+{
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", filename);
+        return false;
+    }
+
+    double scale = 1.0;
+    char line[4096];
+    int  lineno = 0;
+    bool ok = true;
+    
+    while (ok && fgets(line, sizeof(line), fp) != NULL) {
+        lineno++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+
+        char *saveptr;
+        const char *cmd = strtok_r(line, " \t\r\n", &saveptr);
+        if (cmd == NULL) continue;
+
+        double v[4];
+        if (strcmp(cmd, "scale") == 0) {
+            ok = next_double(&saveptr, &scale);
+        } else if (strcmp(cmd, "material") == 0) {
+            ok = parse_material(g, &saveptr);
+        } else if (strcmp(cmd, "box") == 0) {
+            ok = next_double(&saveptr, &v[0]) && next_double(&saveptr, &v[1]) &&
+                 next_double(&saveptr, &v[2]) && next_double(&saveptr, &v[3]);
+            if (ok) {
+                struct Primitive *p = new_primitive(g, PRIMITIVE_BOX);
+                p->bbox[0] = scale*fmin(v[0], v[2]);
+                p->bbox[1] = scale*fmin(v[1], v[3]);
+                p->bbox[2] = scale*fmax(v[0], v[2]);
+                p->bbox[3] = scale*fmax(v[1], v[3]);
+                ok = parse_attribute(g, p, &saveptr);
+            }
+        } else if (strcmp(cmd, "circle") == 0) {
+            ok = next_double(&saveptr, &v[0]) && next_double(&saveptr, &v[1]) &&
+                 next_double(&saveptr, &v[2]);
+            if (ok) {
+                struct Primitive *p = new_primitive(g, PRIMITIVE_CIRCLE);
+                p->param[0] = scale*v[0];
+                p->param[1] = scale*v[1];
+                p->param[2] = scale*v[2];
+                p->bbox[0]  = p->param[0] - p->param[2];
+                p->bbox[1]  = p->param[1] - p->param[2];
+                p->bbox[2]  = p->param[0] + p->param[2];
+                p->bbox[3]  = p->param[1] + p->param[2];
+                ok = parse_attribute(g, p, &saveptr);
+            }
+        } else if (strcmp(cmd, "polygon") == 0) {
+            ok = next_double(&saveptr, &v[0]) && v[0] >= 3;
+            if (ok) {
+                const int n = (int)v[0];
+                g->vertices = (double *)realloc(g->vertices, sizeof(double)*2*(g->nvertices + n));
+                double *xy = &g->vertices[2*g->nvertices];
+                for (int k=0; k<2*n && ok; k++) {
+                    ok = next_double(&saveptr, &xy[k]);
+                    xy[k] *= scale;
+                }
+            }
+            if (ok) {
+                const int n = (int)v[0];
+                const double *xy = &g->vertices[2*g->nvertices];
+                struct Primitive *p = new_primitive(g, PRIMITIVE_POLYGON);
+                p->offset  = g->nvertices;
+                p->n[0]    = n;
+                p->bbox[0] = p->bbox[2] = xy[0];
+                p->bbox[1] = p->bbox[3] = xy[1];
+                for (int k=1; k<n; k++) {
+                    p->bbox[0] = fmin(p->bbox[0], xy[2*k  ]);
+                    p->bbox[1] = fmin(p->bbox[1], xy[2*k+1]);
+                    p->bbox[2] = fmax(p->bbox[2], xy[2*k  ]);
+                    p->bbox[3] = fmax(p->bbox[3], xy[2*k+1]);
+                }
+                g->nvertices += n;
+                ok = parse_attribute(g, p, &saveptr);
+            }
+        } else if (strcmp(cmd, "mask") == 0) {
+            const char *image = strtok_r(NULL, " \t\r\n", &saveptr);
+            ok = image != NULL &&
+                 next_double(&saveptr, &v[0]) && next_double(&saveptr, &v[1]) &&
+                 next_double(&saveptr, &v[2]) && next_double(&saveptr, &v[3]);
+            int w, h;
+            unsigned char *data = NULL;
+            if (ok && !read_pgm(image, &w, &h, &data)) {
+                fprintf(stderr, "Error: cannot read %s\n", image);
+                ok = false;
+            }
+            if (ok) {
+                g->pixels = (unsigned char *)realloc(g->pixels, g->npixels + (size_t)w*h);
+                memcpy(&g->pixels[g->npixels], data, (size_t)w*h);
+                free(data);
+                
+                struct Primitive *p = new_primitive(g, PRIMITIVE_MASK);
+                p->offset  = g->npixels;
+                p->n[0]    = w;
+                p->n[1]    = h;
+                p->bbox[0] = scale*fmin(v[0], v[2]);
+                p->bbox[1] = scale*fmin(v[1], v[3]);
+                p->bbox[2] = scale*fmax(v[0], v[2]);
+                p->bbox[3] = scale*fmax(v[1], v[3]);
+                g->npixels += w*h;
+                ok = parse_attribute(g, p, &saveptr);
+            }
+        } else if (strcmp(cmd, "refine") == 0) {
+            double ratio;
+            ok = next_double(&saveptr, &v[0]) && next_double(&saveptr, &v[1]) &&
+                 next_double(&saveptr, &v[2]) && next_double(&saveptr, &v[3]) &&
+                 next_double(&saveptr, &ratio) && ratio >= 2 && ratio <= 4;
+            if (ok) {
+                g->refinements = (struct Refinement *)realloc(g->refinements, sizeof(struct Refinement)*(g->nrefinements + 1));
+                struct Refinement *f = &g->refinements[g->nrefinements++];
+                f->bbox[0] = scale*fmin(v[0], v[2]);
+                f->bbox[1] = scale*fmin(v[1], v[3]);
+                f->bbox[2] = scale*fmax(v[0], v[2]);
+                f->bbox[3] = scale*fmax(v[1], v[3]);
+                f->ratio   = (int)ratio;
+            }
+        } else if (strcmp(cmd, "grade") == 0) {
+            const char *axis = strtok_r(NULL, " \t\r\n", &saveptr);
+            ok = axis != NULL && (strcmp(axis, "x") == 0 || strcmp(axis, "y") == 0) &&
+                 next_double(&saveptr, &v[0]) && next_double(&saveptr, &v[1]) &&
+                 next_double(&saveptr, &v[2]) && v[0] < v[1] && v[2] > 0.0;
+            if (ok) {
+                if (!next_double(&saveptr, &v[3])) v[3] = v[2];
+                ok = v[3] > 0.0;
+            }
+            if (ok) {
+                g->gradings = (struct Grading *)realloc(g->gradings, sizeof(struct Grading)*(g->ngradings + 1));
+                struct Grading *f = &g->gradings[g->ngradings++];
+                f->axis = axis[0] == 'x' ? 0 : 1;
+                f->i0   = (int)v[0];
+                f->i1   = (int)v[1];
+                f->d0   = scale*v[2];
+                f->d1   = scale*v[3];
+            }
+        } else {
+            ok = false;
+        }
+        
+        if (!ok) {
+            fprintf(stderr, "Error: %s:%d: invalid line\n", filename, lineno);
+        }
+    }
+    fclose(fp);
+    
+    return ok;
+}
+
+void geometry_register_materials(struct Geometry *g, struct Dispersive *d)
+{
+    g->material_id = (int *)realloc(g->material_id, sizeof(int)*(g->nmaterials + 1));
+    g->material_id[0] = 0;
+    for (int k=0; k<g->nmaterials; k++) {
+        g->material_id[k+1] = dispersive_add_material(d, &g->materials[k]);
+    }
+}
+
+void geometry_voxelize(const struct Geometry *g, const struct Range *whole,
+                       const struct Mesh *mesh, unsigned int *obj_mask, FLOAT *er, unsigned char *mat)
+{
+    const int n   = whole->length[0]*whole->length[1];
+    const int nw  = OBJECT_MASK_NWORDS(n);
+    const int lnx = whole->length[0];
+    const int bw0 = whole->begin[0];
+    const int bw1 = whole->begin[1];
+    const int ew0 = whole->begin[0] + whole->length[0];
+    const int ew1 = whole->begin[1] + whole->length[1];
+    
+    const int    nv       = 2*g->nvertices + 1;
+    const int    np       = g->npixels + 1;
+    const double *vertices = g->vertices != NULL ? g->vertices : (const double *)&g->nvertices;
+    const unsigned char *pixels = g->pixels != NULL ? g->pixels : (const unsigned char *)&g->npixels;
+    const double *xc  = mesh->xc[0];
+    const double *yc  = mesh->xc[1];
+    const int     mb0 = mesh->whole.begin[0];
+    const int     mb1 = mesh->whole.begin[1];
+    
+#pragma acc data copy(obj_mask[0:nw], er[0:n], mat[0:n]) copyin(vertices[0:nv], pixels[0:np])
+    {
+    for (int k=0; k<g->nprimitives; k++) {
+        const struct Primitive *p = &g->primitives[k];
+
+        // Cells whose center is in the bounding box of the primitive
+        int ib, ie, jb, je;
+        mesh_cell_range(mesh, 0, p->bbox[0], p->bbox[2], &ib, &ie);
+        mesh_cell_range(mesh, 1, p->bbox[1], p->bbox[3], &jb, &je);
+        ib = ib > bw0 ? ib : bw0;
+        jb = jb > bw1 ? jb : bw1;
+        ie = ie < ew0 - 1 ? ie : ew0 - 1;
+        je = je < ew1 - 1 ? je : ew1 - 1;
+        if (ib > ie || jb > je) continue;
+
+        const int    type      = p->type;
+        const int    attribute = p->attribute;
+        const FLOAT  er_value  = p->er;
+        const unsigned char mat_value = g->material_id != NULL && attribute == ATTRIBUTE_MATERIAL ? g->material_id[p->material] : 0;
+        const double x0 = p->bbox[0], y0 = p->bbox[1], x1 = p->bbox[2], y1 = p->bbox[3];
+        const double cx = p->param[0], cy = p->param[1], r2 = p->param[2]*p->param[2];
+        const int    offset = p->offset;
+        const int    n0     = p->n[0];
+        const int    n1     = p->n[1];
+
+#pragma acc kernels present(obj_mask, er, mat, vertices, pixels, xc, yc)
+#pragma acc loop independent
+        for (int j=jb; j<=je; j++) {
+#pragma acc loop independent
+            for (int i=ib; i<=ie; i++) {
+                const double x = xc[i - mb0];
+                const double y = yc[j - mb1];
+                
+                int inside = 0;
+                if (type == PRIMITIVE_BOX) {
+                    inside = 1;
+                } else if (type == PRIMITIVE_CIRCLE) {
+                    inside = (x - cx)*(x - cx) + (y - cy)*(y - cy) <= r2;
+                } else if (type == PRIMITIVE_POLYGON) {
+                    // Even-odd rule
+                    for (int a=0, b=n0-1; a<n0; b=a++) {
+                        const double xa = vertices[2*(offset + a)], ya = vertices[2*(offset + a) + 1];
+                        const double xb = vertices[2*(offset + b)], yb = vertices[2*(offset + b) + 1];
+                        if ((ya > y) != (yb > y) && x < (xb - xa)*(y - ya)/(yb - ya) + xa) {
+                            inside = !inside;
+                        }
+                    }
+                } else if (type == PRIMITIVE_MASK) {
+                    const int u = (int)fmin((x - x0)/(x1 - x0)*n0, n0 - 1.0);
+                    const int v = (int)fmin((y1 - y)/(y1 - y0)*n1, n1 - 1.0);
+                    inside = pixels[offset + v*n0 + u] > 127;
+                }
+                if (!inside) continue;
+
+                const int ix = (j - bw1)*lnx + (i - bw0);
+                // Cells of a word of the mask are updated by different iterations
+                if (attribute == ATTRIBUTE_PEC) {
+#pragma acc atomic update
+                    OBJECT_MASK_SET(obj_mask, ix);
+                } else if (attribute == ATTRIBUTE_ER) {
+#pragma acc atomic update
+                    OBJECT_MASK_CLEAR(obj_mask, ix);
+                    er [ix] = er_value;
+                    mat[ix] = 0;
+                } else {
+#pragma acc atomic update
+                    OBJECT_MASK_CLEAR(obj_mask, ix);
+                    mat[ix] = mat_value;
+                }
+            }
+        }
+    }
+    }
+}
@@ -0,0 +1,108 @@
+/**
+ * @file geometry.h
+ * @brief Geometry description and voxelization
+ *
+ * Geometry file (one item per line, '#' starts a comment, lengths in
+ * meters multiplied by the current scale):
+ *
+ *   scale    <factor>
+ *   material dielectric eps_inf <v> [sigma <v>]
+ *   material drude      eps_inf <v> omega_p <v> gamma <v> [sigma <v>]
+ *   material lorentz    eps_inf <v> delta_eps <v> omega_0 <v> gamma <v> [sigma <v>]
+ *   box      <x0> <y0> <x1> <y1>           <attribute>
+ *   circle   <cx> <cy> <r>                 <attribute>
+ *   polygon  <n> <x1> <y1> ... <xn> <yn>   <attribute>
+ *   mask     <file.pgm> <x0> <y0> <x1> <y1> <attribute>
+ *   refine   <x0> <y0> <x1> <y1> <ratio>
+ *   grade    <x|y> <i0> <i1> <d0> [<d1>]
+ *
+ * where <attribute> is one of
+ *   pec            : perfect conductor (obj = 1)
+ *   er <v>         : relative permittivity (obj = 0, no material)
+ *   material <k>   : k-th material of the file (obj = 0)
+ *
+ * Primitives are applied in the order of the file, so later ones
+ * overwrite earlier ones.  A cell belongs to a primitive when its center
+ * (given by the mesh) is inside.  A mask is an 8-bit PGM image
+ * (P2 or P5) stretched over the box, the first row at y1, and pixels
+ * brighter than 127 are inside.  A refine box is not a primitive: it
+ * places a subgrid patch of the given ratio (2, 3 or 4) on the coarse
+ * cells overlapping the box.  A grade line sets the widths of the cells
+ * i0 .. i1-1 (global indices) along x or y, growing geometrically from
+ * d0 to d1 (d0 if omitted); the other cells keep the uniform spacing.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$ 
+ */
+
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "config.h"
+#include "dispersive.h"
+#include "mesh.h"
+
+enum PrimitiveType {
+    PRIMITIVE_BOX     = 0,
+    PRIMITIVE_CIRCLE  = 1,
+    PRIMITIVE_POLYGON = 2,
+    PRIMITIVE_MASK    = 3
+};
+
+enum AttributeType {
+    ATTRIBUTE_PEC      = 0,
+    ATTRIBUTE_ER       = 1,
+    ATTRIBUTE_MATERIAL = 2
+};
+
+struct Primitive {
+    int    type;
+    double bbox[4];  // x0, y0, x1, y1
+    double param[3]; // circle: cx, cy, r
+    int    offset;   // polygon: first vertex, mask: first pixel
+    int    n[2];     // polygon: number of vertices, mask: width, height
+    int    attribute;
+    FLOAT  er;
+    int    material; // index in the file, from 1
+};
+
+struct Refinement {
+    double bbox[4];  // x0, y0, x1, y1
+    int    ratio;
+};
+
+struct Grading {
+    int    axis;
+    int    i0, i1;
+    double d0, d1;
+};
+
+struct Geometry {
+    int nprimitives;
+    struct Primitive *primitives;
+    int    nvertices;
+    double *vertices; // x, y pairs
+    int    npixels;
+    unsigned char *pixels;
+    int    nmaterials;
+    struct Material *materials;
+    int    *material_id; // id given by dispersive_add_material()
+    int    nrefinements;
+    struct Refinement *refinements;
+    int    ngradings;
+    struct Grading *gradings;
+};
+
+void geometry_init(struct Geometry *g);
+void geometry_free(struct Geometry *g);
+bool geometry_load(struct Geometry *g, const char *filename);
+void geometry_register_materials(struct Geometry *g, struct Dispersive *d);
+void geometry_voxelize(const struct Geometry *g, const struct Range *whole,
+                       const struct Mesh *mesh, unsigned int *obj_mask, FLOAT *er, unsigned char *mat);
+
+#endif /* GEOMETRY_H */
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <openacc.h>
+#include "config.h"
+#include "setup.h"
+#include "fdtd2d.h"
+#include "fdtd2d_sources.h"
+#include "dft_monitor.h"
+#include "dispersive.h"
+#include "geometry.h"
+#include "subgrid.h"
+#include "mesh.h"
+#include "stats.h"
+#include "params.h"
+#include "ensemble.h"
+#include "fdtd2d_tune.h"
+#include "autotune.h"
+
+bool run_case(struct EnsembleWorkspace *ws, const struct Params *params, int index, struct EnsembleResult *r);
+
+static int ngpus = 0;
+
+// Runs the cases of a sweep file (ensemble.cases) concurrently in one
+// process; the other parameters are the base of every case.
+//
+//   run_ensemble -c base.cfg ensemble.cases=sweep.txt ensemble.threads=8
+//
+// Each case writes its statistics and DFT monitors (dft.<n>.file) with the suffix
+// .<case> (stats.txt.0003, dft_ex.bin.0003); ensemble.txt is the table of the results.
+// The tiles of the kernels are the ones of the process, so with tune.mode the
+// cases are tuned once and must all have the grid (nx, ny, pml) of the base.
+int main(int argc, char *argv[])
+{
+    struct Params params;
+    params_init(&params);
+    if (!params_parse(&params, argc, argv, true)) {
+        return 1;
+    }
+    if (params.ensemble_cases[0] == '\0') {
+        fprintf(stdout, "Error: ensemble.cases (the sweep file) is not given\n");
+        return 1;
+    }
+
+    ngpus = params.backend == BACKEND_HOST ? 0 : acc_get_num_devices(acc_device_nvidia);
+    fprintf(stdout, "num of GPUs = %d\n", ngpus);
+    if (params.backend == BACKEND_GPU && ngpus == 0) {
+        fprintf(stdout, "Error: backend = gpu, but no GPU is found\n");
+        return 1;
+    }
+    if (ngpus == 0 && params.backend == BACKEND_HOST) {
+        acc_set_device_type(acc_device_host);
+    }
+
+    struct Ensemble ensemble;
+    ensemble_init(&ensemble);
+    if (!ensemble_load(&ensemble, &params, params.ensemble_cases)) {
+        ensemble_free(&ensemble);
+        return 1;
+    }
+
+    if (params.tune_mode != AUTOTUNE_OFF) {
+        for (int n=0; n<ensemble.ncases; n++) {
+            const struct Params *c = &ensemble.cases[n];
+            if (c->nx != params.nx || c->ny != params.ny || c->pml != params.pml ||
+                c->tune_mode != params.tune_mode || strcmp(c->tune_db, params.tune_db) != 0) {
+                fprintf(stdout, "Error: case %d (%s) changes the grid or tune.*, but the tiles of tune.mode are shared by the cases\n",
+                        n, ensemble.labels[n]);
+                ensemble_free(&ensemble);
+                return 1;
+            }
+        }
+    }
+
+    fprintf(stdout, "Ensemble\n");
+    fprintf(stdout, "  cases         = %5d\n", ensemble.ncases);
+    fprintf(stdout, "  threads       = %5d\n", params.ensemble_threads);
+    fprintf(stdout, "  sizeof(FLOAT) = %5d\n", (int)sizeof(FLOAT));
+    fprintf(stdout, "Parameters of the base\n");
+    params_write(&params, stdout, "  ");
+
+    // Tiles of calc_ex_ey and calc_hz for the grid of the cases (tune.mode, tune.db)
+    {
+        const int mgn = params.pml;
+        const struct Range inside = { { params.nx, params.ny },
+                                      { 0, 0 } };
+        const struct Range whole  = { { inside.length[0] + 2*mgn + 1, inside.length[1] + 2*mgn + 1},
+                                      { inside.begin[0]  - mgn      , inside.begin[1]  - mgn   } };
+        fdtd2d_tune(&whole, &inside, params.tune_mode, params.tune_db);
+    }
+
+    ensemble_run(&ensemble, params.ensemble_threads, run_case);
+
+    int nfailed = 0;
+    for (int n=0; n<ensemble.ncases; n++) {
+        if (!ensemble.results[n].ok) nfailed++;
+    }
+    fprintf(stdout, "------------------------------\n");
+    fprintf(stdout, "Cases       = %d\n", ensemble.ncases);
+    fprintf(stdout, "Failed      = %d\n", nfailed);
+    fprintf(stdout, "Threads     = %d\n", ensemble.nthreads);
+    fprintf(stdout, "GPU is used = %d\n", ngpus > 0);
+    fprintf(stdout, "Time        = %10.6f [sec]\n", ensemble.elapsed);
+    fprintf(stdout, "------------------------------\n");
+
+    ensemble_write(&ensemble, "ensemble.txt");
+    ensemble_free(&ensemble);
+
+    return nfailed > 0 ? 1 : 0;
+}
+
+// One case of main.c on a single subdomain, without images, snapshots,
+// probes and NTFF; the arrays are the ones of the workspace of the thread
+bool run_case(struct EnsembleWorkspace *ws, const struct Params *params, int index, struct EnsembleResult *r)
+{
+    if (ngpus > 0) {
+        acc_set_device_num(ws->thread % ngpus, acc_device_nvidia);
+    }
+
+    const int mgn = params->pml;
+    const struct Range inside = { { params->nx, params->ny },
+                                  { 0, 0 } };
+    const struct Range whole  = { { inside.length[0] + 2*mgn + 1, inside.length[1] + 2*mgn + 1},
+                                  { inside.begin[0]  - mgn      , inside.begin[1]  - mgn   } };
+
+    const double wavelength = params->wavelength;
+    const FLOAT dx         = params->dx;
+    const FLOAT dy         = params->dy;
+    const int   nt         = params->nt;
+    const char *geometry_file = params->geometry[0] != '\0' ? params->geometry : NULL;
+
+    // The results are the statistics of the last sample: with stats.interval = 0
+    // (the default) only the last step is sampled
+    const int stats_interval = params->stats_interval > 0 ? params->stats_interval : nt;
+    char stats_file[PARAMS_STRING_LEN + 8];
+    snprintf(stats_file, sizeof(stats_file), "%s.%04d", params->stats_file, index);
+    const struct StatsConfig stats_cfg = { stats_interval, params->stats_emax, params->stats_tolerance, stats_file };
+
+    struct Geometry geometry;
+    geometry_init(&geometry);
+    if (geometry_file != NULL) {
+        if (!geometry_load(&geometry, geometry_file)) {
+            return false;
+        }
+    }
+
+    // Mesh: uniform dx, dy, graded by the geometry file; dt from the smallest cells
+    struct Mesh mesh;
+    const double dt = setup_mesh(geometry_file != NULL ? &geometry : NULL, &whole, dx, dy, params->courant, &mesh);
+
+    if (!ensemble_workspace_reserve(ws, whole.length)) {
+        geometry_free(&geometry);
+        mesh_free(&mesh);
+        return false;
+    }
+    FLOAT *ex = ws->ex, *ey = ws->ey, *hz = ws->hz;
+    FLOAT *exy = ws->exy, *eyx = ws->eyx, *hzx = ws->hzx, *hzy = ws->hzy;
+    FLOAT *cexly = ws->cexly, *ceylx = ws->ceylx, *chzlx = ws->chzlx, *chzly = ws->chzly;
+    FLOAT *cexy  = ws->cexy,  *ceyx  = ws->ceyx,  *chzx  = ws->chzx,  *chzy  = ws->chzy;
+    FLOAT *cexyl = ws->cexyl, *ceyxl = ws->ceyxl, *chzxl = ws->chzxl, *chzyl = ws->chzyl;
+    FLOAT *rer_ex = ws->rer_ex, *rer_ey = ws->rer_ey;
+
+    struct Dispersive dispersive;
+    dispersive_init(&dispersive);
+
+    // Media, and subgrid patches on the refine boxes of the geometry with the media at the fine resolution
+    struct Subgrid subgrid;
+    subgrid_init(&subgrid);
+    if (!setup_media(geometry_file != NULL ? &geometry : NULL, &inside, &whole, &inside, &mesh, dt,
+                     &dispersive, &subgrid, ws->obj_mask, ws->er, ws->mat)) {
+        subgrid_free(&subgrid);
+        dispersive_free(&dispersive);
+        geometry_free(&geometry);
+        mesh_free(&mesh);
+        return false;
+    }
+    geometry_free(&geometry);
+
+    init_vars(whole.length, ex, ey, hz);
+    set_initial_condition(&whole, &mesh, dt, constant.e0, ws->er, constant.m0, ws->obj_mask,
+                          cexly, ceylx, chzlx, chzly);
+    dispersive_setup(&dispersive, &whole, &inside, dt, constant.e0, ws->mat, ws->obj_mask, ws->er, cexly, ceylx);
+    init_pml_vars(whole.length, exy, eyx, hzx, hzy);
+    set_pml_initial_condition(&whole, &inside, &mesh, dt, constant.c, constant.e0, constant.m0,
+                              cexy, ceyx, chzx, chzy, cexyl, ceyxl, chzxl, chzyl);
+    set_pml_rer(whole.length, ws->obj_mask, ws->er, rer_ex, rer_ey);
+
+    // Sources: plane wave incidence at j = j_in
+    struct Sources sources;
+    sources_init(&sources);
+    {
+        const struct Waveform wave = { params->source_waveform, params->source_amplitude, constant.c / wavelength,
+                                       params->source_t0, params->source_tau, 0.0 };
+        const int w    = sources_add_waveform(&sources, &wave);
+        const int j_in = inside.begin[1] + params->source_j;
+        const int i0   = inside.begin[0];
+        const int i1   = inside.begin[0] + inside.length[0] - 1;
+        sources_add_line(&sources, FIELD_EX, i0, j_in, i1, j_in, w, 1.0, 1);
+    }
+    sources_setup(&sources, &whole, &inside, dt, 1024);
+
+    // DFT monitors of dft.<n>.component over dft.<n>.region (off when dft.<n>.file is empty)
+    struct DFTMonitor dft[PARAMS_DFT_MAX];
+    for (int n=0; n<PARAMS_DFT_MAX; n++) {
+        const struct ParamsDft *d = &params->dft[n];
+        const double freq0[] = { constant.c / wavelength };
+        const int    nfreq   = d->file[0] == '\0' ? 0 : d->freq.n > 0 ? d->freq.n : 1;
+        struct Range region;
+        params_region(d->region, &inside, &region);
+        dft_monitor_init(&dft[n], d->component, &region, nfreq, d->freq.n > 0 ? d->freq.v : freq0,
+                         &whole, &inside, dt, 1024);
+    }
+
+    // Statistics: the whole domain, and the norms behind the slit
+    struct Stats stats;
+    stats_init(&stats, &stats_cfg, &whole, &inside, &whole, &inside, &mesh, dt,
+               constant.e0, constant.m0, cexy, ceyx, chzx, chzy);
+    stats_add_region(&stats, inside.begin[0], inside.begin[1] + inside.length[1]*3/5,
+                     inside.begin[0] + inside.length[0], inside.begin[1] + inside.length[1]);
+    if (stats.fp != NULL) {
+        params_write(params, stats.fp, "# ");
+    }
+
+    int icnt = 0;
+    double time = 0.0; // from icnt, not a sum of dt: no drift in long runs
+    int status = STATS_RUNNING;
+    while (icnt < nt) {
+
+        dispersive_update_e(&dispersive, ex, ey);
+        calc_ex_ey(&whole, &inside, hz, cexly, ceylx, ex, ey);
+        pml_boundary_ex(&whole, &inside, hz, cexy, cexyl, rer_ex, ex, exy);
+        pml_boundary_ey(&whole, &inside, hz, ceyx, ceyxl, rer_ey, ey, eyx);
+
+        inject_sources_e(&sources, icnt, ex, ey);
+        subgrid_update(&subgrid, ex, ey);
+        dft_monitors_update_e(dft, PARAMS_DFT_MAX, icnt, ex, ey);
+        time = (icnt + 0.5)*dt;
+
+        calc_hz(&whole, &inside, ey, ex, chzlx, chzly, hz);
+        pml_boundary_hz(&whole, &inside, ey, ex, chzx, chzxl, chzy, chzyl, hz, hzx, hzy);
+        inject_sources_h(&sources, icnt, hz);
+        dft_monitors_update_h(dft, PARAMS_DFT_MAX, icnt, hz);
+        time = (icnt + 1)*dt;
+
+        icnt++;
+
+        status = stats_update(&stats, icnt, time, ex, ey, hz, hzx, hzy, rer_ex, rer_ey);
+        if (status != STATS_RUNNING) {
+            break;
+        }
+    }
+
+    r->icnt     = icnt;
+    r->status   = status;
+    r->time     = time;
+    r->energy   = stats.energy;
+    r->absorbed = stats.absorbed;
+    r->emax     = stats.emax;
+    r->norm_e   = stats.norm_e[0];
+
+    for (int n=0; n<PARAMS_DFT_MAX; n++) {
+        char dft_file[PARAMS_STRING_LEN + 8];
+        snprintf(dft_file, sizeof(dft_file), "%s.%04d", params->dft[n].file, index);
+        dft_monitor_write(&dft[n], dft_file);
+        dft_monitor_free(&dft[n]);
+    }
+    stats_free(&stats);
+    dispersive_free(&dispersive);
+    sources_free(&sources);
+    subgrid_free(&subgrid);
+    mesh_free(&mesh);
+
+    return true;
+}
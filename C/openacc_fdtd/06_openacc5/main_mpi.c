@@ -10,11 +10,22 @@
 #include "fdtd2d.h"
 #include "fdtd2d_sources.h"
 #include "output.h"
+#include "dft_monitor.h"
+#include "ntff.h"
+#include "probe.h"
+#include "dispersive.h"
+#include "geometry.h"
+#include "subgrid.h"
+#include "mesh.h"
+#include "snapshot.h"
+#include "sampler.h"
+#include "stats.h"
+#include "perf_counters.h"
+#include "trace.h"
+#include "params.h"
+#include "fdtd2d_tune.h"
 
-void set_object_er(const struct Range *whole,
-                   FLOAT lx, FLOAT ly, FLOAT dx, FLOAT dy, int *obj, FLOAT *er);
 double get_elapsed_time(const struct timeval *tv0, const struct timeval *tv1);
-FLOAT get_dt(FLOAT dx, FLOAT dy);    
 
 int main(int argc, char *argv[])
 {
@@ -26,21 +37,31 @@ int main(int argc, char *argv[])
     MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
-    if (argc != 6) {
-        if (rank == 0) {
-            fprintf(stdout, "%s <nx> <ny> <nsubdomains> <nt> <nout>\n", argv[0]);
-        }
+    struct Params params;
+    params_init(&params);
+    if (!params_parse(&params, argc, argv, rank == 0)) {
         MPI_Finalize();
         return 1;
     }
 
-    const int ngpus = acc_get_num_devices(acc_device_nvidia);
+    PERF_INIT(rank);
+
+    const int ngpus = params.backend == BACKEND_HOST ? 0 : acc_get_num_devices(acc_device_nvidia);
     if (rank == 0) {
         fprintf(stdout, "num of GPUs = %d\n", ngpus);
     }
+    if (params.backend == BACKEND_GPU && ngpus == 0) {
+        if (rank == 0) {
+            fprintf(stdout, "Error: backend = gpu, but no GPU is found\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
     const int gpuid = ngpus > 0 ? rank % ngpus : -1;
     if (gpuid >= 0) {
         acc_set_device_num(gpuid, acc_device_nvidia);
+    } else if (params.backend == BACKEND_HOST) {
+        acc_set_device_type(acc_device_host);
     }
 
     if (rank == 0) {
@@ -58,9 +79,9 @@ int main(int argc, char *argv[])
         fflush(stdout);
     }
 
-    const int mgn = 8;
-    const int nsubdomains            = atoi(argv[3]);
-    const struct Range inside_global = { { atoi(argv[1]), atoi(argv[2]) },
+    const int mgn = params.pml;
+    const int nsubdomains            = params.nsubdomains > 0 ? params.nsubdomains : nprocs;
+    const struct Range inside_global = { { params.nx, params.ny },
                                          { 0, 0 } };
     const struct Range whole_global  = { { inside_global.length[0] + 2*mgn + 1, inside_global.length[1] + 2*mgn + 1},
                                          { inside_global.begin[0]  - mgn      , inside_global.begin[1]  - mgn   } };
@@ -82,18 +103,57 @@ int main(int argc, char *argv[])
     const int rank_up   = rank != nprocs - 1 ? rank + 1 : MPI_PROC_NULL;
     const int rank_down = rank != 0          ? rank - 1 : MPI_PROC_NULL;
 
-    const FLOAT wavelength = 500.0*1.0e-9; // m
-    const FLOAT dx         = 10.0*1.0e-9;
-    const FLOAT dy         = dx;
-    const FLOAT dt         = get_dt(dx, dy);
-    const FLOAT lx         = dx * inside_global.length[0];
-    const FLOAT ly         = dy * inside_global.length[1];
+    const double wavelength = params.wavelength; // m
+    const FLOAT dx         = params.dx;
+    const FLOAT dy         = params.dy;
+
+    // Images (OUTPUT_BMP, OUTPUT_PNG or OUTPUT_Y4M) and field snapshots written every nout steps
+    const struct OutputConfig output_cfg = { params.output_format, params.output_threads, params.output_fps,
+                                             params.output_stream[0] != '\0' ? params.output_stream : NULL };
+    // over a region of interest (global cells i0, j0, i1, j1; empty: whole domain),
+    // one sample per factor x factor cells (SAMPLER_STRIDE or SAMPLER_AVERAGE)
+    const struct SamplerConfig sampler_cfg = { { params.sampler_roi[0], params.sampler_roi[1],
+                                                 params.sampler_roi[2], params.sampler_roi[3] },
+                                               params.sampler_factor, params.sampler_mode };
+    const struct SnapshotConfig snapshot = { params.snapshot_fields, params.snapshot_precision, params.snapshot_tolerance, 0,
+                                             sampler_cfg.factor, sampler_cfg.mode };
+    // Energy, PML absorption and max |E| every interval steps; diverged when max |E| > emax_limit
+    const struct StatsConfig stats_cfg = { params.stats_interval, params.stats_emax, params.stats_tolerance, params.stats_file };
+    // Timeline of the phases of the last capacity events of each rank (Chrome trace JSON)
+    const struct TraceConfig trace_cfg = { params.trace_capacity, params.trace_file };
     
-    const int  nt          = atoi(argv[4]);
-    const int  nout        = atoi(argv[5]);
+    const int  nt          = params.nt;
+    const int  nout        = params.nout;
     const bool output_file = nout <= 0 ? false : true;
+    const char *geometry_file = params.geometry[0] != '\0' ? params.geometry : NULL;
+
+    struct Geometry geometry;
+    geometry_init(&geometry);
+    if (geometry_file != NULL) {
+        if (!geometry_load(&geometry, geometry_file)) {
+            MPI_Finalize();
+            return 1;
+        }
+    }
+
+    // Mesh: uniform dx, dy, graded by the geometry file; dt from the smallest cells
+    struct Mesh mesh;
+    const double dt        = setup_mesh(geometry_file != NULL ? &geometry : NULL, &whole_global, dx, dy, params.courant, &mesh);
+    const FLOAT lx         = mesh_length(&mesh, 0, inside_global.begin[0], inside_global.begin[0] + inside_global.length[0]);
+    const FLOAT ly         = mesh_length(&mesh, 1, inside_global.begin[1], inside_global.begin[1] + inside_global.length[1]);
 
     if (rank == 0) {
+        // The parameters of the run, also in output.config (run.cfg) next to the output
+        fprintf(stdout, "Parameters\n");
+        params_write(&params, stdout, "  ");
+        if (params.output_config[0] != '\0') {
+            FILE *fp = fopen(params.output_config, "w");
+            if (fp != NULL) {
+                params_write(&params, fp, "");
+                fclose(fp);
+            }
+        }
+
         fprintf(stdout, "Calculation condition\n");
         fprintf(stdout, "  nx_global     = %5d\n", inside_global.length[0]);
         fprintf(stdout, "  ny_global     = %5d\n", inside_global.length[1]);
@@ -105,11 +165,13 @@ int main(int argc, char *argv[])
         fprintf(stdout, "  ly            = %5e [m]\n", ly);
         fprintf(stdout, "  dx            = %5e [m]\n", dx);
         fprintf(stdout, "  dy            = %5e [m]\n", dy);
+        fprintf(stdout, "  graded        = %5d\n", mesh.graded);
         fprintf(stdout, "  dt            = %5e [sec]\n", dt);
         fprintf(stdout, "  wl            = %5e\n", wavelength);
         fprintf(stdout, "  nt            = %5d\n", nt);
         fprintf(stdout, "  nout          = %5d\n", nout);
         fprintf(stdout, "  output        = %5d\n", output_file);
+        fprintf(stdout, "  geometry      = %s\n", geometry_file != NULL ? geometry_file : "(built-in)");
         fprintf(stdout, "  sizeof(FLOAT) = %5d\n", sizeof(FLOAT));
     }
     
@@ -119,15 +181,14 @@ int main(int argc, char *argv[])
     const size_t size        = sizeof(FLOAT)*nelems;
     const size_t size_x      = sizeof(FLOAT)*nelems_x;
     const size_t size_y      = sizeof(FLOAT)*nelems_y;
-    const size_t size_global = sizeof(FLOAT)* whole_global.length[0] * whole_global.length[1];
     
     FLOAT *ex    = (FLOAT *)malloc(size);
     FLOAT *ey    = (FLOAT *)malloc(size);
     FLOAT *hz    = (FLOAT *)malloc(size);
     FLOAT *cexly = (FLOAT *)malloc(size);
     FLOAT *ceylx = (FLOAT *)malloc(size);
-    FLOAT *chzlx = (FLOAT *)malloc(size);
-    FLOAT *chzly = (FLOAT *)malloc(size);
+    FLOAT *chzlx = (FLOAT *)malloc(size_x);
+    FLOAT *chzly = (FLOAT *)malloc(size_y);
 
     FLOAT *exy   = (FLOAT *)malloc(size);
     FLOAT *eyx   = (FLOAT *)malloc(size);
@@ -144,45 +205,137 @@ int main(int argc, char *argv[])
     FLOAT *chzxl = (FLOAT *)malloc(size_x);
     FLOAT *chzyl = (FLOAT *)malloc(size_y);
     
-    int   *obj    = (int   *)malloc(sizeof(int)*nelems); // Objects
+    const int nwords = OBJECT_MASK_NWORDS(nelems);
+    unsigned int  *obj_mask = (unsigned int *)malloc(sizeof(unsigned int)*nwords); // Objects, bit-packed
+    unsigned char *mat = (unsigned char *)malloc(sizeof(unsigned char)*nelems); // Lossy and dispersive materials
     FLOAT *er     = (FLOAT *)malloc(size);               // Relative Permittivity
     FLOAT *rer_ex = (FLOAT *)malloc(size);
     FLOAT *rer_ey = (FLOAT *)malloc(size);
 
-    // For output
+    // For output: the fields on the output grid of the sampler, assembled on rank 0
+    struct Sampler sampler;
+    if (!sampler_init(&sampler, &sampler_cfg, &whole_global, &whole, &inside)) {
+        MPI_Finalize();
+        return 1;
+    }
+    struct Range snapshot_region;
+    sampler_region(&sampler, &inside_global, &snapshot_region);
+    const size_t size_global = sizeof(FLOAT)* sampler.out.length[0] * sampler.out.length[1];
     FLOAT *ex_global = (FLOAT *)malloc(size_global);
     FLOAT *ey_global = (FLOAT *)malloc(size_global);
     FLOAT *hz_global = (FLOAT *)malloc(size_global);
 
     
-    init_relative_permittivity(whole.length, 1.0, er); // vacuum
-    init_object(whole.length, obj);
-
-    // User-defined function
-    set_object_er(&whole, lx, ly, dx, dy, obj, er);    
+    struct Dispersive dispersive;
+    dispersive_init(&dispersive);
+
+    // Media, and subgrid patches on the refine boxes of the geometry with the media at the fine resolution
+    struct Subgrid subgrid;
+    subgrid_init(&subgrid);
+    if (!setup_media(geometry_file != NULL ? &geometry : NULL, &inside_global, &whole, &inside, &mesh, dt,
+                     &dispersive, &subgrid, obj_mask, er, mat)) {
+        MPI_Finalize();
+        return 1;
+    }
+    geometry_free(&geometry);
 
 
 #pragma acc data \
     create(ex[0:nelems], ey[0:nelems], hz[0:nelems])                    \
-    create(cexly[0:nelems], ceylx[0:nelems], chzlx[0:nelems], chzly[0:nelems]) \
+    create(cexly[0:nelems], ceylx[0:nelems], chzlx[0:nelems_x], chzly[0:nelems_y]) \
     create(exy[0:nelems], eyx[0:nelems], hzx[0:nelems], hzy[0:nelems])    \
     create(cexy[0:nelems_y], ceyx[0:nelems_x], chzx[0:nelems_x], chzy[0:nelems_y]) \
     create(cexyl[0:nelems_y], ceyxl[0:nelems_x], chzxl[0:nelems_x], chzyl[0:nelems_y]) \
-    copyin(obj[0:nelems], er[0:nelems]) \
     create(rer_ex[0:nelems], rer_ey[0:nelems])
     {
+
+#pragma acc enter data copyin(obj_mask[0:nwords], er[0:nelems])
         
         init_vars(whole.length, ex, ey, hz);
 
-        set_initial_condition(whole.length, dt, dx, dy, constant.e0, er, constant.m0, obj, 
+        set_initial_condition(&whole, &mesh, dt, constant.e0, er, constant.m0, obj_mask, 
                               cexly, ceylx, chzlx, chzly);
+        dispersive_setup(&dispersive, &whole, &inside, dt, constant.e0, mat, obj_mask, er, cexly, ceylx);
         
         init_pml_vars(whole.length, exy, eyx, hzx, hzy);
-        set_pml_initial_condition(&whole, &inside, dt, dx, dy, constant.c, constant.e0, constant.m0,
+        set_pml_initial_condition(&whole, &inside, &mesh, dt, constant.c, constant.e0, constant.m0,
                                   cexy, ceyx, chzx, chzy, cexyl, ceyxl, chzxl, chzyl);
-        set_pml_rer(whole.length, obj, er, rer_ex, rer_ey);
+        set_pml_rer(whole.length, obj_mask, er, rer_ex, rer_ey);
+
+        // The objects, permittivity and materials are folded into the coefficients
+#pragma acc exit data delete(obj_mask[0:nwords], er[0:nelems])
+        free(obj_mask);
+        free(mat);
+        free(er);
     
-        init_vars(whole_global.length, ex_global, ey_global, hz_global);
+        init_vars(sampler.out.length, ex_global, ey_global, hz_global);
+
+        // Sources: plane wave incidence at j = j_in
+        struct Sources sources;
+        sources_init(&sources);
+        {
+            const struct Waveform wave = { params.source_waveform, params.source_amplitude, constant.c / wavelength,
+                                           params.source_t0, params.source_tau, 0.0 };
+            const int w    = sources_add_waveform(&sources, &wave);
+            const int j_in = inside_global.begin[1] + params.source_j;
+            const int i0   = inside_global.begin[0];
+            const int i1   = inside_global.begin[0] + inside_global.length[0] - 1;
+            sources_add_line(&sources, FIELD_EX, i0, j_in, i1, j_in, w, 1.0, 1);
+        }
+        sources_setup(&sources, &whole, &inside, dt, 1024);
+
+        // DFT monitors of dft.<n>.component over dft.<n>.region (off when dft.<n>.file is empty)
+        struct DFTMonitor dft[PARAMS_DFT_MAX];
+        for (int n=0; n<PARAMS_DFT_MAX; n++) {
+            const struct ParamsDft *d = &params.dft[n];
+            const double freq0[] = { constant.c / wavelength };
+            const int    nfreq   = d->file[0] == '\0' ? 0 : d->freq.n > 0 ? d->freq.n : 1;
+            struct Range region;
+            params_region(d->region, &inside_global, &region);
+            dft_monitor_init(&dft[n], d->component, &region, nfreq, d->freq.n > 0 ? d->freq.v : freq0,
+                             &whole, &inside, dt, 1024);
+        }
+
+        // Near-to-far-field transformation on a contour ntff.offset cells inside the PML
+        // (off when ntff.file is empty)
+        struct NTFF ntff;
+        {
+            const double freq0[] = { constant.c / wavelength };
+            const int    nfreq   = params.ntff_file[0] == '\0' ? 0 : params.ntff_freq.n > 0 ? params.ntff_freq.n : 1;
+            const int    offset  = params.ntff_offset;
+            const int i0 = inside_global.begin[0] + offset;
+            const int j0 = inside_global.begin[1] + offset;
+            const int i1 = inside_global.begin[0] + inside_global.length[0] - offset;
+            const int j1 = inside_global.begin[1] + inside_global.length[1] - offset;
+            ntff_init(&ntff, i0, j0, i1, j1, nfreq, params.ntff_freq.n > 0 ? params.ntff_freq.v : freq0,
+                      &whole, &inside, &mesh, dt);
+        }
+
+        // Probes of probe.points and probe.lines; a rank with none of them writes nothing
+        struct Probes probes;
+        probes_init(&probes);
+        {
+            probes_parse(&probes, params.probe_points, params.probe_lines, &inside_global);
+            char filename[PARAMS_STRING_LEN + 16];
+            snprintf(filename, sizeof(filename), "%s_r%04d.bin", params.probe_file, rank);
+            probes_setup(&probes, &whole, &inside, 4096, filename);
+        }
+
+        // Statistics: the whole domain, and the norms behind the slit
+        struct Stats stats;
+        stats_init(&stats, &stats_cfg, &whole_global, &inside_global, &whole, &inside, &mesh, dt,
+                   constant.e0, constant.m0, cexy, ceyx, chzx, chzy);
+        stats_add_region(&stats, inside_global.begin[0], inside_global.begin[1] + inside_global.length[1]*3/5,
+                         inside_global.begin[0] + inside_global.length[0], inside_global.begin[1] + inside_global.length[1]);
+        if (stats.fp != NULL) {
+            params_write(&params, stats.fp, "# ");
+        }
+
+        // Tiles of calc_ex_ey and calc_hz for this subdomain (tune.mode, tune.db)
+        fdtd2d_tune(&whole, &inside, params.tune_mode, params.tune_db);
+
+        struct Trace trace;
+        trace_init(&trace, &trace_cfg);
 
         struct timeval tv0;
         struct timeval tv1;
@@ -190,8 +343,15 @@ int main(int argc, char *argv[])
         MPI_Barrier(MPI_COMM_WORLD);
         gettimeofday(&tv0, NULL);
     
+        struct Output output;
+        if (output_file && rank == 0) {
+            if (!output_open(&output, &output_cfg, sampler.out.length)) {
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+    
         int icnt = 0;
-        FLOAT time = 0.0;
+        double time = 0.0; // from icnt, not a sum of dt: no drift in long runs
         if (rank == 0) {
             fprintf(stdout, "icnt = %5d, time = %6.4e [sec]\n", icnt, time);
         }
@@ -199,24 +359,27 @@ int main(int argc, char *argv[])
         if (output_file) {
             
             const int rank_root  = 0;
-            const int sendnelems = whole.length[0] * inside.length[1];
-            const int src        = whole.length[0] * (inside.begin[1] - whole.begin[1]);
-            const int dst        = whole.length[0] * (inside.begin[1] - whole.begin[1]);
-        
-#pragma acc host_data use_device(ex)
-            MPI_Gather(&ex[src], sendnelems, MPI_FLOAT_T, &ex_global[dst], sendnelems, MPI_FLOAT_T, rank_root, MPI_COMM_WORLD);
-#pragma acc host_data use_device(ey)
-            MPI_Gather(&ey[src], sendnelems, MPI_FLOAT_T, &ey_global[dst], sendnelems, MPI_FLOAT_T, rank_root, MPI_COMM_WORLD);
-#pragma acc host_data use_device(hz)
-            MPI_Gather(&hz[src], sendnelems, MPI_FLOAT_T, &hz_global[dst], sendnelems, MPI_FLOAT_T, rank_root, MPI_COMM_WORLD);
+            trace_begin(&trace, TRACE_GATHER);
+            sampler_gather(&sampler, ex, ey, hz, ex_global, ey_global, hz_global);
+            trace_end(&trace, TRACE_GATHER);
             
             if (rank == rank_root) {
-                write_bmp(icnt, time, whole_global.length, dx, dy, ex_global, ey_global, hz_global);
+                trace_begin(&trace, TRACE_OUTPUT);
+                output_frame(&output, icnt, time, ex_global);
+                trace_end(&trace, TRACE_OUTPUT);
+                trace_begin(&trace, TRACE_SNAPSHOT);
+                if (snapshot.fields != 0) {
+                    write_snapshot(&snapshot, icnt, time, &sampler.out, &snapshot_region, ex_global, ey_global, hz_global);
+                }
+                trace_end(&trace, TRACE_SNAPSHOT);
             }
         }
 
         while (icnt < nt) {
 
+            trace_step(&trace, icnt);
+            trace_begin(&trace, TRACE_STEP);
+
             MPI_Status status;
             const int tag = 0;
             const int nhalo       = whole.length[0];
@@ -225,35 +388,68 @@ int main(int argc, char *argv[])
             const int src_hz      = whole.length[0] * (inside_end1     - whole.begin[1] - 1);
             const int dst_hz      = whole.length[0] * (inside.begin[1] - whole.begin[1] - 1);
     
+            trace_begin(&trace, TRACE_HALO_HZ);
 #pragma acc host_data use_device(hz)
             {
             MPI_Send(&hz[src_hz], nhalo, MPI_FLOAT_T, rank_up  , tag, MPI_COMM_WORLD);
             MPI_Recv(&hz[dst_hz], nhalo, MPI_FLOAT_T, rank_down, tag, MPI_COMM_WORLD, &status);
             }
+            trace_end(&trace, TRACE_HALO_HZ);
     
+            dispersive_update_e(&dispersive, ex, ey);
+            trace_begin(&trace, TRACE_CALC_EX_EY);
+            PERF_BEGIN(calc_ex_ey);
             calc_ex_ey(&whole, &inside, hz, cexly, ceylx, ex, ey);
+            PERF_END(calc_ex_ey);
+            trace_end(&trace, TRACE_CALC_EX_EY);
+            trace_begin(&trace, TRACE_PML_E);
+            PERF_BEGIN(pml_boundary_ex);
             pml_boundary_ex(&whole, &inside, hz, cexy, cexyl, rer_ex, ex, exy);
+            PERF_END(pml_boundary_ex);
+            PERF_BEGIN(pml_boundary_ey);
             pml_boundary_ey(&whole, &inside, hz, ceyx, ceyxl, rer_ey, ey, eyx);
+            PERF_END(pml_boundary_ey);
+            trace_end(&trace, TRACE_PML_E);
     
             
-            const int j_in = 0;
-            plane_wave_incidence(&whole, &inside, time, j_in, wavelength, ex, ey);
-            time += 0.5*dt;
+            trace_begin(&trace, TRACE_UPDATE_E);
+            inject_sources_e(&sources, icnt, ex, ey);
+            subgrid_update(&subgrid, ex, ey);
+            dft_monitors_update_e(dft, PARAMS_DFT_MAX, icnt, ex, ey);
+            ntff_update_e(&ntff, icnt, ex, ey);
+            trace_end(&trace, TRACE_UPDATE_E);
+            time = (icnt + 0.5)*dt;
             
             
             const int src_ex      = whole.length[0] * (inside.begin[1] - whole.begin[1]);
             const int dst_ex      = whole.length[0] * (inside_end1     - whole.begin[1]);
     
+            trace_begin(&trace, TRACE_HALO_EX);
 #pragma acc host_data use_device(ex)
             {
             MPI_Send(&ex[src_ex], nhalo, MPI_FLOAT_T, rank_down, tag, MPI_COMM_WORLD);
             MPI_Recv(&ex[dst_ex], nhalo, MPI_FLOAT_T, rank_up  , tag, MPI_COMM_WORLD, &status);
             }
+            trace_end(&trace, TRACE_HALO_EX);
     
             
+            trace_begin(&trace, TRACE_CALC_HZ);
+            PERF_BEGIN(calc_hz);
             calc_hz(&whole, &inside, ey, ex, chzlx, chzly, hz);
+            PERF_END(calc_hz);
+            trace_end(&trace, TRACE_CALC_HZ);
+            trace_begin(&trace, TRACE_PML_H);
+            PERF_BEGIN(pml_boundary_hz);
             pml_boundary_hz(&whole, &inside, ey, ex, chzx, chzxl, chzy, chzyl, hz, hzx, hzy);
-            time += 0.5*dt;
+            PERF_END(pml_boundary_hz);
+            trace_end(&trace, TRACE_PML_H);
+            trace_begin(&trace, TRACE_UPDATE_H);
+            inject_sources_h(&sources, icnt, hz);
+            dft_monitors_update_h(dft, PARAMS_DFT_MAX, icnt, hz);
+            ntff_update_h(&ntff, icnt, hz);
+            probes_sample(&probes, icnt, ex, ey, hz);
+            trace_end(&trace, TRACE_UPDATE_H);
+            time = (icnt + 1)*dt;
             
             icnt++;
             if (rank == 0 && icnt % 100 == 0) {
@@ -263,25 +459,37 @@ int main(int argc, char *argv[])
             if (output_file && icnt % nout == 0) {
     
                 const int rank_root  = 0;
-                const int sendnelems = whole.length[0] * inside.length[1];
-                const int src        = whole.length[0] * (inside.begin[1] - whole.begin[1]);
-                const int dst        = whole.length[0] * (inside.begin[1] - whole.begin[1]);
-    
-#pragma acc host_data use_device(ex)
-                MPI_Gather(&ex[src], sendnelems, MPI_FLOAT_T, &ex_global[dst], sendnelems, MPI_FLOAT_T, rank_root, MPI_COMM_WORLD);
-#pragma acc host_data use_device(ey)
-                MPI_Gather(&ey[src], sendnelems, MPI_FLOAT_T, &ey_global[dst], sendnelems, MPI_FLOAT_T, rank_root, MPI_COMM_WORLD);
-#pragma acc host_data use_device(hz)
-                MPI_Gather(&hz[src], sendnelems, MPI_FLOAT_T, &hz_global[dst], sendnelems, MPI_FLOAT_T, rank_root, MPI_COMM_WORLD);
+                trace_begin(&trace, TRACE_GATHER);
+                sampler_gather(&sampler, ex, ey, hz, ex_global, ey_global, hz_global);
+                trace_end(&trace, TRACE_GATHER);
                 
                 if (rank == rank_root) {
-                    write_bmp(icnt, time, whole_global.length, dx, dy, ex_global, ey_global, hz_global);
+                    trace_begin(&trace, TRACE_OUTPUT);
+                    output_frame(&output, icnt, time, ex_global);
+                    trace_end(&trace, TRACE_OUTPUT);
+                    trace_begin(&trace, TRACE_SNAPSHOT);
+                    if (snapshot.fields != 0) {
+                        write_snapshot(&snapshot, icnt, time, &sampler.out, &snapshot_region, ex_global, ey_global, hz_global);
+                    }
+                    trace_end(&trace, TRACE_SNAPSHOT);
                 }
                 
             }
+
+            trace_begin(&trace, TRACE_STATS);
+            const int stats_status = stats_update(&stats, icnt, time, ex, ey, hz, hzx, hzy, rer_ex, rer_ey);
+            trace_end(&trace, TRACE_STATS);
+            trace_end(&trace, TRACE_STEP);
+            if (stats_status == STATS_DIVERGED) {
+                break;
+            }
         }
                 
 
+        if (output_file && rank == 0) {
+            output_close(&output);
+        }
+
         MPI_Barrier(MPI_COMM_WORLD);
         gettimeofday(&tv1, NULL);
         
@@ -290,12 +498,28 @@ int main(int argc, char *argv[])
             fprintf(stdout, "------------------------------\n");
             fprintf(stdout, "Domain      = %d x %d\n", inside_global.length[0], inside_global.length[1]);
             fprintf(stdout, "nsubdomains = %d\n", nsubdomains);
-            fprintf(stdout, "GPU is used = %d\n", ngpus > 0);
+            fprintf(stdout, "GPU is used = %d\n", gpuid >= 0);
             fprintf(stdout, "output_file = %d\n", output_file);
             fprintf(stdout, "Time        = %10.6f [sec]\n", elapsed_time);
             fprintf(stdout, "------------------------------\n");
         }
 
+        for (int n=0; n<PARAMS_DFT_MAX; n++) {
+            dft_monitor_write(&dft[n], params.dft[n].file);
+            dft_monitor_free(&dft[n]);
+        }
+        ntff_write(&ntff, params.ntff_angles, params.ntff_file);
+        ntff_free(&ntff);
+        probes_free(&probes);
+        stats_free(&stats);
+        trace_write(&trace);
+        trace_free(&trace);
+        dispersive_free(&dispersive);
+        sources_free(&sources);
+        subgrid_free(&subgrid);
+        mesh_free(&mesh);
+        sampler_free(&sampler);
+
     } // acc data
     
     free(ex);
@@ -321,8 +545,6 @@ int main(int argc, char *argv[])
     free(chzxl);
     free(chzyl);
     
-    free(obj);
-    free(er);
     free(rer_ex);
     free(rer_ey);
 
@@ -333,53 +555,6 @@ int main(int argc, char *argv[])
     MPI_Finalize();
 }
 
-void set_object_er(const struct Range *whole,
-                   FLOAT lx, FLOAT ly, FLOAT dx, FLOAT dy, int *obj, FLOAT *er)
-{
-    const FLOAT y0 = 0.5*ly;
-    const FLOAT y1 = y0 + 0.1*ly;
-    const FLOAT x0 = 0.45*lx;
-    const FLOAT x1 = 0.55*lx;
-
-    // Set relative permittivity
-    const FLOAT relative_permittivity = 5.4;
-
-    // Set media and objects
-    for (int jj=0; jj<whole->length[1]; jj++) {
-        for (int ii=0; ii<whole->length[0]; ii++) {
-            const int ix = ii + jj*whole->length[0];
-            const int i = ii + whole->begin[0];
-            const int j = jj + whole->begin[1];
-
-            const FLOAT x = (i+0.5) * dx;
-            const FLOAT y = (j+0.5) * dy;
-
-            if (y >= y0 && y <= y1 &&
-                (x <= x0 || x >= x1)) {
-                obj[ix] = 1;
-            }
-            
-            if (y >= -0.25 * (x-lx) + y1) {
-                er[ix] = relative_permittivity;
-            }
-                
-        }
-    }
-
-}
-
-FLOAT get_dt(FLOAT dx, FLOAT dy)
-{
-    const FLOAT c = constant.c;
-
-    const FLOAT coef = 0.2;
-
-    const FLOAT rdx = 1.0/dx;
-    const FLOAT rdy = 1.0/dy;
-    
-    return coef * 1.0 / (c * sqrt(rdx*rdx + rdy*rdy));
-}
-
 double get_elapsed_time(const struct timeval *tv0, const struct timeval *tv1)
 {
     return (double)(tv1->tv_sec - tv0->tv_sec) + (double)(tv1->tv_usec - tv0->tv_usec)*1.0e-6;
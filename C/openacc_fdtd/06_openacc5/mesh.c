@@ -0,0 +1,181 @@
+/**
+ * @file mesh.c
+ * @brief Non-uniform (graded) rectilinear mesh
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#include "mesh.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static void allocate(struct Mesh *m, const struct Range *whole)
+{
+    memset(m, 0, sizeof(struct Mesh));
+    m->whole = *whole;
+    for (int a=0; a<2; a++) {
+        const int n = whole->length[a];
+        m->d [a] = (FLOAT  *)malloc(sizeof(FLOAT )*n);
+        m->dd[a] = (FLOAT  *)malloc(sizeof(FLOAT )*n);
+        m->x [a] = (double *)malloc(sizeof(double)*(n + 1));
+        m->xc[a] = (double *)malloc(sizeof(double)*n);
+    }
+}
+
+// Dual widths and cell centers from d and x, then copy to the device
+static void finish(struct Mesh *m)
+{
+    for (int a=0; a<2; a++) {
+        const int n = m->whole.length[a];
+        FLOAT  *d  = m->d [a];
+        FLOAT  *dd = m->dd[a];
+        double *x  = m->x [a];
+        double *xc = m->xc[a];
+        for (int i=0; i<n; i++) {
+            dd[i] = i == 0 ? d[i] : 0.5*(d[i-1] + d[i]);
+            xc[i] = x[i] + 0.5*d[i];
+        }
+#pragma acc enter data copyin(d[0:n], dd[0:n], x[0:n+1], xc[0:n])
+    }
+}
+
+void mesh_init(struct Mesh *m, const struct Range *whole, FLOAT dx, FLOAT dy)
+{
+    allocate(m, whole);
+    for (int a=0; a<2; a++) {
+        const FLOAT ds = a == 0 ? dx : dy;
+        for (int i=0; i<whole->length[a]; i++) {
+            m->d[a][i] = ds;
+        }
+    }
+}
+
+bool mesh_grade(struct Mesh *m, int axis, int i0, int i1, double d0, double d1)
+{
+    if (axis < 0 || axis > 1 || i0 >= i1 || d0 <= 0.0 || d1 <= 0.0) {
+        fprintf(stderr, "Error: invalid grading of axis %d, cells %d - %d\n", axis, i0, i1);
+        return false;
+    }
+
+    // Geometric progression from d0 (cell i0) to d1 (cell i1-1)
+    const int n = i1 - i0;
+    for (int i=i0; i<i1; i++) {
+        const int ii = i - m->whole.begin[axis];
+        if (ii < 0 || ii >= m->whole.length[axis]) continue;
+        const double t = n > 1 ? (double)(i - i0)/(n - 1) : 0.0;
+        m->d[axis][ii] = d0*pow(d1/d0, t);
+    }
+    m->graded = 1;
+    return true;
+}
+
+void mesh_setup(struct Mesh *m)
+{
+    for (int a=0; a<2; a++) {
+        const int n = m->whole.length[a];
+        const int o = -m->whole.begin[a]; // array index of the global index 0
+        FLOAT  *d = m->d[a];
+        double *x = m->x[a];
+
+        if (!m->graded) {
+            for (int i=0; i<=n; i++) {
+                x[i] = (i - o)*(double)d[0];
+            }
+        } else {
+            // Accumulate outwards from x = 0 at the global index 0
+            const int c = o < 0 ? 0 : o > n ? n : o;
+            x[c] = 0.0;
+            for (int i=c-1; i>=0; i--) x[i]   = x[i+1] - d[i];
+            for (int i=c  ; i< n; i++) x[i+1] = x[i]   + d[i];
+        }
+    }
+    finish(m);
+}
+
+void mesh_refine(struct Mesh *fine, const struct Mesh *coarse, const struct Range *whole, int ratio)
+{
+    allocate(fine, whole);
+    fine->graded = coarse->graded;
+
+    for (int a=0; a<2; a++) {
+        for (int i=0; i<=whole->length[a]; i++) {
+            // Fine cell I is the k-th part of the coarse cell c
+            const int I  = i + whole->begin[a];
+            const int c  = (I >= 0 ? I : I - ratio + 1)/ratio;
+            const int k  = I - c*ratio;
+            const int ic = c - coarse->whole.begin[a];
+            const double dc = coarse->d[a][ic];
+            fine->x[a][i] = coarse->x[a][ic] + k*dc/ratio;
+            if (i < whole->length[a]) {
+                fine->d[a][i] = dc/ratio;
+            }
+        }
+    }
+    finish(fine);
+}
+
+void mesh_min_spacing(const struct Mesh *m, FLOAT *dx, FLOAT *dy)
+{
+    FLOAT dmin[2];
+    for (int a=0; a<2; a++) {
+        dmin[a] = m->d[a][0];
+        for (int i=1; i<m->whole.length[a]; i++) {
+            dmin[a] = fmin(dmin[a], m->d[a][i]);
+        }
+    }
+    *dx = dmin[0];
+    *dy = dmin[1];
+}
+
+double mesh_length(const struct Mesh *m, int axis, int i0, int i1)
+{
+    return m->x[axis][i1 - m->whole.begin[axis]] - m->x[axis][i0 - m->whole.begin[axis]];
+}
+
+void mesh_cell_range(const struct Mesh *m, int axis, double v0, double v1, int *i0, int *i1)
+{
+    // Cells whose center is in [v0, v1], as global indices; *i1 < *i0 if none
+    const int     n  = m->whole.length[axis];
+    const double *xc = m->xc[axis];
+
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        const int mid = (lo + hi)/2;
+        if (xc[mid] < v0) lo = mid + 1; else hi = mid;
+    }
+    const int b = lo;
+
+    lo = 0; hi = n;
+    while (lo < hi) {
+        const int mid = (lo + hi)/2;
+        if (xc[mid] <= v1) lo = mid + 1; else hi = mid;
+    }
+    *i0 = b      + m->whole.begin[axis];
+    *i1 = lo - 1 + m->whole.begin[axis];
+}
+
+void mesh_free(struct Mesh *m)
+{
+    for (int a=0; a<2; a++) {
+        const int n = m->whole.length[a];
+        FLOAT  *d  = m->d [a];
+        FLOAT  *dd = m->dd[a];
+        double *x  = m->x [a];
+        double *xc = m->xc[a];
+        if (d != NULL) {
+#pragma acc exit data delete(d[0:n], dd[0:n], x[0:n+1], xc[0:n])
+        }
+        free(d);
+        free(dd);
+        free(x);
+        free(xc);
+    }
+    memset(m, 0, sizeof(struct Mesh));
+}
@@ -0,0 +1,46 @@
+/**
+ * @file mesh.h
+ * @brief Non-uniform (graded) rectilinear mesh
+ *
+ * Cell i spans x[i] .. x[i+1] with the width dx[i], and x = 0 at the
+ * global index 0.  The hz point of a cell is at its center; the ey (ex)
+ * point on the left (bottom) face is between the centers of the cells
+ * i-1 and i, at the dual distance dxd[i] = (dx[i-1] + dx[i])/2.  The
+ * mesh covers the global whole range on every rank and is also on the
+ * device after mesh_setup().
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#ifndef MESH_H
+#define MESH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "config.h"
+
+struct Mesh {
+    struct Range whole;
+
+    // [0]: x, [1]: y, indexed by (global index - whole.begin)
+    FLOAT  *d [2]; // cell width, [length]
+    FLOAT  *dd[2]; // dual width, [length]
+    double *x [2]; // cell edge,  [length + 1]
+    double *xc[2]; // cell center, [length]
+    int     graded;
+};
+
+void mesh_init(struct Mesh *m, const struct Range *whole, FLOAT dx, FLOAT dy);
+bool mesh_grade(struct Mesh *m, int axis, int i0, int i1, double d0, double d1);
+void mesh_setup(struct Mesh *m);
+void mesh_refine(struct Mesh *fine, const struct Mesh *coarse, const struct Range *whole, int ratio);
+void mesh_min_spacing(const struct Mesh *m, FLOAT *dx, FLOAT *dy);
+double mesh_length(const struct Mesh *m, int axis, int i0, int i1);
+void mesh_cell_range(const struct Mesh *m, int axis, double v0, double v1, int *i0, int *i1);
+void mesh_free(struct Mesh *m);
+
+#endif /* MESH_H */
@@ -0,0 +1,227 @@
+/**
+ * @file ntff.c
+ * @brief Near-to-far-field transformation
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$ 
+ */
+
+#include "ntff.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+enum { NORMAL_PX = 0, NORMAL_MX = 1, NORMAL_PY = 2, NORMAL_MY = 3 };
+
+void ntff_init(struct NTFF *t, int i0, int j0, int i1, int j1, int nfreq, const double *freq,
+               const struct Range *whole, const struct Range *inside, const struct Mesh *mesh, double dt)
+{
+    memset(t, 0, sizeof(struct NTFF));
+    
+    t->contour[0] = i0;
+    t->contour[1] = j0;
+    t->contour[2] = i1;
+    t->contour[3] = j1;
+    t->nfreq      = nfreq;
+    t->mesh       = mesh;
+    t->freq       = (double *)malloc(sizeof(double)*nfreq);
+    memcpy(t->freq, freq, sizeof(double)*nfreq);
+
+    const int nx = i1 - i0;
+    const int ny = j1 - j0;
+    const int nwindow = 1024;
+
+    // Horizontal edges: ex on the edge, hz on the rows above and below
+    const int jedge[] = { j1, j0 };
+    for (int e=0; e<2; e++) {
+        const int j = jedge[e];
+        const struct Range r_e  = { { nx, 1 }, { i0, j     } };
+        const struct Range r_hp = { { nx, 1 }, { i0, j     } };
+        const struct Range r_hm = { { nx, 1 }, { i0, j - 1 } };
+        const int m = 3*e;
+        dft_monitor_init(&t->monitor[m + 0], FIELD_EX, &r_e , nfreq, freq, whole, inside, dt, nwindow);
+        dft_monitor_init(&t->monitor[m + 1], FIELD_HZ, &r_hp, nfreq, freq, whole, inside, dt, nwindow);
+        dft_monitor_init(&t->monitor[m + 2], FIELD_HZ, &r_hm, nfreq, freq, whole, inside, dt, nwindow);
+        for (int k=0; k<3; k++) {
+            t->kind  [m + k] = k == 0 ? 0 : 1;
+            t->normal[m + k] = e == 0 ? NORMAL_PY : NORMAL_MY;
+        }
+    }
+    
+    // Vertical edges: ey on the edge, hz on the columns right and left
+    const int iedge[] = { i1, i0 };
+    for (int e=0; e<2; e++) {
+        const int i = iedge[e];
+        const struct Range r_e  = { { 1, ny }, { i    , j0 } };
+        const struct Range r_hp = { { 1, ny }, { i    , j0 } };
+        const struct Range r_hm = { { 1, ny }, { i - 1, j0 } };
+        const int m = 6 + 3*e;
+        dft_monitor_init(&t->monitor[m + 0], FIELD_EY, &r_e , nfreq, freq, whole, inside, dt, nwindow);
+        dft_monitor_init(&t->monitor[m + 1], FIELD_HZ, &r_hp, nfreq, freq, whole, inside, dt, nwindow);
+        dft_monitor_init(&t->monitor[m + 2], FIELD_HZ, &r_hm, nfreq, freq, whole, inside, dt, nwindow);
+        for (int k=0; k<3; k++) {
+            t->kind  [m + k] = k == 0 ? 0 : 1;
+            t->normal[m + k] = e == 0 ? NORMAL_PX : NORMAL_MX;
+        }
+    }
+}
+
+void ntff_free(struct NTFF *t)
+{
+    for (int m=0; m<NTFF_NMONITORS; m++) {
+        dft_monitor_free(&t->monitor[m]);
+    }
+    free(t->freq);
+    memset(t, 0, sizeof(struct NTFF));
+}
+
+void ntff_update_e(struct NTFF *t, int step, const FLOAT *ex, const FLOAT *ey)
+{
+    for (int m=0; m<NTFF_NMONITORS; m++) {
+        if (t->kind[m] != 0) continue;
+        dft_monitor_update(&t->monitor[m], step, t->monitor[m].comp == FIELD_EX ? ex : ey);
+    }
+}
+
+void ntff_update_h(struct NTFF *t, int step, const FLOAT *hz)
+{
+    for (int m=0; m<NTFF_NMONITORS; m++) {
+        if (t->kind[m] != 1) continue;
+        dft_monitor_update(&t->monitor[m], step, hz);
+    }
+}
+
+bool ntff_write(const struct NTFF *t, int nangles, const char *filename)
+{
+    if (t->nfreq == 0) return true;
+
+    int rank = 0;
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if (initialized) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    }
+
+    const double pi = constant.pi;
+    const double c  = constant.c;
+    const int nfreq = t->nfreq;
+    const int nacc  = nfreq*nangles;
+
+    // [0]: Re N_phi, [1]: Im N_phi, [2]: Re L_z, [3]: Im L_z, each [nfreq][nangles]
+    double *nl = (double *)calloc(4*nacc, sizeof(double));
+    const double *freq = t->freq;
+
+#pragma acc data copy(nl[0:4*nacc]) copyin(freq[0:nfreq])
+    {
+    for (int m=0; m<NTFF_NMONITORS; m++) {
+        const struct DFTMonitor *mon = &t->monitor[m];
+        if (mon->nlocal == 0) continue;
+
+        const int    nlocal = mon->nlocal;
+        const int    lnx    = mon->local.length[0];
+        const int    lny    = mon->local.length[1];
+        const int    bx     = mon->local.begin[0];
+        const int    by     = mon->local.begin[1];
+        const int    normal = t->normal[m];
+        const int    is_h   = t->kind[m];
+        const double *xe    = t->mesh->x [0];
+        const double *ye    = t->mesh->x [1];
+        const double *xc    = t->mesh->xc[0];
+        const double *yc    = t->mesh->xc[1];
+        const FLOAT  *wx    = t->mesh->d [0];
+        const FLOAT  *wy    = t->mesh->d [1];
+        const int    mb0    = t->mesh->whole.begin[0];
+        const int    mb1    = t->mesh->whole.begin[1];
+        const double *re    = mon->re;
+        const double *im    = mon->im;
+
+        // Position of the samples on the edge (cell centers along it), and weights of the currents
+        const int    iedge  = normal == NORMAL_PX ? t->contour[2] : t->contour[0];
+        const int    jedge  = normal == NORMAL_PY ? t->contour[3] : t->contour[1];
+        const int    horiz  = normal == NORMAL_PY || normal == NORMAL_MY;
+        const double sign   = normal == NORMAL_PX || normal == NORMAL_PY ? 1.0 : -1.0;
+
+#pragma acc parallel loop collapse(2) present(nl, freq, re, im, xe, ye, xc, yc, wx, wy)
+        for (int f=0; f<nfreq; f++) {
+            for (int a=0; a<nangles; a++) {
+                const double phi  = 2.0*pi*a/nangles;
+                const double cphi = cos(phi);
+                const double sphi = sin(phi);
+                const double k    = 2.0*pi*freq[f]/c;
+                
+                // J_phi = -sign*hz*sin(phi) (horizontal), -sign*hz*cos(phi) (vertical), hz averaged over 2 rows
+                // M_z   =  sign*ex (horizontal), -sign*ey (vertical)
+                const double w = is_h ? -0.5*sign*(horiz ? sphi : cphi) :
+                                        (horiz ? sign : -sign);
+                
+                double sum_re = 0.0;
+                double sum_im = 0.0;
+#pragma acc loop seq
+                for (int j=0; j<lny; j++) {
+#pragma acc loop seq
+                    for (int i=0; i<lnx; i++) {
+                        const int    l  = j*lnx + i;
+                        const double x  = horiz ? xc[bx + i - mb0] : xe[iedge - mb0];
+                        const double y  = horiz ? ye[jedge - mb1] : yc[by + j - mb1];
+                        const double dl = horiz ? wx[bx + i - mb0] : wy[by + j - mb1];
+                        const double ph = k*(x*cphi + y*sphi);
+                        const double cr = cos(ph);
+                        const double ci = sin(ph);
+                        const double fr = re[f*nlocal + l];
+                        const double fi = im[f*nlocal + l];
+                        sum_re += dl*(fr*cr - fi*ci);
+                        sum_im += dl*(fr*ci + fi*cr);
+                    }
+                }
+                const int o = is_h ? 0 : 2;
+                nl[(o    )*nacc + f*nangles + a] += w*sum_re;
+                nl[(o + 1)*nacc + f*nangles + a] += w*sum_im;
+            }
+        }
+    }
+    }
+    
+    double *sum = nl;
+    if (initialized) {
+        sum = rank == 0 ? (double *)malloc(sizeof(double)*4*nacc) : NULL;
+        MPI_Reduce(nl, sum, 4*nacc, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    }
+
+    bool ret = true;
+    if (rank == 0) {
+        FILE *fp = fopen(filename, "w");
+        if (fp == NULL) {
+            fprintf(stderr, "Error: cannot open %s\n", filename);
+            ret = false;
+        } else {
+            const double z0 = constant.z0;
+            fprintf(fp, "# phi[deg]");
+            for (int f=0; f<nfreq; f++) {
+                fprintf(fp, " sigma*|Einc|^2(f=%e)", freq[f]);
+            }
+            fprintf(fp, "\n");
+            for (int a=0; a<nangles; a++) {
+                fprintf(fp, "%8.3f", 360.0*a/nangles);
+                for (int f=0; f<nfreq; f++) {
+                    const int    o  = f*nangles + a;
+                    const double k  = 2.0*pi*freq[f]/c;
+                    const double er = sum[2*nacc + o] + z0*sum[0*nacc + o];
+                    const double ei = sum[3*nacc + o] + z0*sum[1*nacc + o];
+                    fprintf(fp, " %14.6e", 0.25*k*(er*er + ei*ei));
+                }
+                fprintf(fp, "\n");
+            }
+            fclose(fp);
+        }
+    }
+    
+    if (sum != nl) free(sum);
+    free(nl);
+
+    return ret;
+}
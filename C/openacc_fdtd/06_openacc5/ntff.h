@@ -0,0 +1,58 @@
+/**
+ * @file ntff.h
+ * @brief Near-to-far-field transformation
+ *
+ * Far-field pattern of the 2D TE field (ex, ey, hz) computed from the
+ * equivalent surface currents on a closed rectangular contour.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$ 
+ */
+
+#ifndef NTFF_H
+#define NTFF_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "config.h"
+#include "dft_monitor.h"
+#include "mesh.h"
+
+#define NTFF_NMONITORS 12
+
+/**
+ * @brief Near-to-far-field transformation on the contour
+ *        between the cell edges i0 .. i1 and j0 .. j1 (global indices)
+ *
+ * The tangential fields on each edge are recorded by running DFTs: the
+ * tangential E component on the edge and the two rows (columns) of hz
+ * around it, whose average gives hz on the edge.  Since the surface
+ * integral is linear in the fields, every rank integrates the monitors
+ * it owns and the partial integrals are summed over the ranks.
+ *
+ * The output is the 2D scattering width times |E_inc|^2,
+ *   (k/4) |L_z + z0 N_phi|^2,
+ * with N = int (n x H) exp(i k r.r') dl and L = int (-n x E) exp(i k r.r') dl.
+ * With no frequency (nfreq = 0) the transformation is off.
+ */
+struct NTFF {
+    int    contour[4];  // i0, j0, i1, j1
+    int    nfreq;
+    double *freq;
+    const struct Mesh *mesh;
+    struct DFTMonitor monitor[NTFF_NMONITORS];
+    int    kind   [NTFF_NMONITORS]; // 0: magnetic current from E, 1: electric current from hz
+    int    normal [NTFF_NMONITORS]; // 0: +x, 1: -x, 2: +y, 3: -y
+};
+
+void ntff_init(struct NTFF *t, int i0, int j0, int i1, int j1, int nfreq, const double *freq,
+               const struct Range *whole, const struct Range *inside, const struct Mesh *mesh, double dt);
+void ntff_free(struct NTFF *t);
+void ntff_update_e(struct NTFF *t, int step, const FLOAT *ex, const FLOAT *ey);
+void ntff_update_h(struct NTFF *t, int step, const FLOAT *hz);
+bool ntff_write(const struct NTFF *t, int nangles, const char *filename);
+
+#endif /* NTFF_H */
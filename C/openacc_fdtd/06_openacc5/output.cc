@@ -14,6 +14,7 @@
 #include "output.h"
 #include <iostream>
 #include <cmath>
+#include <cstring>
 #include "bitmap.h"
 
 bool write_bmp(int icnt, FLOAT time, const int length[], FLOAT dx, FLOAT dy,
@@ -57,7 +58,116 @@ bool write_bmp(int icnt, FLOAT time, const int length[], FLOAT dx, FLOAT dy,
 }
 
 
+namespace {
 
+void encode_frame(void *arg)
+{
+    const OutputFrame *f = (const OutputFrame *)arg;
+    const Output      *o = f->out;
+    const int lnx = o->length[0];
+    const int lny = o->length[1];
+
+    char filename[64];
+    const char *name = filename; // the stream name is not copied: it can be longer
+    int ret = lnx*lny;
+    
+    switch (o->cfg.format) {
+    case OUTPUT_PNG: {
+        sprintf(filename, "e%05d.png", f->icnt);
+        PngWriter writer(filename);
+        ret = writer.write_8bit(lnx, lny, f->index, o->palette, o->cfg.nthreads);
+        break;
+    }
+    case OUTPUT_Y4M:
+        name = o->cfg.stream;
+        ret = ((Y4MWriter *)o->video)->write_8bit(f->index, o->palette);
+        break;
+    default: {
+        sprintf(filename, "e%05d.bmp", f->icnt);
+        BitmapWriter writer(filename);
+        ret = writer.write_8bit(lnx, lny, f->index, o->palette);
+        break;
+    }
+    }
+
+    if (ret != lnx*lny) {
+        fprintf(stderr, "Error: cannot write %s (step %d)\n", name, f->icnt);
+    }
+}
+
+} // namespace
+
+bool output_open(struct Output *o, const struct OutputConfig *cfg, const int length[])
+{
+    memset(o, 0, sizeof(struct Output));
+    o->cfg       = *cfg;
+    o->length[0] = length[0];
+    o->length[1] = length[1];
+    o->ticket[0] = o->ticket[1] = -1;
+
+    BitmapPalette palette(BitmapPalette::SEISMIC);
+    memcpy(o->palette, palette.data(), sizeof(o->palette));
+
+    if (cfg->format == OUTPUT_Y4M) {
+        Y4MWriter *video = new Y4MWriter;
+        const char *stream = cfg->stream != NULL ? cfg->stream : "e.y4m";
+        o->cfg.stream = stream;
+        if (!video->open(stream, length[0], length[1], cfg->fps > 0 ? cfg->fps : 25)) {
+            fprintf(stderr, "Error: cannot open %s\n", stream);
+            delete video;
+            return false;
+        }
+        o->video = video;
+    }
+
+    for (int b=0; b<2; b++) {
+        o->frame[b].out   = o;
+        o->frame[b].index = new unsigned char[length[0]*length[1]];
+    }
+    worker_start(&o->worker);
+    
+    return true;
+}
+
+void output_frame(struct Output *o, int icnt, FLOAT time, const FLOAT *ex)
+{
+    const int lnx = o->length[0];
+    const int lny = o->length[1];
+
+    // The previous frame using this buffer must be written
+    if (o->ticket[o->cur] >= 0) worker_wait(&o->worker, o->ticket[o->cur]);
+
+    const FLOAT max =  100.0;
+    const FLOAT min = -100.0;
+    const FLOAT dn  = 1.0/(max - min);
+
+    unsigned char *index = o->frame[o->cur].index;
+
+    // Same mapping as write_bmp()
+#pragma acc kernels copyout(index[0:lnx*lny])
+#pragma acc loop independent
+    for (int j=0; j<lny; j++) {
+#pragma acc loop independent
+        for (int i=0; i<lnx; i++) {
+            const int ix = j*lnx + i;
 
+            const FLOAT f = (ex[ix] - min)*dn;
+            const FLOAT p = fmin(fmax(f, (FLOAT)(2.0/256.0)), (FLOAT)1.0-(FLOAT)(2.0/256.0));
+            index[ix] = (unsigned char)(fmin(fmax(p, 0.0), 1.0)*255);
+        }
+    }
 
+    o->frame[o->cur].icnt = icnt;
+    o->ticket[o->cur] = worker_submit(&o->worker, encode_frame, &o->frame[o->cur]);
+    o->cur = 1 - o->cur;
+}
 
+void output_close(struct Output *o)
+{
+    worker_stop(&o->worker);
+    for (int b=0; b<2; b++) {
+        delete [] o->frame[b].index;
+    }
+    delete (Y4MWriter *)o->video;
+    memset(o, 0, sizeof(struct Output));
+}
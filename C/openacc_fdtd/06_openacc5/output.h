@@ -15,7 +15,9 @@
 #define OUTPUT_H
 
 #include <stdio.h>
+#include <stdbool.h>
 #include "config.h"
+#include "worker.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,6 +26,51 @@ extern "C" {
 bool write_bmp(int icnt, FLOAT time, const int length[], FLOAT dx, FLOAT dy,
                const FLOAT *ex, const FLOAT *ey, const FLOAT *hz);
 
+/*
+ * Asynchronous image output: output_frame() maps ex to palette indices
+ * and returns; the encoding and writing run on a worker thread, with
+ * one frame in flight while the next is being mapped.
+ *
+ *   OUTPUT_BMP : e%05d.bmp, as write_bmp()
+ *   OUTPUT_PNG : e%05d.png, deflated by nthreads threads
+ *   OUTPUT_Y4M : all frames in one Y4M stream, a file or "|command"
+ */
+enum OutputFormat {
+    OUTPUT_BMP = 0,
+    OUTPUT_PNG = 1,
+    OUTPUT_Y4M = 2
+};
+
+struct OutputConfig {
+    int        format;
+    int        nthreads; // PNG encoder threads, 0: number of online processors
+    int        fps;      // Y4M frame rate
+    const char *stream;  // Y4M file name or "|command"
+};
+
+struct Output;
+
+struct OutputFrame {
+    struct Output *out;
+    int    icnt;
+    unsigned char *index;
+};
+
+struct Output {
+    struct OutputConfig cfg;
+    int    length[2];
+    unsigned char palette[256*4];
+    void   *video; // Y4MWriter
+    struct Worker worker;
+    struct OutputFrame frame[2];
+    long   ticket[2];
+    int    cur;
+};
+
+bool output_open(struct Output *o, const struct OutputConfig *cfg, const int length[]);
+void output_frame(struct Output *o, int icnt, FLOAT time, const FLOAT *ex);
+void output_close(struct Output *o);
+
 
 #ifdef __cplusplus
 }
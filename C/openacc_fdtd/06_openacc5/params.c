@@ -0,0 +1,458 @@
+/**
+ * @file params.c
+ * @brief Run parameters from a key/value file and the command line
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#include "params.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <ctype.h>
+#include "fdtd2d_sources.h"
+#include "output.h"
+#include "snapshot.h"
+#include "sampler.h"
+#include "autotune.h"
+#include "probe.h"
+
+enum ParamType {
+    PARAM_INT,
+    PARAM_DOUBLE,
+    PARAM_STRING,
+    PARAM_ENUM,   // int, index of the name in names
+    PARAM_FIELDS, // SNAPSHOT_* mask, "ex,ey,hz" or "none"
+    PARAM_INT4,   // "a,b,c,d"
+    PARAM_LIST    // struct ParamsList
+};
+
+static const char *const backend_names[]   = { "auto", "gpu", "host", NULL };
+static const char *const waveform_names[]  = { "sinusoid", "gaussian", "modulated_gaussian", "ricker", NULL };
+static const char *const format_names[]    = { "bmp", "png", "y4m", NULL };
+static const char *const precision_names[] = { "float64", "float32", "quantized", NULL };
+static const char *const mode_names[]      = { "stride", "average", NULL };
+static const char *const tune_names[]      = { "off", "auto", "force", NULL };
+static const char *const field_names[]     = { "ex", "ey", "hz", NULL };
+
+// The keys of the DFT monitor n
+#define DFT_KEYS(n)                                                                                     \
+    { "dft." #n ".region",    PARAM_INT4,   offsetof(struct Params, dft[n].region),    NULL,            \
+      "i0,j0,i1,j1 of the DFT monitor (0,0,0,0: whole domain)" },                                       \
+    { "dft." #n ".component", PARAM_ENUM,   offsetof(struct Params, dft[n].component), field_names,     \
+      "ex, ey or hz" },                                                                                 \
+    { "dft." #n ".freq",      PARAM_LIST,   offsetof(struct Params, dft[n].freq),      NULL,            \
+      "frequencies [Hz] (none: c/wavelength)" },                                                        \
+    { "dft." #n ".file",      PARAM_STRING, offsetof(struct Params, dft[n].file),      NULL,            \
+      "DFT of the region (empty: off)" }
+
+static const struct {
+    const char *key;
+    int         type;
+    size_t      offset;
+    const char *const *names;
+    const char *help;
+} params_keys[] = {
+    { "nx",                 PARAM_INT,    offsetof(struct Params, nx),                 NULL, "inside cells along x" },
+    { "ny",                 PARAM_INT,    offsetof(struct Params, ny),                 NULL, "inside cells along y" },
+    { "nsubdomains",        PARAM_INT,    offsetof(struct Params, nsubdomains),        NULL, "subdomains along y (0: number of ranks)" },
+    { "nt",                 PARAM_INT,    offsetof(struct Params, nt),                 NULL, "time steps" },
+    { "nout",               PARAM_INT,    offsetof(struct Params, nout),               NULL, "steps between two outputs (0: no output)" },
+    { "pml",                PARAM_INT,    offsetof(struct Params, pml),                NULL, "PML cells on each side" },
+    { "dx",                 PARAM_DOUBLE, offsetof(struct Params, dx),                 NULL, "cell width [m]" },
+    { "dy",                 PARAM_DOUBLE, offsetof(struct Params, dy),                 NULL, "cell height [m]" },
+    { "courant",            PARAM_DOUBLE, offsetof(struct Params, courant),            NULL, "dt relative to the CFL limit" },
+    { "geometry",           PARAM_STRING, offsetof(struct Params, geometry),           NULL, "geometry file (empty: built-in)" },
+    { "backend",            PARAM_ENUM,   offsetof(struct Params, backend),            backend_names, "auto, gpu or host" },
+    { "wavelength",         PARAM_DOUBLE, offsetof(struct Params, wavelength),         NULL, "wavelength of the source [m]" },
+    { "source.waveform",    PARAM_ENUM,   offsetof(struct Params, source_waveform),    waveform_names, "sinusoid, gaussian, modulated_gaussian or ricker" },
+    { "source.amplitude",   PARAM_DOUBLE, offsetof(struct Params, source_amplitude),   NULL, "amplitude of ex on the source row" },
+    { "source.t0",          PARAM_DOUBLE, offsetof(struct Params, source_t0),          NULL, "delay [sec]" },
+    { "source.tau",         PARAM_DOUBLE, offsetof(struct Params, source_tau),         NULL, "width of the gaussian pulses [sec]" },
+    { "source.j",           PARAM_INT,    offsetof(struct Params, source_j),           NULL, "source row (inside cells)" },
+    { "output.format",      PARAM_ENUM,   offsetof(struct Params, output_format),      format_names, "bmp, png or y4m" },
+    { "output.threads",     PARAM_INT,    offsetof(struct Params, output_threads),     NULL, "PNG encoder threads (0: all processors)" },
+    { "output.fps",         PARAM_INT,    offsetof(struct Params, output_fps),         NULL, "Y4M frame rate" },
+    { "output.stream",      PARAM_STRING, offsetof(struct Params, output_stream),      NULL, "Y4M file or |command" },
+    { "output.config",      PARAM_STRING, offsetof(struct Params, output_config),      NULL, "copy of the parameters, e.g. run.cfg (empty: none)" },
+    { "snapshot.fields",    PARAM_FIELDS, offsetof(struct Params, snapshot_fields),    NULL, "ex,ey,hz or none" },
+    { "snapshot.precision", PARAM_ENUM,   offsetof(struct Params, snapshot_precision), precision_names, "float64, float32 or quantized" },
+    { "snapshot.tolerance", PARAM_DOUBLE, offsetof(struct Params, snapshot_tolerance), NULL, "error bound of quantized snapshots" },
+    { "sampler.roi",        PARAM_INT4,   offsetof(struct Params, sampler_roi),        NULL, "i0,j0,i1,j1 (0,0,0,0: whole domain)" },
+    { "sampler.factor",     PARAM_INT,    offsetof(struct Params, sampler_factor),     NULL, "one sample per factor x factor cells" },
+    { "sampler.mode",       PARAM_ENUM,   offsetof(struct Params, sampler_mode),       mode_names, "stride or average" },
+    DFT_KEYS(0),
+    DFT_KEYS(1),
+    DFT_KEYS(2),
+    DFT_KEYS(3),
+    { "ntff.offset",        PARAM_INT,    offsetof(struct Params, ntff_offset),        NULL, "cells between the NTFF contour and the PML" },
+    { "ntff.freq",          PARAM_LIST,   offsetof(struct Params, ntff_freq),          NULL, "frequencies [Hz] (none: c/wavelength)" },
+    { "ntff.angles",        PARAM_INT,    offsetof(struct Params, ntff_angles),        NULL, "angles of the far field over 360 degrees" },
+    { "ntff.file",          PARAM_STRING, offsetof(struct Params, ntff_file),          NULL, "scattering width (empty: off)" },
+    { "probe.points",       PARAM_STRING, offsetof(struct Params, probe_points),       NULL, "comp:i:j,... with comp ex, ey or hz (empty: none)" },
+    { "probe.lines",        PARAM_STRING, offsetof(struct Params, probe_lines),        NULL, "comp:i0:j0:i1:j1,... (empty: none)" },
+    { "probe.file",         PARAM_STRING, offsetof(struct Params, probe_file),         NULL, "probes of a rank in <file>_r<rank>.bin" },
+    { "stats.interval",     PARAM_INT,    offsetof(struct Params, stats_interval),     NULL, "steps between two samples (0: off)" },
+    { "stats.emax",         PARAM_DOUBLE, offsetof(struct Params, stats_emax),         NULL, "max |E| of a diverged run (0: no limit)" },
+    { "stats.tolerance",    PARAM_DOUBLE, offsetof(struct Params, stats_tolerance),    NULL, "energy change of a converged run (0: never)" },
+    { "stats.file",         PARAM_STRING, offsetof(struct Params, stats_file),         NULL, "table of the statistics" },
+    { "trace.capacity",     PARAM_INT,    offsetof(struct Params, trace_capacity),     NULL, "trace events kept per rank (0: off)" },
+    { "trace.file",         PARAM_STRING, offsetof(struct Params, trace_file),         NULL, "Chrome trace JSON" },
+    { "tune.mode",          PARAM_ENUM,   offsetof(struct Params, tune_mode),          tune_names, "tiles of the kernels: off, auto (tuning database) or force" },
+    { "tune.db",            PARAM_STRING, offsetof(struct Params, tune_db),            NULL, "tuning database" },
+    { "ensemble.cases",     PARAM_STRING, offsetof(struct Params, ensemble_cases),     NULL, "sweep file of run_ensemble, key=value overrides per line" },
+    { "ensemble.threads",   PARAM_INT,    offsetof(struct Params, ensemble_threads),   NULL, "cases run concurrently (0: all processors)" }
+};
+
+static const int nkeys = sizeof(params_keys)/sizeof(params_keys[0]);
+
+void params_init(struct Params *p)
+{
+    memset(p, 0, sizeof(struct Params));
+
+    p->nx                 = 0;
+    p->ny                 = 0;
+    p->nsubdomains        = 0;
+    p->nt                 = 1000;
+    p->nout               = 0;
+    p->pml                = 8;
+    p->dx                 = 10.0*1.0e-9;
+    p->dy                 = 10.0*1.0e-9;
+    p->courant            = 0.2;
+    p->backend            = BACKEND_AUTO;
+
+    p->wavelength         = 500.0*1.0e-9;
+    p->source_waveform    = WAVEFORM_SINUSOID;
+    p->source_amplitude   = 80.0;
+    p->source_j           = 0;
+
+    p->output_format      = OUTPUT_BMP;
+    p->output_fps         = 25;
+    p->snapshot_fields    = 0;
+    p->snapshot_precision = SNAPSHOT_FLOAT32;
+    p->sampler_factor     = 1;
+    p->sampler_mode       = SAMPLER_STRIDE;
+
+    for (int n=0; n<PARAMS_DFT_MAX; n++) {
+        p->dft[n].component = FIELD_EX;
+    }
+    p->ntff_offset        = 4;
+    p->ntff_angles        = 360;
+    strcpy(p->probe_file, "probe");
+    p->stats_interval     = 0;
+    p->stats_emax         = 1.0e6;
+    strcpy(p->stats_file, "stats.txt");
+    p->trace_capacity     = 0;
+    strcpy(p->trace_file, "trace.json");
+    p->tune_mode          = AUTOTUNE_OFF;
+    strcpy(p->tune_db, "tuning.db");
+}
+
+static char *trim(char *s)
+{
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return s;
+}
+
+static bool parse_int(const char *value, int *v)
+{
+    char *end;
+    const long l = strtol(value, &end, 10);
+    if (end == value || *end != '\0') return false;
+    *v = (int)l;
+    return true;
+}
+
+static bool parse_double(const char *value, double *v)
+{
+    char *end;
+    *v = strtod(value, &end);
+    return end != value && *end == '\0';
+}
+
+bool params_set(struct Params *p, const char *key, const char *value)
+{
+    int k;
+    for (k=0; k<nkeys; k++) {
+        if (strcmp(params_keys[k].key, key) == 0) break;
+    }
+    if (k == nkeys) {
+        fprintf(stderr, "Error: unknown parameter %s\n", key);
+        return false;
+    }
+
+    void *field = (char *)p + params_keys[k].offset;
+    bool ok = true;
+    switch (params_keys[k].type) {
+    case PARAM_INT:
+        ok = parse_int(value, (int *)field);
+        break;
+    case PARAM_DOUBLE:
+        ok = parse_double(value, (double *)field);
+        break;
+    case PARAM_STRING:
+        ok = strlen(value) < PARAMS_STRING_LEN;
+        if (ok) strcpy((char *)field, value);
+        break;
+    case PARAM_ENUM:
+        ok = false;
+        for (int n=0; params_keys[k].names[n] != NULL; n++) {
+            if (strcmp(params_keys[k].names[n], value) == 0) {
+                *(int *)field = n;
+                ok = true;
+            }
+        }
+        break;
+    case PARAM_FIELDS: {
+        unsigned int fields = 0;
+        char buf[PARAMS_STRING_LEN];
+        snprintf(buf, sizeof(buf), "%s", value);
+        char *saveptr;
+        for (char *tok = strtok_r(buf, ", ", &saveptr); tok != NULL && ok; tok = strtok_r(NULL, ", ", &saveptr)) {
+            if      (strcmp(tok, "ex")   == 0) fields |= SNAPSHOT_EX;
+            else if (strcmp(tok, "ey")   == 0) fields |= SNAPSHOT_EY;
+            else if (strcmp(tok, "hz")   == 0) fields |= SNAPSHOT_HZ;
+            else if (strcmp(tok, "none") != 0) ok = false;
+        }
+        if (ok) *(unsigned int *)field = fields;
+        break;
+    }
+    case PARAM_INT4: {
+        int *v = (int *)field;
+        char tail;
+        ok = sscanf(value, "%d,%d,%d,%d%c", &v[0], &v[1], &v[2], &v[3], &tail) == 4;
+        break;
+    }
+    case PARAM_LIST: {
+        struct ParamsList list = { 0 };
+        char buf[PARAMS_STRING_LEN];
+        snprintf(buf, sizeof(buf), "%s", value);
+        char *saveptr;
+        for (char *tok = strtok_r(buf, ", ", &saveptr); tok != NULL && ok; tok = strtok_r(NULL, ", ", &saveptr)) {
+            if (strcmp(tok, "none") == 0) continue;
+            ok = list.n < PARAMS_LIST_MAX && parse_double(tok, &list.v[list.n++]);
+        }
+        if (ok) *(struct ParamsList *)field = list;
+        break;
+    }
+    }
+
+    if (!ok) {
+        fprintf(stderr, "Error: invalid value of %s: %s\n", key, value);
+    }
+    return ok;
+}
+
+bool params_assign(struct Params *p, const char *assignment)
+{
+    char buf[2*PARAMS_STRING_LEN];
+    snprintf(buf, sizeof(buf), "%s", assignment);
+    char *eq = strchr(buf, '=');
+    if (eq == NULL) {
+        fprintf(stderr, "Error: %s is not key=value\n", assignment);
+        return false;
+    }
+    *eq = '\0';
+    return params_set(p, trim(buf), trim(eq + 1));
+}
+
+bool params_load(struct Params *p, const char *filename)
+{
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", filename);
+        return false;
+    }
+
+    char line[1024];
+    int  lineno = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), fp) != NULL) {
+        lineno++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+        char *s = trim(line);
+        if (*s == '\0') continue;
+
+        ok = params_assign(p, s);
+        if (!ok) {
+            fprintf(stderr, "Error: %s:%d\n", filename, lineno);
+        }
+    }
+    fclose(fp);
+    return ok;
+}
+
+bool params_parse(struct Params *p, int argc, char *argv[], bool verbose)
+{
+    // The files first, so that the command line overrides them
+    for (int a=1; a<argc; a++) {
+        const char *file = NULL;
+        if ((strcmp(argv[a], "-c") == 0 || strcmp(argv[a], "--config") == 0) && a + 1 < argc) {
+            file = argv[++a];
+        } else if (strncmp(argv[a], "--config=", 9) == 0) {
+            file = argv[a] + 9;
+        } else if (strcmp(argv[a], "-h") == 0 || strcmp(argv[a], "--help") == 0) {
+            if (verbose) params_usage(argv[0], stdout);
+            return false;
+        }
+        if (file != NULL && !params_load(p, file)) return false;
+    }
+
+    static const char *const positional[] = { "nx", "ny", "nsubdomains", "nt", "nout", "geometry" };
+    int npositional = 0;
+    for (int a=1; a<argc; a++) {
+        const char *arg = argv[a];
+        if (strcmp(arg, "-c") == 0 || strcmp(arg, "--config") == 0) {
+            a++;
+        } else if (strncmp(arg, "--config=", 9) == 0) {
+            continue;
+        } else if (strchr(arg, '=') != NULL) {
+            if (!params_assign(p, strncmp(arg, "--", 2) == 0 ? arg + 2 : arg)) return false;
+        } else if (npositional < 6) {
+            if (!params_set(p, positional[npositional++], arg)) return false;
+        } else {
+            fprintf(stderr, "Error: unexpected argument %s\n", arg);
+            return false;
+        }
+    }
+
+    if (!params_check(p, verbose)) {
+        if (verbose) params_usage(argv[0], stderr);
+        return false;
+    }
+    return true;
+}
+
+bool params_check(const struct Params *p, bool verbose)
+{
+    if (p->nx <= 0 || p->ny <= 0 || p->nt < 0 || p->pml < 1 || p->dx <= 0.0 || p->dy <= 0.0 ||
+        p->courant <= 0.0 || p->courant > 1.0 || p->wavelength <= 0.0 || p->sampler_factor < 1 ||
+        p->ensemble_threads < 0) {
+        if (verbose) {
+            fprintf(stderr, "Error: nx, ny > 0, pml >= 1, dx, dy, wavelength > 0, 0 < courant <= 1, "
+                    "sampler.factor >= 1 and ensemble.threads >= 0 are required\n");
+        }
+        return false;
+    }
+    if (p->ntff_file[0] != '\0' &&
+        (p->ntff_offset < 1 || 2*p->ntff_offset >= p->nx || 2*p->ntff_offset >= p->ny || p->ntff_angles < 1)) {
+        if (verbose) {
+            fprintf(stderr, "Error: ntff.offset >= 1, a contour inside the domain and ntff.angles >= 1 are required\n");
+        }
+        return false;
+    }
+    for (int n=0; n<PARAMS_DFT_MAX; n++) {
+        const int *r = p->dft[n].region;
+        const bool whole = r[0] == 0 && r[1] == 0 && r[2] == 0 && r[3] == 0;
+        if (p->dft[n].file[0] != '\0' && !whole &&
+            !(0 <= r[0] && r[0] < r[2] && r[2] <= p->nx && 0 <= r[1] && r[1] < r[3] && r[3] <= p->ny)) {
+            if (verbose) {
+                fprintf(stderr, "Error: dft.%d.region = %d,%d,%d,%d is not 0,0,0,0 or "
+                        "0 <= i0 < i1 <= nx, 0 <= j0 < j1 <= ny\n", n, r[0], r[1], r[2], r[3]);
+            }
+            return false;
+        }
+    }
+    const struct Range inside_global = { { p->nx, p->ny }, { 0, 0 } };
+    struct Probes probes;
+    probes_init(&probes);
+    const bool probes_ok = probes_parse(&probes, p->probe_points, p->probe_lines, &inside_global);
+    probes_free(&probes);
+    if (!probes_ok) {
+        return false;
+    }
+    if ((p->source_waveform == WAVEFORM_GAUSSIAN || p->source_waveform == WAVEFORM_MODULATED_GAUSSIAN) &&
+        p->source_tau <= 0.0) {
+        if (verbose) {
+            fprintf(stderr, "Error: source.tau > 0 is required by the gaussian waveforms\n");
+        }
+        return false;
+    }
+    return true;
+}
+
+// %.15g unless it does not read back to the same value
+static void write_double(FILE *fp, double v)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.15g", v);
+    if (strtod(buf, NULL) != v) snprintf(buf, sizeof(buf), "%.17g", v);
+    fprintf(fp, "%s", buf);
+}
+
+void params_write(const struct Params *p, FILE *fp, const char *prefix)
+{
+    for (int k=0; k<nkeys; k++) {
+        const void *field = (const char *)p + params_keys[k].offset;
+        fprintf(fp, "%s%-19s = ", prefix, params_keys[k].key);
+        switch (params_keys[k].type) {
+        case PARAM_INT:
+            fprintf(fp, "%d", *(const int *)field);
+            break;
+        case PARAM_DOUBLE:
+            write_double(fp, *(const double *)field);
+            break;
+        case PARAM_STRING:
+            fprintf(fp, "%s", (const char *)field);
+            break;
+        case PARAM_ENUM:
+            fprintf(fp, "%s", params_keys[k].names[*(const int *)field]);
+            break;
+        case PARAM_FIELDS: {
+            const unsigned int fields = *(const unsigned int *)field;
+            if (fields == 0) fprintf(fp, "none");
+            fprintf(fp, "%s%s%s%s%s",
+                    fields & SNAPSHOT_EX ? "ex" : "",
+                    (fields & SNAPSHOT_EX) && (fields & (SNAPSHOT_EY | SNAPSHOT_HZ)) ? "," : "",
+                    fields & SNAPSHOT_EY ? "ey" : "",
+                    (fields & SNAPSHOT_EY) && (fields & SNAPSHOT_HZ) ? "," : "",
+                    fields & SNAPSHOT_HZ ? "hz" : "");
+            break;
+        }
+        case PARAM_INT4: {
+            const int *v = (const int *)field;
+            fprintf(fp, "%d,%d,%d,%d", v[0], v[1], v[2], v[3]);
+            break;
+        }
+        case PARAM_LIST: {
+            const struct ParamsList *list = (const struct ParamsList *)field;
+            if (list->n == 0) fprintf(fp, "none");
+            for (int n=0; n<list->n; n++) {
+                if (n > 0) fprintf(fp, ",");
+                write_double(fp, list->v[n]);
+            }
+            break;
+        }
+        }
+        fprintf(fp, "\n");
+    }
+}
+
+void params_region(const int roi[4], const struct Range *domain, struct Range *region)
+{
+    *region = *domain;
+    if (roi[2] > roi[0] && roi[3] > roi[1]) {
+        for (int a=0; a<2; a++) {
+            region->begin [a] = roi[a];
+            region->length[a] = roi[a + 2] - roi[a];
+        }
+    }
+}
+
+void params_usage(const char *program, FILE *fp)
+{
+    fprintf(fp, "%s [<nx> <ny> <nsubdomains> <nt> <nout> [geometry file]] [-c file] [key=value ...]\n", program);
+    for (int k=0; k<nkeys; k++) {
+        fprintf(fp, "  %-19s %s\n", params_keys[k].key, params_keys[k].help);
+    }
+}
@@ -0,0 +1,139 @@
+/**
+ * @file params.h
+ * @brief Run parameters from a key/value file and the command line
+ *
+ *   run [<nx> <ny> <nsubdomains> <nt> <nout> [geometry file]]
+ *       [-c file] [key=value ...]
+ *
+ * The parameters are the defaults, then the files given with -c (or
+ * --config) in order, then the positional arguments of the original
+ * command line, then the key=value (or --key=value) arguments.  A file
+ * has one "key = value" per line; '#' starts a comment.  params_write()
+ * prints the parameters in the same format, so the copy written next to
+ * the output (output.config=run.cfg) reproduces the run.  The snapshots,
+ * the statistics, the trace and the other monitors are off unless their
+ * keys turn them on.  "run -h" lists the keys.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "config.h"
+
+#define PARAMS_STRING_LEN 256
+#define PARAMS_LIST_MAX   16
+#define PARAMS_DFT_MAX    4
+
+enum ParamsBackend {
+    BACKEND_AUTO = 0, // the GPU when there is one
+    BACKEND_GPU  = 1,
+    BACKEND_HOST = 2
+};
+
+// "a,b,c"; "none": empty
+struct ParamsList {
+    int    n;
+    double v[PARAMS_LIST_MAX];
+};
+
+// DFT monitor of the keys dft.<n>.*
+struct ParamsDft {
+    int    region[4];        // i0, j0, i1, j1; 0,0,0,0: whole domain
+    int    component;        // FIELD_*
+    struct ParamsList freq;  // [Hz]; empty: c/wavelength
+    char   file[PARAMS_STRING_LEN]; // empty: no DFT monitor
+};
+
+struct Params {
+    // Grid and run
+    int    nx, ny;           // inside cells
+    int    nsubdomains;      // 0: number of ranks
+    int    nt, nout;         // steps, steps between two outputs (0: no output)
+    int    pml;              // PML cells on each side (mgn)
+    double dx, dy;           // [m]
+    double courant;          // dt = courant / (c sqrt(1/dx^2 + 1/dy^2))
+    char   geometry[PARAMS_STRING_LEN]; // empty: built-in scenario
+    int    backend;
+
+    // Plane wave source on the row source_j (inside cells)
+    double wavelength;       // [m]
+    int    source_waveform;  // WAVEFORM_*
+    double source_amplitude;
+    double source_t0, source_tau; // [sec]
+    int    source_j;
+
+    // Images and snapshots
+    int    output_format;    // OUTPUT_*
+    int    output_threads;
+    int    output_fps;
+    char   output_stream[PARAMS_STRING_LEN];
+    char   output_config[PARAMS_STRING_LEN]; // empty: no copy of the parameters
+    unsigned int snapshot_fields; // SNAPSHOT_*; 0: no snapshot
+    int    snapshot_precision;
+    double snapshot_tolerance;
+    int    sampler_roi[4];   // i0, j0, i1, j1; empty: whole domain
+    int    sampler_factor;
+    int    sampler_mode;     // SAMPLER_*
+
+    // Monitors
+    struct ParamsDft dft[PARAMS_DFT_MAX];
+    int    ntff_offset;      // cells between the contour and the PML
+    struct ParamsList ntff_freq; // [Hz]; empty: c/wavelength
+    int    ntff_angles;
+    char   ntff_file[PARAMS_STRING_LEN]; // empty: no NTFF
+    char   probe_points[PARAMS_STRING_LEN]; // "comp:i:j,..." (probe.h)
+    char   probe_lines[PARAMS_STRING_LEN];  // "comp:i0:j0:i1:j1,..."
+    char   probe_file[PARAMS_STRING_LEN];   // <probe_file>_r<rank>.bin
+    int    stats_interval;
+    double stats_emax;
+    double stats_tolerance;
+    char   stats_file[PARAMS_STRING_LEN];
+    int    trace_capacity;
+    char   trace_file[PARAMS_STRING_LEN];
+
+    // Tiles of the kernels (autotune.h)
+    int    tune_mode;                         // AUTOTUNE_*
+    char   tune_db[PARAMS_STRING_LEN];
+
+    // Ensemble of runs (run_ensemble)
+    char   ensemble_cases[PARAMS_STRING_LEN]; // sweep file, see ensemble.h
+    int    ensemble_threads;                  // 0: all processors
+};
+
+void params_init(struct Params *p);
+
+/**
+ * @brief parse the command line (and the files it names)
+ *
+ * @return false on an error or -h; the message is printed when verbose
+ */
+bool params_parse(struct Params *p, int argc, char *argv[], bool verbose);
+bool params_load(struct Params *p, const char *filename);
+bool params_set(struct Params *p, const char *key, const char *value);
+bool params_assign(struct Params *p, const char *assignment); // "key=value"
+
+/**
+ * @brief check the ranges of the parameters
+ *
+ * @return false when a run is not possible; the message is printed when verbose
+ */
+bool params_check(const struct Params *p, bool verbose);
+void params_write(const struct Params *p, FILE *fp, const char *prefix);
+
+/**
+ * @brief the cells i0 <= i < i1, j0 <= j < j1 of a region key in domain
+ *
+ * An empty region (i1 <= i0 or j1 <= j0, e.g. 0,0,0,0) is the whole domain.
+ */
+void params_region(const int roi[4], const struct Range *domain, struct Range *region);
+void params_usage(const char *program, FILE *fp);
+
+#endif /* PARAMS_H */
@@ -0,0 +1,278 @@
+/**
+ * @file probe.c
+ * @brief Point and line probes
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$ 
+ */
+
+#include "probe.h"
+#include <stdlib.h>
+#include <string.h>
+#include "setup.h"
+
+void probes_init(struct Probes *p)
+{
+    memset(p, 0, sizeof(struct Probes));
+    p->ticket[0] = -1;
+    p->ticket[1] = -1;
+}
+
+void probes_add_point(struct Probes *p, int comp, int i, int j)
+{
+    if (p->npoints == p->npoints_max) {
+        p->npoints_max = p->npoints_max > 0 ? 2*p->npoints_max : 256;
+        p->point_i     = (int *)realloc(p->point_i   , sizeof(int)*p->npoints_max);
+        p->point_j     = (int *)realloc(p->point_j   , sizeof(int)*p->npoints_max);
+        p->point_comp  = (int *)realloc(p->point_comp, sizeof(int)*p->npoints_max);
+    }
+    const int n = p->npoints++;
+    p->point_i   [n] = i;
+    p->point_j   [n] = j;
+    p->point_comp[n] = comp;
+}
+
+void probes_add_line(struct Probes *p, int comp, int i0, int j0, int i1, int j1)
+{
+    const int n = line_cells(i0, j0, i1, j1, NULL, NULL);
+    int *ci = (int *)malloc(sizeof(int)*2*n);
+    line_cells(i0, j0, i1, j1, ci, ci + n);
+    for (int k=0; k<n; k++) {
+        probes_add_point(p, comp, ci[k], ci[n + k]);
+    }
+    free(ci);
+}
+
+static bool parse_comp(const char *name, int *comp)
+{
+    static const char *const names[] = { "ex", "ey", "hz" };
+    for (int c=FIELD_EX; c<=FIELD_HZ; c++) {
+        if (strcmp(name, names[c]) == 0) {
+            *comp = c;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool inside_range(const struct Range *r, int i, int j)
+{
+    return i >= r->begin[0] && i < r->begin[0] + r->length[0] &&
+           j >= r->begin[1] && j < r->begin[1] + r->length[1];
+}
+
+bool probes_parse(struct Probes *p, const char *points, const char *lines,
+                  const struct Range *inside_global)
+{
+    for (int l=0; l<2; l++) {
+        const char *spec = l == 0 ? points : lines;
+        char *buf = strdup(spec);
+        char *saveptr;
+        bool ok = true;
+        for (char *tok = strtok_r(buf, ", ", &saveptr); tok != NULL && ok; tok = strtok_r(NULL, ", ", &saveptr)) {
+            char name[8];
+            int  v[4];
+            char tail;
+            int  comp;
+            if (l == 0) {
+                ok = sscanf(tok, "%7[a-z]:%d:%d%c", name, &v[0], &v[1], &tail) == 3 && parse_comp(name, &comp);
+                v[2] = v[0];
+                v[3] = v[1];
+            } else {
+                ok = sscanf(tok, "%7[a-z]:%d:%d:%d:%d%c", name, &v[0], &v[1], &v[2], &v[3], &tail) == 5 &&
+                     parse_comp(name, &comp);
+            }
+            // A line stays in the bounding box of its ends (v[2], v[3] of a point is the point)
+            if (!ok) {
+                fprintf(stderr, "Error: invalid probe %s\n", tok);
+            } else if (!inside_range(inside_global, v[0], v[1]) || !inside_range(inside_global, v[2], v[3])) {
+                fprintf(stderr, "Error: probe %s is outside the domain [%d, %d) x [%d, %d)\n", tok,
+                        inside_global->begin[0], inside_global->begin[0] + inside_global->length[0],
+                        inside_global->begin[1], inside_global->begin[1] + inside_global->length[1]);
+                ok = false;
+            } else if (l == 0) {
+                probes_add_point(p, comp, v[0], v[1]);
+            } else {
+                probes_add_line(p, comp, v[0], v[1], v[2], v[3]);
+            }
+        }
+        free(buf);
+        if (!ok) return false;
+    }
+    return true;
+}
+
+struct ProbeCell {
+    int comp;
+    int ix;
+    int id;
+};
+
+static int compare_probe_cell(const void *a, const void *b)
+{
+    const struct ProbeCell *ca = (const struct ProbeCell *)a;
+    const struct ProbeCell *cb = (const struct ProbeCell *)b;
+    if (ca->comp != cb->comp) return ca->comp - cb->comp;
+    if (ca->ix   != cb->ix  ) return (ca->ix > cb->ix) - (ca->ix < cb->ix);
+    return ca->id - cb->id;
+}
+
+static void write_block(void *arg)
+{
+    const struct ProbeWriteJob *job = (const struct ProbeWriteJob *)arg;
+    struct Probes *p = job->probes;
+    const int b = job->b;
+    
+    fwrite(p->block_steps[b], sizeof(int), 2, p->fp);
+    fwrite(p->buf[b], sizeof(FLOAT), (size_t)p->block_steps[b][1]*p->nlocal, p->fp);
+}
+
+void probes_setup(struct Probes *p, const struct Range *whole, const struct Range *inside,
+                  int nblock, const char *filename)
+{
+    const int inside_end[] = { inside->begin[0] + inside->length[0],
+                               inside->begin[1] + inside->length[1] };
+    const int lnx = whole->length[0];
+    
+    struct ProbeCell *cells = (struct ProbeCell *)malloc(sizeof(struct ProbeCell)*(p->npoints + 1));
+    int n = 0;
+    for (int k=0; k<p->npoints; k++) {
+        const int i = p->point_i[k];
+        const int j = p->point_j[k];
+        if (i < inside->begin[0] || i >= inside_end[0] ||
+            j < inside->begin[1] || j >= inside_end[1]) continue;
+        cells[n].comp = p->point_comp[k];
+        cells[n].ix   = (j - whole->begin[1])*lnx + (i - whole->begin[0]);
+        cells[n].id   = k;
+        n++;
+    }
+    qsort(cells, n, sizeof(struct ProbeCell), compare_probe_cell);
+
+    p->nlocal = n;
+    p->nblock = nblock;
+    p->index  = (int *)malloc(sizeof(int)*(n + 1));
+    p->comp   = (int *)malloc(sizeof(int)*(n + 1));
+    p->id     = (int *)malloc(sizeof(int)*(n + 1));
+    for (int k=0; k<n; k++) {
+        p->index[k] = cells[k].ix;
+        p->comp [k] = cells[k].comp;
+        p->id   [k] = cells[k].id;
+    }
+    free(cells);
+    
+    if (n == 0) return;
+
+    const int nbuf = nblock*n;
+    p->buf[0] = (FLOAT *)malloc(sizeof(FLOAT)*nbuf);
+    p->buf[1] = (FLOAT *)malloc(sizeof(FLOAT)*nbuf);
+
+    int   *index = p->index;
+    int   *comp  = p->comp;
+    FLOAT *buf0  = p->buf[0];
+    FLOAT *buf1  = p->buf[1];
+#pragma acc enter data copyin(index[0:n], comp[0:n]) create(buf0[0:nbuf], buf1[0:nbuf])
+
+    p->fp = fopen(filename, "wb");
+    if (p->fp == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", filename);
+        return;
+    }
+    
+    const int header[] = { n, (int)sizeof(FLOAT) };
+    fwrite("PRB1", 1, 4, p->fp);
+    fwrite(header, sizeof(int), 2, p->fp);
+    for (int k=0; k<n; k++) {
+        const int id = p->id[k];
+        const int rec[] = { id, p->point_comp[id], p->point_i[id], p->point_j[id] };
+        fwrite(rec, sizeof(int), 4, p->fp);
+    }
+
+    worker_start(&p->worker);
+}
+
+static void flush_block(struct Probes *p)
+{
+    if (p->nsteps == 0) return;
+
+    const int b     = p->cur;
+    const int nbuf  = p->nsteps*p->nlocal;
+    FLOAT *buf      = p->buf[b];
+#pragma acc update self(buf[0:nbuf])
+
+    p->block_steps[b][0] = p->step_begin;
+    p->block_steps[b][1] = p->nsteps;
+    p->job[b].probes = p;
+    p->job[b].b      = b;
+    p->ticket[b] = worker_submit(&p->worker, write_block, &p->job[b]);
+
+    // Switch to the other buffer once its previous block has been written
+    p->cur = 1 - b;
+    if (p->ticket[p->cur] >= 0) {
+        worker_wait(&p->worker, p->ticket[p->cur]);
+        p->ticket[p->cur] = -1;
+    }
+    p->nsteps = 0;
+}
+
+void probes_sample(struct Probes *p, int step, const FLOAT *ex, const FLOAT *ey, const FLOAT *hz)
+{
+    const int n = p->nlocal;
+    if (n == 0 || p->fp == NULL) return;
+
+    if (p->nsteps == 0) {
+        p->step_begin = step;
+    }
+    
+    const int *index = p->index;
+    const int *comp  = p->comp;
+    FLOAT     *buf   = p->buf[p->cur];
+    const int  off   = p->nsteps*n;
+
+#pragma acc kernels present(index, comp, buf, ex, ey, hz)
+#pragma acc loop independent
+    for (int k=0; k<n; k++) {
+        const int ix = index[k];
+        buf[off + k] = comp[k] == FIELD_EX ? ex[ix] :
+                       comp[k] == FIELD_EY ? ey[ix] : hz[ix];
+    }
+
+    p->nsteps++;
+    if (p->nsteps == p->nblock) {
+        flush_block(p);
+    }
+}
+
+void probes_free(struct Probes *p)
+{
+    if (p->nlocal > 0) {
+        if (p->fp != NULL) {
+            flush_block(p);
+            worker_stop(&p->worker);
+            fclose(p->fp);
+        }
+        
+        const int n    = p->nlocal;
+        const int nbuf = p->nblock*n;
+        int   *index = p->index;
+        int   *comp  = p->comp;
+        FLOAT *buf0  = p->buf[0];
+        FLOAT *buf1  = p->buf[1];
+#pragma acc exit data delete(index[0:n], comp[0:n], buf0[0:nbuf], buf1[0:nbuf])
+    }
+
+    free(p->point_i);
+    free(p->point_j);
+    free(p->point_comp);
+    free(p->index);
+    free(p->comp);
+    free(p->id);
+    free(p->buf[0]);
+    free(p->buf[1]);
+    
+    probes_init(p);
+}
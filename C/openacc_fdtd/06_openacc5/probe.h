@@ -0,0 +1,86 @@
+/**
+ * @file probe.h
+ * @brief Point and line probes
+ *
+ * Field time series at selected cells, sampled every step into device
+ * buffers and written in large binary blocks by a background thread.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$ 
+ */
+
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "config.h"
+#include "worker.h"
+
+struct Probes;
+
+struct ProbeWriteJob {
+    struct Probes *probes;
+    int b;
+};
+
+/**
+ * @brief Probe recorder
+ *
+ * Each rank writes the probes it owns to its own file
+ *   "PRB1", int nlocal, int sizeof(FLOAT),
+ *   nlocal x { int id, int comp, int i, int j },
+ * followed by blocks
+ *   int step_begin, int nsteps, FLOAT data[nsteps][nlocal].
+ * The id is the order in which the probe point was added.
+ */
+struct Probes {
+    // Registered probes (global indices)
+    int npoints;
+    int npoints_max;
+    int *point_i;
+    int *point_j;
+    int *point_comp;
+
+    // Local probes (built by probes_setup), sorted by (comp, cell)
+    int nlocal;
+    int *index;
+    int *comp;
+    int *id;
+
+    int   nblock;       // steps per block
+    int   nsteps;       // steps in the current block
+    int   step_begin;
+    int   cur;          // buffer being filled
+    FLOAT *buf[2];      // [nblock][nlocal]
+    long  ticket[2];    // write job of each buffer (-1: none)
+    int   block_steps[2][2];
+    struct ProbeWriteJob job[2];
+    
+    FILE  *fp;
+    struct Worker worker;
+};
+
+void probes_init(struct Probes *p);
+void probes_add_point(struct Probes *p, int comp, int i, int j);
+void probes_add_line(struct Probes *p, int comp, int i0, int j0, int i1, int j1);
+
+/**
+ * @brief add the probes of the keys probe.points and probe.lines
+ *
+ * points: "comp:i:j,...", lines: "comp:i0:j0:i1:j1,...", with comp ex, ey
+ * or hz and global indices in inside_global; an empty string adds nothing.
+ *
+ * @return false on a malformed entry or a cell outside inside_global
+ */
+bool probes_parse(struct Probes *p, const char *points, const char *lines,
+                  const struct Range *inside_global);
+void probes_setup(struct Probes *p, const struct Range *whole, const struct Range *inside,
+                  int nblock, const char *filename);
+void probes_sample(struct Probes *p, int step, const FLOAT *ex, const FLOAT *ey, const FLOAT *hz);
+void probes_free(struct Probes *p);
+
+#endif /* PROBE_H */
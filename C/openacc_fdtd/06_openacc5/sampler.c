@@ -0,0 +1,237 @@
+/**
+ * @file sampler.c
+ * @brief Reduced field output: region of interest, decimation, block average
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#include "sampler.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int imin(int a, int b) { return a < b ? a : b; }
+static int imax(int a, int b) { return a > b ? a : b; }
+
+bool sampler_init(struct Sampler *s, const struct SamplerConfig *cfg, const struct Range *whole_global,
+                  const struct Range *whole, const struct Range *inside)
+{
+    memset(s, 0, sizeof(struct Sampler));
+
+    if (cfg->factor < 1 || (cfg->mode != SAMPLER_STRIDE && cfg->mode != SAMPLER_AVERAGE)) {
+        fprintf(stderr, "Error: invalid output sampling (factor %d, mode %d)\n", cfg->factor, cfg->mode);
+        return false;
+    }
+    s->mode   = cfg->mode;
+    s->factor = cfg->factor;
+    s->whole  = *whole;
+    s->inside = *inside;
+
+    // ROI clipped to whole_global
+    s->roi = *whole_global;
+    if (cfg->roi[2] > cfg->roi[0] && cfg->roi[3] > cfg->roi[1]) {
+        for (int a=0; a<2; a++) {
+            const int b = imax(cfg->roi[a    ], whole_global->begin[a]);
+            const int e = imin(cfg->roi[a + 2], whole_global->begin[a] + whole_global->length[a]);
+            s->roi.begin [a] = b;
+            s->roi.length[a] = e - b;
+        }
+        if (s->roi.length[0] <= 0 || s->roi.length[1] <= 0) {
+            fprintf(stderr, "Error: output region %d %d %d %d is outside the domain\n",
+                    cfg->roi[0], cfg->roi[1], cfg->roi[2], cfg->roi[3]);
+            return false;
+        }
+    }
+
+    const int f = s->factor;
+    for (int a=0; a<2; a++) {
+        s->out.length[a] = (s->roi.length[a] + f - 1)/f;
+        s->out.begin [a] = s->roi.begin[a];
+    }
+
+    // Output rows with cells (average) or the sampled cell (stride) in the inside rows
+    const int y0 = imax(s->roi.begin[1], inside->begin[1]) - s->roi.begin[1];
+    const int y1 = imin(s->roi.begin[1] + s->roi.length[1], inside->begin[1] + inside->length[1]) - s->roi.begin[1];
+    if (y0 < y1) {
+        const int r0 = s->mode == SAMPLER_AVERAGE ? y0/f          : (y0 + f - 1)/f;
+        const int r1 = s->mode == SAMPLER_AVERAGE ? (y1 - 1)/f + 1 : (y1 + f - 1)/f;
+        s->row0  = r0;
+        s->nrows = imax(r1 - r0, 0);
+    }
+    s->nlocal = s->out.length[0]*s->nrows;
+    s->local  = (FLOAT *)calloc(3*s->nlocal + 1, sizeof(FLOAT));
+    FLOAT *local = s->local;
+    const int n  = 3*s->nlocal;
+#pragma acc enter data create(local[0:n])
+
+    int rank = 0;
+    int initialized = 0;
+    s->nprocs = 1;
+    MPI_Initialized(&initialized);
+    if (initialized) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &s->nprocs);
+    }
+
+    const int mine[2] = { s->row0, s->nrows };
+    if (rank == 0) {
+        s->rows   = (int *)malloc(sizeof(int)*2*s->nprocs);
+        s->counts = (int *)malloc(sizeof(int)*s->nprocs);
+        s->displs = (int *)malloc(sizeof(int)*s->nprocs);
+    }
+    if (initialized) {
+        MPI_Gather(mine, 2, MPI_INT, s->rows, 2, MPI_INT, 0, MPI_COMM_WORLD);
+    } else {
+        s->rows[0] = mine[0];
+        s->rows[1] = mine[1];
+    }
+
+    if (rank == 0) {
+        int total = 0;
+        for (int r=0; r<s->nprocs; r++) {
+            s->counts[r] = 3*s->out.length[0]*s->rows[2*r + 1];
+            s->displs[r] = total;
+            total += s->counts[r];
+        }
+        s->recv = (FLOAT *)malloc(sizeof(FLOAT)*(total + 1));
+
+        const int onx = s->out.length[0];
+        const int ony = s->out.length[1];
+        s->weight = (FLOAT *)malloc(sizeof(FLOAT)*onx*ony);
+        for (int J=0; J<ony; J++) {
+            for (int I=0; I<onx; I++) {
+                const int cells = s->mode == SAMPLER_AVERAGE ?
+                    imin(f, s->roi.length[0] - I*f)*imin(f, s->roi.length[1] - J*f) : 1;
+                s->weight[J*onx + I] = 1.0/cells;
+            }
+        }
+    }
+
+    return true;
+}
+
+void sampler_gather(struct Sampler *s, const FLOAT *ex, const FLOAT *ey, const FLOAT *hz,
+                    FLOAT *ex_out, FLOAT *ey_out, FLOAT *hz_out)
+{
+    const int f     = s->factor;
+    const int mode  = s->mode;
+    const int onx   = s->out.length[0];
+    const int row0  = s->row0;
+    const int nrows = s->nrows;
+    const int nl    = s->nlocal;
+    const int lnx   = s->whole.length[0];
+
+    // Array indices of the ROI and of the inside rows
+    const int rx0 = s->roi.begin[0] - s->whole.begin[0];
+    const int rx1 = rx0 + s->roi.length[0];
+    const int ry0 = s->roi.begin[1] - s->whole.begin[1];
+    const int ry1 = ry0 + s->roi.length[1];
+    const int iy0 = s->inside.begin[1] - s->whole.begin[1];
+    const int iy1 = iy0 + s->inside.length[1];
+
+    FLOAT *local = s->local;
+
+#pragma acc kernels present(local[0:3*nl])
+#pragma acc loop independent
+    for (int J=0; J<nrows; J++) {
+#pragma acc loop independent
+        for (int I=0; I<onx; I++) {
+            const int xb = rx0 + I*f;
+            const int yb = ry0 + (row0 + J)*f;
+            FLOAT sx = 0.0, sy = 0.0, sh = 0.0;
+            if (mode == SAMPLER_STRIDE) {
+                const int ix = yb*lnx + xb;
+                sx = ex[ix];
+                sy = ey[ix];
+                sh = hz[ix];
+            } else {
+                const int xe = xb + f < rx1 ? xb + f : rx1;
+                const int ys = yb > iy0 ? yb : iy0;
+                int       ye = yb + f < ry1 ? yb + f : ry1;
+                ye = ye < iy1 ? ye : iy1;
+                for (int y=ys; y<ye; y++) {
+                    for (int x=xb; x<xe; x++) {
+                        const int ix = y*lnx + x;
+                        sx += ex[ix];
+                        sy += ey[ix];
+                        sh += hz[ix];
+                    }
+                }
+            }
+            const int k = J*onx + I;
+            local[k       ] = sx;
+            local[k +   nl] = sy;
+            local[k + 2*nl] = sh;
+        }
+    }
+#pragma acc update self(local[0:3*nl])
+
+    int rank = 0;
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    const FLOAT *recv = local;
+    if (initialized) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Gatherv(local, 3*nl, MPI_FLOAT_T, s->recv, s->counts, s->displs, MPI_FLOAT_T, 0, MPI_COMM_WORLD);
+        recv = s->recv;
+    }
+    if (rank != 0) return;
+
+    // Sum the rows of the ranks; a block split between two ranks comes from both
+    const int nout = onx*s->out.length[1];
+    for (int k=0; k<nout; k++) {
+        ex_out[k] = ey_out[k] = hz_out[k] = 0.0;
+    }
+    for (int r=0; r<s->nprocs; r++) {
+        const FLOAT *src = recv + (initialized ? s->displs[r] : 0);
+        const int    n   = onx*s->rows[2*r + 1];
+        const int    off = onx*s->rows[2*r];
+        for (int k=0; k<n; k++) {
+            ex_out[off + k] += src[k      ];
+            ey_out[off + k] += src[k +   n];
+            hz_out[off + k] += src[k + 2*n];
+        }
+    }
+    if (mode == SAMPLER_AVERAGE) {
+        for (int k=0; k<nout; k++) {
+            ex_out[k] *= s->weight[k];
+            ey_out[k] *= s->weight[k];
+            hz_out[k] *= s->weight[k];
+        }
+    }
+}
+
+void sampler_region(const struct Sampler *s, const struct Range *range, struct Range *region)
+{
+    const int f = s->factor;
+    for (int a=0; a<2; a++) {
+        const int b = imax(range->begin[a], s->roi.begin[a]) - s->roi.begin[a];
+        const int e = imin(range->begin[a] + range->length[a], s->roi.begin[a] + s->roi.length[a]) - s->roi.begin[a];
+        int i0 = 0, i1 = 0;
+        if (b < e) {
+            i0 = s->mode == SAMPLER_AVERAGE ? b/f          : (b + f - 1)/f;
+            i1 = s->mode == SAMPLER_AVERAGE ? (e - 1)/f + 1 : (e + f - 1)/f;
+        }
+        region->begin [a] = s->roi.begin[a] + i0*f;
+        region->length[a] = imax(i1 - i0, 0);
+    }
+}
+
+void sampler_free(struct Sampler *s)
+{
+    FLOAT *local = s->local;
+    const int n  = 3*s->nlocal;
+#pragma acc exit data delete(local[0:n])
+    free(s->local);
+    free(s->rows);
+    free(s->counts);
+    free(s->displs);
+    free(s->recv);
+    free(s->weight);
+    memset(s, 0, sizeof(struct Sampler));
+}
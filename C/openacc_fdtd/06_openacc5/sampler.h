@@ -0,0 +1,85 @@
+/**
+ * @file sampler.h
+ * @brief Reduced field output: region of interest, decimation, block average
+ *
+ * The output grid covers a region of interest (ROI) of the global cells
+ * with one sample per factor x factor cells:
+ *
+ *   SAMPLER_STRIDE  : the value at the first cell of the block
+ *   SAMPLER_AVERAGE : the average over the cells of the block
+ *
+ * Each rank reduces its own rows on the device before any
+ * communication; only the reduced rows are gathered to rank 0, where a
+ * block split between two ranks is summed (so averages may differ in the
+ * last bits between decompositions).  Cells of the ROI which are
+ * in no inside range (the margins of whole_global in y) count as zero,
+ * as in the full gather.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "config.h"
+
+enum SamplerMode {
+    SAMPLER_STRIDE  = 0,
+    SAMPLER_AVERAGE = 1
+};
+
+struct SamplerConfig {
+    int roi[4]; // global cells i0, j0, i1, j1 (i1, j1 excluded); i1 <= i0 or j1 <= j0: whole_global
+    int factor; // cells per sample along each axis; 1: every cell
+    int mode;
+};
+
+struct Sampler {
+    int mode;
+    int factor;
+    struct Range roi;   // global cells
+    struct Range out;   // output grid: length = ceil(roi.length/factor), begin = roi.begin
+
+    // This rank: output rows row0 .. row0+nrows-1, local sums [3][nlocal]
+    struct Range whole;
+    struct Range inside;
+    int   row0, nrows;
+    int   nlocal;
+    FLOAT *local;
+
+    // Rank 0
+    int   nprocs;
+    int   *rows;        // [2*nprocs]: row0, nrows of each rank
+    int   *counts, *displs;
+    FLOAT *recv;
+    FLOAT *weight;      // [out rows][out cols]: 1/(cells of the block)
+};
+
+bool sampler_init(struct Sampler *s, const struct SamplerConfig *cfg, const struct Range *whole_global,
+                  const struct Range *whole, const struct Range *inside);
+
+/**
+ * @brief reduce ex, ey, hz of this rank and assemble the output grid on rank 0
+ *
+ * Collective over MPI_COMM_WORLD when MPI is initialized.  The outputs
+ * [out.length[1]][out.length[0]] are only written on rank 0.
+ */
+void sampler_gather(struct Sampler *s, const FLOAT *ex, const FLOAT *ey, const FLOAT *hz,
+                    FLOAT *ex_out, FLOAT *ey_out, FLOAT *hz_out);
+
+/**
+ * @brief samples of the output grid within range (global cells)
+ *
+ * region->begin is the global cell of the first sample and
+ * region->length the number of samples, as s->out.
+ */
+void sampler_region(const struct Sampler *s, const struct Range *range, struct Range *region);
+void sampler_free(struct Sampler *s);
+
+#endif /* SAMPLER_H */
@@ -11,9 +11,13 @@
  * $Header$ 
  */
 
+#include <stdlib.h>
 #include <math.h>
 #include <openacc.h>
 #include "setup.h"
+#include "geometry.h"
+#include "dispersive.h"
+#include "subgrid.h"
 
 void init_relative_permittivity(const int length[], FLOAT relative_permittivity, FLOAT *er)
 {
@@ -23,12 +27,45 @@ void init_relative_permittivity(const int length[], FLOAT relative_permittivity,
     }
 }
 
-void init_object(const int length[], int *obj)
+void init_object(const int length[], unsigned int *obj_mask)
+{
+    const int nw = OBJECT_MASK_NWORDS(length[0]*length[1]);
+    for (int w=0; w<nw; w++) {
+        obj_mask[w] = 0;
+    }
+}
+
+void init_material(const int length[], unsigned char *mat)
 {
     const int n = length[0]*length[1];
     for (int i=0; i<n; i++) {
-        obj[i] = 0;
+        mat[i] = 0;
+    }
+}
+
+int line_cells(int i0, int j0, int i1, int j1, int *ci, int *cj)
+{
+    const int di = abs(i1 - i0);
+    const int dj = abs(j1 - j0);
+    const int si = i0 < i1 ? 1 : -1;
+    const int sj = j0 < j1 ? 1 : -1;
+    int err = di - dj;
+    int i = i0;
+    int j = j0;
+    int n = 0;
+
+    for (;;) {
+        if (ci != NULL) {
+            ci[n] = i;
+            cj[n] = j;
+        }
+        n++;
+        if (i == i1 && j == j1) break;
+        const int e2 = 2*err;
+        if (e2 > -dj) { err -= dj; i += si; }
+        if (e2 <  di) { err += di; j += sj; }
     }
+    return n;
 }
 
 void init_vars(const int length[], FLOAT *ex, FLOAT *ey, FLOAT *hz)
@@ -44,42 +81,61 @@ void init_vars(const int length[], FLOAT *ex, FLOAT *ey, FLOAT *hz)
     }
 }
 
-void set_initial_condition(const int length[], FLOAT dt, FLOAT dx, FLOAT dy,
-                           FLOAT e0, const FLOAT *er, FLOAT m0, const int *obj,
+void set_initial_condition(const struct Range *whole, const struct Mesh *mesh, FLOAT dt,
+                           FLOAT e0, const FLOAT *er, FLOAT m0, const unsigned int *obj_mask,
                            FLOAT *cexly, FLOAT *ceylx, FLOAT *chzlx, FLOAT *chzly)
 {
-#pragma acc kernels copyin(length[0:2]) 
+    // cexly (ceylx) per cell with the dual spacing, chzlx (chzly) per column (row)
+    const int lnx = whole->length[0];
+    const int lny = whole->length[1];
+    const int o0  = whole->begin[0] - mesh->whole.begin[0];
+    const int o1  = whole->begin[1] - mesh->whole.begin[1];
+    const FLOAT *dx  = mesh->d [0];
+    const FLOAT *dy  = mesh->d [1];
+    const FLOAT *dxd = mesh->dd[0];
+    const FLOAT *dyd = mesh->dd[1];
+
+#pragma acc kernels present(dxd, dyd)
 #pragma acc loop independent
-    for (int j=0; j<length[1]; j++) {
+    for (int j=0; j<lny; j++) {
 #pragma acc loop independent
-        for (int i=0; i<length[0]; i++) {
-            const int ix = i + j*length[0];
-            const int jm = i + (j-1)*length[0];
-            const int im = (i-1) + j*length[0];
+        for (int i=0; i<lnx; i++) {
+            const int ix = i + j*lnx;
+            const int jm = i + (j-1)*lnx;
+            const int im = (i-1) + j*lnx;
 
             const FLOAT er_ex = j != 0 ? 0.5*(er[ix] + er[jm]) : er[ix];
             const FLOAT er_ey = i != 0 ? 0.5*(er[ix] + er[im]) : er[ix];
             
-            cexly[ix] = dt/(e0*er_ex*dy);
-            ceylx[ix] = dt/(e0*er_ey*dx);
-            chzlx[ix] = dt/(m0*dx);
-            chzly[ix] = dt/(m0*dy);
+            cexly[ix] = dt/(e0*er_ex*dyd[j+o1]);
+            ceylx[ix] = dt/(e0*er_ey*dxd[i+o0]);
 
-            if (obj[ix]) {
+            if (OBJECT_MASK_GET(obj_mask, ix)) {
                 cexly[ix] = 0.0;
                 ceylx[ix] = 0.0;
-                chzlx[ix] = 0.0;
-                chzly[ix] = 0.0;
             }
-            if (j != 0 && obj[jm]) {
+            if (j != 0 && OBJECT_MASK_GET(obj_mask, jm)) {
                 cexly[ix] = 0.0;
             }
-            if (i != 0 && obj[im]) {
+            if (i != 0 && OBJECT_MASK_GET(obj_mask, im)) {
                 ceylx[ix] = 0.0;
             }
 
         }
     }
+
+    // hz inside an object stays zero since all the E around it are zero
+#pragma acc kernels present(dx, dy)
+    {
+#pragma acc loop independent
+        for (int i=0; i<lnx; i++) {
+            chzlx[i] = dt/(m0*dx[i+o0]);
+        }
+#pragma acc loop independent
+        for (int j=0; j<lny; j++) {
+            chzly[j] = dt/(m0*dy[j+o1]);
+        }
+    }
 }
 
 void init_pml_vars(const int length[], FLOAT *exy, FLOAT *eyx, FLOAT *hzx, FLOAT *hzy)
@@ -98,10 +154,11 @@ void init_pml_vars(const int length[], FLOAT *exy, FLOAT *eyx, FLOAT *hzx, FLOAT
 
 
 void set_pml_conf(const struct Range *whole, const struct Range *inside,
-                  unsigned int axis, FLOAT dt, FLOAT ds, int offset,
+                  unsigned int axis, FLOAT dt, const FLOAT *ds, int ds_begin, int offset,
                   FLOAT c, FLOAT e0, FLOAT em0, FLOAT *cs, FLOAT *csl)
 {
     // offset = 0 or 1
+    // ds[i - ds_begin]: spacing at the global index i (dual for E, primary for H)
 
     const int begin = inside->begin[axis];
     const int end   = inside->begin[axis] + inside->length[axis];
@@ -109,28 +166,31 @@ void set_pml_conf(const struct Range *whole, const struct Range *inside,
     const int   mgn       = inside->begin[axis] - whole->begin[axis];
     const FLOAT r0        = 1.0*10e-12;
     const FLOAT m         = 3.0;
-    const FLOAT pmlec_max = - (m+1.0)*e0*c / (2.0*mgn*ds)*log(fabs(r0));
+    const FLOAT ds_lo     = ds[begin   - ds_begin];
+    const FLOAT ds_hi     = ds[end - 1 - ds_begin];
+    const FLOAT pmlec_lo  = - (m+1.0)*e0*c / (2.0*mgn*ds_lo)*log(fabs(r0));
+    const FLOAT pmlec_hi  = - (m+1.0)*e0*c / (2.0*mgn*ds_hi)*log(fabs(r0));
     
-#pragma acc kernels 
+#pragma acc kernels present(ds)
 #pragma acc loop independent
     for (int ii=0; ii<whole->length[axis]; ii++) {
 
         const int   i = ii + whole->begin[axis];
         const FLOAT x = i + offset * 0.5;
         
-        const FLOAT pmlec = i < begin         ? pmlec_max * pow((begin - x)/mgn, m) :
-                            i > end - offset  ? pmlec_max * pow((x - end  )/mgn, m) :
+        const FLOAT pmlec = i < begin         ? pmlec_lo * pow((begin - x)/mgn, m) :
+                            i > end - offset  ? pmlec_hi * pow((x - end  )/mgn, m) :
                                                 0.0;
 
         const FLOAT a = pmlec * dt / (2.0*e0);
         cs [ii] = (1.0 - a)/(1.0 + a);
-        csl[ii] = dt / (em0 * ds) / (1.0 + a);
+        csl[ii] = dt / (em0 * ds[i - ds_begin]) / (1.0 + a);
     }
 
 }
 
 void set_pml_initial_condition(const struct Range *whole, const struct Range *inside,
-                               FLOAT dt, FLOAT dx, FLOAT dy,
+                               const struct Mesh *mesh, FLOAT dt,
                                FLOAT c, FLOAT e0, FLOAT m0, 
                                FLOAT *cexy, FLOAT *ceyx, FLOAT *chzx, FLOAT *chzy,
                                FLOAT *cexyl, FLOAT *ceyxl, FLOAT *chzxl, FLOAT *chzyl)
@@ -140,15 +200,18 @@ void set_pml_initial_condition(const struct Range *whole, const struct Range *in
     const int offset_e = 0;
     const int offset_h = 1;
     
-    set_pml_conf(whole, inside, axis_y, dt, dy, offset_e, c, e0, e0, cexy, cexyl);
-    set_pml_conf(whole, inside, axis_x, dt, dx, offset_e, c, e0, e0, ceyx, ceyxl);
+    const int   bx  = mesh->whole.begin[axis_x];
+    const int   by  = mesh->whole.begin[axis_y];
     
-    set_pml_conf(whole, inside, axis_x, dt, dx, offset_h, c, e0, m0, chzx, chzxl);
-    set_pml_conf(whole, inside, axis_y, dt, dy, offset_h, c, e0, m0, chzy, chzyl);
+    set_pml_conf(whole, inside, axis_y, dt, mesh->dd[axis_y], by, offset_e, c, e0, e0, cexy, cexyl);
+    set_pml_conf(whole, inside, axis_x, dt, mesh->dd[axis_x], bx, offset_e, c, e0, e0, ceyx, ceyxl);
+    
+    set_pml_conf(whole, inside, axis_x, dt, mesh->d [axis_x], bx, offset_h, c, e0, m0, chzx, chzxl);
+    set_pml_conf(whole, inside, axis_y, dt, mesh->d [axis_y], by, offset_h, c, e0, m0, chzy, chzyl);
 }
 
 
-void set_pml_rer(const int length[], const int *obj, const FLOAT *er, FLOAT *rer_ex, FLOAT *rer_ey)
+void set_pml_rer(const int length[], const unsigned int *obj_mask, const FLOAT *er, FLOAT *rer_ex, FLOAT *rer_ey)
 {
 #pragma acc kernels copyin(length[0:2]) 
 #pragma acc loop independent
@@ -162,8 +225,9 @@ void set_pml_rer(const int length[], const int *obj, const FLOAT *er, FLOAT *rer
             const FLOAT er_ex = j != 0 ? 0.5*(er[ix] + er[jm]) : er[ix];
             const FLOAT er_ey = i != 0 ? 0.5*(er[ix] + er[im]) : er[ix];
 
-            const int obj_ex = j != 0 ? (obj[ix] || obj[jm]) : obj[ix];
-            const int obj_ey = i != 0 ? (obj[ix] || obj[im]) : obj[ix];
+            const int obj_ix = OBJECT_MASK_GET(obj_mask, ix);
+            const int obj_ex = j != 0 ? (obj_ix || OBJECT_MASK_GET(obj_mask, jm)) : obj_ix;
+            const int obj_ey = i != 0 ? (obj_ix || OBJECT_MASK_GET(obj_mask, im)) : obj_ix;
             
             rer_ex[ix] = obj_ex == 0 ? 1.0/er_ex : 0.0;
             rer_ey[ix] = obj_ey == 0 ? 1.0/er_ey : 0.0;
@@ -172,3 +236,117 @@ void set_pml_rer(const int length[], const int *obj, const FLOAT *er, FLOAT *rer
     }    
 }
 
+double get_dt(double dx, double dy, double courant)
+{
+    const double c = constant.c;
+
+    const double coef = courant;
+
+    const double rdx = 1.0/dx;
+    const double rdy = 1.0/dy;
+    
+    return coef * 1.0 / (c * sqrt(rdx*rdx + rdy*rdy));
+}
+
+void set_object_er(const struct Range *whole,
+                   FLOAT lx, FLOAT ly, const struct Mesh *mesh, unsigned int *obj_mask, FLOAT *er)
+{
+    const FLOAT y0 = 0.5*ly;
+    const FLOAT y1 = y0 + 0.1*ly;
+    const FLOAT x0 = 0.45*lx;
+    const FLOAT x1 = 0.55*lx;
+
+    // Set relative permittivity
+    const FLOAT relative_permittivity = 5.4;
+
+    // Set media and objects
+    for (int jj=0; jj<whole->length[1]; jj++) {
+        for (int ii=0; ii<whole->length[0]; ii++) {
+            const int ix = ii + jj*whole->length[0];
+            const int i = ii + whole->begin[0];
+            const int j = jj + whole->begin[1];
+
+            const FLOAT x = mesh->xc[0][i - mesh->whole.begin[0]];
+            const FLOAT y = mesh->xc[1][j - mesh->whole.begin[1]];
+
+            if (y >= y0 && y <= y1 &&
+                (x <= x0 || x >= x1)) {
+                OBJECT_MASK_SET(obj_mask, ix);
+            }
+            
+            if (y >= -0.25 * (x-lx) + y1) {
+                er[ix] = relative_permittivity;
+            }
+                
+        }
+    }
+
+}
+
+void set_media(const struct Geometry *geometry, const struct Dispersive *dispersive,
+               const struct Range *whole, FLOAT lx, FLOAT ly, const struct Mesh *mesh,
+               unsigned int *obj_mask, FLOAT *er, unsigned char *mat)
+{
+    init_relative_permittivity(whole->length, 1.0, er); // vacuum
+    init_object(whole->length, obj_mask);
+    init_material(whole->length, mat);
+
+    if (geometry != NULL) {
+        geometry_voxelize(geometry, whole, mesh, obj_mask, er, mat);
+    } else {
+        // User-defined function
+        set_object_er(whole, lx, ly, mesh, obj_mask, er);    
+    }
+    dispersive_apply_er(dispersive, whole->length, mat, er);
+}
+
+double setup_mesh(const struct Geometry *geometry, const struct Range *whole_global,
+                  FLOAT dx, FLOAT dy, double courant, struct Mesh *mesh)
+{
+    mesh_init(mesh, whole_global, dx, dy);
+    for (int k=0; geometry != NULL && k<geometry->ngradings; k++) {
+        const struct Grading *f = &geometry->gradings[k];
+        mesh_grade(mesh, f->axis, f->i0, f->i1, f->d0, f->d1);
+    }
+    mesh_setup(mesh);
+    FLOAT dx_min, dy_min;
+    mesh_min_spacing(mesh, &dx_min, &dy_min);
+    return get_dt(dx_min, dy_min, courant);
+}
+
+bool setup_media(struct Geometry *geometry, const struct Range *inside_global,
+                 const struct Range *whole, const struct Range *inside, const struct Mesh *mesh, double dt,
+                 struct Dispersive *dispersive, struct Subgrid *subgrid,
+                 unsigned int *obj_mask, FLOAT *er, unsigned char *mat)
+{
+    const FLOAT lx = mesh_length(mesh, 0, inside_global->begin[0], inside_global->begin[0] + inside_global->length[0]);
+    const FLOAT ly = mesh_length(mesh, 1, inside_global->begin[1], inside_global->begin[1] + inside_global->length[1]);
+
+    if (geometry != NULL) {
+        geometry_register_materials(geometry, dispersive);
+    }
+    set_media(geometry, dispersive, whole, lx, ly, mesh, obj_mask, er, mat);
+
+    for (int k=0; geometry != NULL && k<geometry->nrefinements; k++) {
+        const struct Refinement *f = &geometry->refinements[k];
+        int i0, i1, j0, j1;
+        mesh_cell_range(mesh, 0, f->bbox[0], f->bbox[2], &i0, &i1);
+        mesh_cell_range(mesh, 1, f->bbox[1], f->bbox[3], &j0, &j1);
+        subgrid_add_patch(subgrid, i0, j0, i1 + 1, j1 + 1, f->ratio);
+    }
+    if (!subgrid_setup(subgrid, whole, inside, mesh, dt)) {
+        return false;
+    }
+    for (int k=0; k<subgrid->npatches; k++) {
+        struct SubgridPatch *p = &subgrid->patches[k];
+        FLOAT         *er_p   = (FLOAT         *)malloc(sizeof(FLOAT)*p->nelems);
+        unsigned char *mat_p  = (unsigned char *)malloc(sizeof(unsigned char)*p->nelems);
+        unsigned int  *mask_p = (unsigned int  *)malloc(sizeof(unsigned int)*OBJECT_MASK_NWORDS(p->nelems));
+        set_media(geometry, dispersive, &p->whole, lx, ly, &p->mesh, mask_p, er_p, mat_p);
+        subgrid_set_media(p, constant.e0, constant.m0, dispersive, mat_p, mask_p, er_p);
+        free(er_p);
+        free(mat_p);
+        free(mask_p);
+    }
+    return true;
+}
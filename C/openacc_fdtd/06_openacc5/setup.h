@@ -15,23 +15,72 @@
 #define SETUP_H
 
 #include <stdio.h>
+#include <stdbool.h>
 #include "config.h"
+#include "mesh.h"
+
+struct Geometry;
+struct Dispersive;
+struct Subgrid;
+
+// Bit-packed object mask: bit (ix & 31) of word (ix >> 5) is 1 in an object.
+// SET and CLEAR are statements (x |= expr, x &= expr) for "acc atomic update".
+#define OBJECT_MASK_NWORDS(n)     (((n) + 31) >> 5)
+#define OBJECT_MASK_GET(m, ix)    (int)(((m)[(ix) >> 5] >> ((ix) & 31)) & 1u)
+#define OBJECT_MASK_SET(m, ix)    (m)[(ix) >> 5] |= 1u << ((ix) & 31)
+#define OBJECT_MASK_CLEAR(m, ix)  (m)[(ix) >> 5] &= ~(1u << ((ix) & 31))
 
 void init_relative_permittivity(const int length[], FLOAT relative_permittivity, FLOAT *er);
-void init_object(const int length[], int *obj);
+void init_object(const int length[], unsigned int *obj_mask);
+void init_material(const int length[], unsigned char *mat);
+
+// Cells (ci[k], cj[k]) of the line from (i0, j0) to (i1, j1), end points included
+// (Bresenham); returns their number, the cells are not stored when ci is NULL
+int  line_cells(int i0, int j0, int i1, int j1, int *ci, int *cj);
 
 void init_vars(const int length[], FLOAT *ex, FLOAT *ey, FLOAT *hz);
-void set_initial_condition(const int length[], FLOAT dt, FLOAT dx, FLOAT dy,
-                           FLOAT e0, const FLOAT *er, FLOAT m0, const int *obj,
+void set_initial_condition(const struct Range *whole, const struct Mesh *mesh, FLOAT dt,
+                           FLOAT e0, const FLOAT *er, FLOAT m0, const unsigned int *obj_mask,
                            FLOAT *cexly, FLOAT *ceylx, FLOAT *chzlx, FLOAT *chzly);
 
 void init_pml_vars(const int length[], FLOAT *exy, FLOAT *eyx, FLOAT *hzx, FLOAT *hzy);
 void set_pml_initial_condition(const struct Range *whole, const struct Range *inside,
-                               FLOAT dt, FLOAT dx, FLOAT dy,
+                               const struct Mesh *mesh, FLOAT dt,
                                FLOAT c, FLOAT e0, FLOAT m0, 
                                FLOAT *cexy, FLOAT *ceyx, FLOAT *chzx, FLOAT *chzy,
                                FLOAT *cexyl, FLOAT *ceyxl, FLOAT *chzxl, FLOAT *chzyl);
-void set_pml_rer(const int length[], const int *obj, const FLOAT *er, FLOAT *rer_ex, FLOAT *rer_ey);
+void set_pml_rer(const int length[], const unsigned int *obj_mask, const FLOAT *er, FLOAT *rer_ex, FLOAT *rer_ey);
+
+// The scenario of the drivers (main.c, main_mpi.c, main_ensemble.c); geometry is
+// NULL for the built-in slit and dielectric of set_object_er()
+double get_dt(double dx, double dy, double courant);
+void set_object_er(const struct Range *whole,
+                   FLOAT lx, FLOAT ly, const struct Mesh *mesh, unsigned int *obj_mask, FLOAT *er);
+void set_media(const struct Geometry *geometry, const struct Dispersive *dispersive,
+               const struct Range *whole, FLOAT lx, FLOAT ly, const struct Mesh *mesh,
+               unsigned int *obj_mask, FLOAT *er, unsigned char *mat);
+
+/**
+ * @brief the mesh of whole_global, graded by the geometry
+ *
+ * @return dt of courant from the smallest cells
+ */
+double setup_mesh(const struct Geometry *geometry, const struct Range *whole_global,
+                  FLOAT dx, FLOAT dy, double courant, struct Mesh *mesh);
+
+/**
+ * @brief the media of the subdomain and the subgrid patches on the refine boxes
+ *
+ * Registers the materials of the geometry in dispersive, sets obj_mask, er
+ * and mat of whole, and adds and sets up the patches of the (initialized)
+ * subgrid with their media at the fine resolution.
+ *
+ * @return false when the subgrid cannot be set up
+ */
+bool setup_media(struct Geometry *geometry, const struct Range *inside_global,
+                 const struct Range *whole, const struct Range *inside, const struct Mesh *mesh, double dt,
+                 struct Dispersive *dispersive, struct Subgrid *subgrid,
+                 unsigned int *obj_mask, FLOAT *er, unsigned char *mat);
 
 #endif /* SETUP_H */
 
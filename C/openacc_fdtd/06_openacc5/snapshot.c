@@ -0,0 +1,458 @@
+/**
+ * @file snapshot.c
+ * @brief Compressed field snapshots
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#include "snapshot.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define LZ_HASH_BITS 16
+#define BAND_ELEMS   (1 << 18)
+#define QUANT_MAX    ((1 << 30) - 1)
+
+static uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static uint8_t *put_length(uint8_t *op, int len)
+{
+    for (; len >= 255; len -= 255) *op++ = 255;
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+// LZ4 block format; returns the compressed size, or -1 if it exceeds cap
+static int lz_compress(const uint8_t *src, int n, uint8_t *dst, int cap, uint32_t *table)
+{
+    const int mflimit    = n - 12;
+    const int matchlimit = n - 5;
+    uint8_t *op  = dst;
+    uint8_t *end = dst + cap;
+    int ip     = 0;
+    int anchor = 0;
+
+    memset(table, 0, sizeof(uint32_t) << LZ_HASH_BITS);
+
+    while (ip < mflimit) {
+        const uint32_t seq = read32(src + ip);
+        const uint32_t h   = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+        const int      ref = (int)table[h] - 1;
+        table[h] = ip + 1;
+
+        if (ref < 0 || ip - ref > 65535 || read32(src + ref) != seq) {
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+
+        int len = 4;
+        while (ip + len < matchlimit && src[ref + len] == src[ip + len]) len++;
+
+        const int lit = ip - anchor;
+        if (op + 1 + lit/255 + 1 + lit + 2 + (len - 4)/255 + 1 > end) return -1;
+        uint8_t *token = op++;
+        *token = (uint8_t)((lit >= 15 ? 15 : lit) << 4);
+        if (lit >= 15) op = put_length(op, lit - 15);
+        memcpy(op, src + anchor, lit);
+        op += lit;
+        *op++ = (uint8_t)((ip - ref)     );
+        *op++ = (uint8_t)((ip - ref) >> 8);
+        const int ml = len - 4;
+        *token |= (uint8_t)(ml >= 15 ? 15 : ml);
+        if (ml >= 15) op = put_length(op, ml - 15);
+
+        ip    += len;
+        anchor = ip;
+    }
+
+    const int lit = n - anchor;
+    if (op + 1 + lit/255 + 1 + lit > end) return -1;
+    *op++ = (uint8_t)((lit >= 15 ? 15 : lit) << 4);
+    if (lit >= 15) op = put_length(op, lit - 15);
+    memcpy(op, src + anchor, lit);
+    op += lit;
+
+    return (int)(op - dst);
+}
+
+static bool lz_decompress(const uint8_t *src, int n, uint8_t *dst, int size)
+{
+    int ip = 0;
+    int op = 0;
+    while (ip < n) {
+        const int token = src[ip++];
+        int lit = token >> 4;
+        if (lit == 15) {
+            int b;
+            do {
+                if (ip >= n) return false;
+                b = src[ip++];
+                lit += b;
+            } while (b == 255);
+        }
+        if (ip + lit > n || op + lit > size) return false;
+        memcpy(dst + op, src + ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip >= n) break;
+
+        if (ip + 2 > n) return false;
+        const int offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        int ml = token & 15;
+        if (ml == 15) {
+            int b;
+            do {
+                if (ip >= n) return false;
+                b = src[ip++];
+                ml += b;
+            } while (b == 255);
+        }
+        ml += 4;
+        if (offset == 0 || offset > op || op + ml > size) return false;
+        for (int k=0; k<ml; k++) {
+            dst[op + k] = dst[op - offset + k];
+        }
+        op += ml;
+    }
+    return op == size;
+}
+
+static int element_size(int precision)
+{
+    return precision == SNAPSHOT_FLOAT64 ? 8 : 4;
+}
+
+struct Band {
+    const FLOAT *src;   // first element of the band
+    int      stride;    // row pitch of src
+    int      nx, nrows;
+    int      precision;
+    double   tolerance;
+    uint8_t  *out;
+    uint32_t raw;
+    uint32_t stored;
+};
+
+static void encode_band(struct Band *b, uint8_t *tmp, uint8_t *shuffled, uint32_t *table)
+{
+    const int    n     = b->nx*b->nrows;
+    const int    es    = element_size(b->precision);
+    const double scale = b->precision == SNAPSHOT_QUANTIZED ? 0.5/b->tolerance : 0.0;
+
+    for (int j=0; j<b->nrows; j++) {
+        const FLOAT *row = b->src + (size_t)j*b->stride;
+        uint8_t     *t   = tmp + (size_t)j*b->nx*es;
+        int32_t prev = 0;
+        for (int i=0; i<b->nx; i++) {
+            if (b->precision == SNAPSHOT_FLOAT64) {
+                const double v = row[i];
+                memcpy(t + 8*i, &v, 8);
+            } else if (b->precision == SNAPSHOT_FLOAT32) {
+                const float v = (float)row[i];
+                memcpy(t + 4*i, &v, 4);
+            } else {
+                const double  q  = fmax(fmin(nearbyint(row[i]*scale), QUANT_MAX), -QUANT_MAX);
+                const int32_t qi = (int32_t)q;
+                const int32_t d  = qi - prev;
+                const uint32_t z = ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+                prev = qi;
+                memcpy(t + 4*i, &z, 4);
+            }
+        }
+    }
+
+    // Byte shuffle: byte k of all the elements, then byte k+1
+    for (int k=0; k<es; k++) {
+        for (int i=0; i<n; i++) {
+            shuffled[(size_t)k*n + i] = tmp[(size_t)i*es + k];
+        }
+    }
+
+    b->raw = (uint32_t)n*es;
+    const int size = lz_compress(shuffled, (int)b->raw, b->out, (int)b->raw - 1, table);
+    if (size < 0) {
+        memcpy(b->out, shuffled, b->raw);
+        b->stored = b->raw;
+    } else {
+        b->stored = (uint32_t)size;
+    }
+}
+
+struct BandQueue {
+    pthread_mutex_t mutex;
+    struct Band *bands;
+    int nbands;
+    int next;
+    int max_elems;
+    int es;
+};
+
+static void *encode_thread(void *arg)
+{
+    struct BandQueue *q = (struct BandQueue *)arg;
+    uint8_t  *tmp      = (uint8_t  *)malloc((size_t)q->max_elems*q->es);
+    uint8_t  *shuffled = (uint8_t  *)malloc((size_t)q->max_elems*q->es);
+    uint32_t *table    = (uint32_t *)malloc(sizeof(uint32_t) << LZ_HASH_BITS);
+
+    for (;;) {
+        pthread_mutex_lock(&q->mutex);
+        const int k = q->next++;
+        pthread_mutex_unlock(&q->mutex);
+        if (k >= q->nbands) break;
+        encode_band(&q->bands[k], tmp, shuffled, table);
+    }
+
+    free(tmp);
+    free(shuffled);
+    free(table);
+    return NULL;
+}
+
+bool snapshot_write(const char *filename, const struct SnapshotConfig *cfg, int icnt, double time,
+                    const struct Range *whole, const struct Range *region,
+                    const FLOAT *ex, const FLOAT *ey, const FLOAT *hz)
+{
+    if (cfg->precision == SNAPSHOT_QUANTIZED && !(cfg->tolerance > 0.0)) {
+        fprintf(stderr, "Error: snapshot tolerance must be positive\n");
+        return false;
+    }
+
+    const FLOAT *fields[3] = { ex, ey, hz };
+    int nfields = 0;
+    for (int c=0; c<3; c++) {
+        if (cfg->fields & (1u << c)) nfields++;
+    }
+
+    const int nx  = region->length[0];
+    const int ny  = region->length[1];
+    const int lnx = whole->length[0];
+    const int f   = cfg->factor > 1 ? cfg->factor : 1;
+    const int b0  = (region->begin[0] - whole->begin[0])/f;
+    const int b1  = (region->begin[1] - whole->begin[1])/f;
+    const int es  = element_size(cfg->precision);
+
+    int nthreads = cfg->nthreads > 0 ? cfg->nthreads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads < 1) nthreads = 1;
+
+    // Bands of about BAND_ELEMS elements, and at least one per thread
+    int rows = (BAND_ELEMS + nx - 1)/nx;
+    if (rows > (ny + nthreads - 1)/nthreads) rows = (ny + nthreads - 1)/nthreads;
+    if (rows < 1) rows = 1;
+    const int nbands = (ny + rows - 1)/rows;
+    const int ntotal = nbands*nfields;
+
+    struct Band *bands = (struct Band *)calloc(ntotal > 0 ? ntotal : 1, sizeof(struct Band));
+    int k = 0;
+    for (int c=0; c<3; c++) {
+        if (!(cfg->fields & (1u << c))) continue;
+        for (int b=0; b<nbands; b++, k++) {
+            struct Band *band = &bands[k];
+            band->src       = fields[c] + (size_t)(b1 + b*rows)*lnx + b0;
+            band->stride    = lnx;
+            band->nx        = nx;
+            band->nrows     = b*rows + rows <= ny ? rows : ny - b*rows;
+            band->precision = cfg->precision;
+            band->tolerance = cfg->tolerance;
+            band->out       = (uint8_t *)malloc((size_t)nx*band->nrows*es);
+        }
+    }
+
+    struct BandQueue queue;
+    pthread_mutex_init(&queue.mutex, NULL);
+    queue.bands     = bands;
+    queue.nbands    = ntotal;
+    queue.next      = 0;
+    queue.max_elems = nx*rows;
+    queue.es        = es;
+    if (nthreads > ntotal) nthreads = ntotal > 0 ? ntotal : 1;
+
+    pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t)*nthreads);
+    for (int t=1; t<nthreads; t++) {
+        pthread_create(&threads[t], NULL, encode_thread, &queue);
+    }
+    encode_thread(&queue);
+    for (int t=1; t<nthreads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&queue.mutex);
+
+    bool ret = true;
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", filename);
+        ret = false;
+    } else {
+        const int32_t header[] = { icnt, nfields, region->begin[0], region->begin[1], nx, ny, f, cfg->mode };
+        fwrite("SNP1", 1, 4, fp);
+        fwrite(header, sizeof(int32_t), 8, fp);
+        fwrite(&time, sizeof(double), 1, fp);
+
+        k = 0;
+        for (int c=0; c<3; c++) {
+            if (!(cfg->fields & (1u << c))) continue;
+            const int32_t fh[] = { c, cfg->precision, nbands, rows };
+            fwrite(fh, sizeof(int32_t), 4, fp);
+            fwrite(&cfg->tolerance, sizeof(double), 1, fp);
+            for (int b=0; b<nbands; b++) {
+                const uint32_t sizes[] = { bands[k + b].raw, bands[k + b].stored };
+                fwrite(sizes, sizeof(uint32_t), 2, fp);
+            }
+            for (int b=0; b<nbands; b++) {
+                fwrite(bands[k + b].out, 1, bands[k + b].stored, fp);
+            }
+            k += nbands;
+        }
+        ret = ferror(fp) == 0;
+        fclose(fp);
+    }
+
+    for (k=0; k<ntotal; k++) {
+        free(bands[k].out);
+    }
+    free(bands);
+
+    return ret;
+}
+
+bool write_snapshot(const struct SnapshotConfig *cfg, int icnt, double time,
+                    const struct Range *whole, const struct Range *region,
+                    const FLOAT *ex, const FLOAT *ey, const FLOAT *hz)
+{
+    char filename[256];
+    sprintf(filename, "s%05d.snp", icnt);
+    return snapshot_write(filename, cfg, icnt, time, whole, region, ex, ey, hz);
+}
+
+static bool decode_band(const uint8_t *in, uint32_t stored, uint32_t raw, int precision, double tolerance,
+                        int nx, int nrows, double *dst)
+{
+    const int n  = nx*nrows;
+    const int es = element_size(precision);
+    if (raw != (uint32_t)n*es) return false;
+
+    uint8_t *shuffled = (uint8_t *)malloc(raw);
+    uint8_t *tmp      = (uint8_t *)malloc(raw);
+    bool ok = true;
+    if (stored == raw) {
+        memcpy(shuffled, in, raw);
+    } else {
+        ok = lz_decompress(in, (int)stored, shuffled, (int)raw);
+    }
+
+    if (ok) {
+        for (int k=0; k<es; k++) {
+            for (int i=0; i<n; i++) {
+                tmp[(size_t)i*es + k] = shuffled[(size_t)k*n + i];
+            }
+        }
+        for (int j=0; j<nrows; j++) {
+            int32_t prev = 0;
+            for (int i=0; i<nx; i++) {
+                const int l = j*nx + i;
+                if (precision == SNAPSHOT_FLOAT64) {
+                    memcpy(&dst[l], tmp + 8*l, 8);
+                } else if (precision == SNAPSHOT_FLOAT32) {
+                    float v;
+                    memcpy(&v, tmp + 4*l, 4);
+                    dst[l] = v;
+                } else {
+                    uint32_t z;
+                    memcpy(&z, tmp + 4*l, 4);
+                    prev += (int32_t)((z >> 1) ^ (0u - (z & 1u)));
+                    dst[l] = 2.0*tolerance*prev;
+                }
+            }
+        }
+    }
+
+    free(shuffled);
+    free(tmp);
+    return ok;
+}
+
+bool snapshot_read(const char *filename, struct Snapshot *s)
+{
+    memset(s, 0, sizeof(struct Snapshot));
+
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", filename);
+        return false;
+    }
+
+    char    magic[4];
+    int32_t header[8];
+    bool ok = fread(magic, 1, 4, fp) == 4 && memcmp(magic, "SNP1", 4) == 0 &&
+              fread(header, sizeof(int32_t), 8, fp) == 8 &&
+              fread(&s->time, sizeof(double), 1, fp) == 1 &&
+              header[1] >= 0 && header[1] <= 3 && header[4] > 0 && header[5] > 0;
+    if (ok) {
+        s->icnt             = header[0];
+        s->nfields          = header[1];
+        s->region.begin [0] = header[2];
+        s->region.begin [1] = header[3];
+        s->region.length[0] = header[4];
+        s->region.length[1] = header[5];
+        s->factor           = header[6] > 1 ? header[6] : 1;
+        s->mode             = header[7];
+    }
+
+    const int nx = s->region.length[0];
+    const int ny = s->region.length[1];
+    for (int f=0; ok && f<s->nfields; f++) {
+        int32_t fh[4];
+        double  tolerance;
+        ok = fread(fh, sizeof(int32_t), 4, fp) == 4 && fread(&tolerance, sizeof(double), 1, fp) == 1 &&
+             fh[2] > 0 && fh[3] > 0 && (fh[2] - 1)*fh[3] < ny && fh[2]*fh[3] >= ny;
+        if (!ok) break;
+
+        const int nbands = fh[2];
+        const int rows   = fh[3];
+        uint32_t *sizes = (uint32_t *)malloc(sizeof(uint32_t)*2*nbands);
+        ok = fread(sizes, sizeof(uint32_t), 2*nbands, fp) == (size_t)(2*nbands);
+
+        s->comp[f] = fh[0];
+        s->data[f] = (double *)malloc(sizeof(double)*nx*ny);
+        for (int b=0; ok && b<nbands; b++) {
+            const int nrows = b*rows + rows <= ny ? rows : ny - b*rows;
+            uint8_t *in = (uint8_t *)malloc(sizes[2*b + 1] + 1);
+            ok = fread(in, 1, sizes[2*b + 1], fp) == sizes[2*b + 1] &&
+                 decode_band(in, sizes[2*b + 1], sizes[2*b], fh[1], tolerance, nx, nrows,
+                             s->data[f] + (size_t)b*rows*nx);
+            free(in);
+        }
+        free(sizes);
+    }
+    fclose(fp);
+
+    if (!ok) {
+        fprintf(stderr, "Error: %s is not a valid snapshot\n", filename);
+        snapshot_free(s);
+    }
+    return ok;
+}
+
+void snapshot_free(struct Snapshot *s)
+{
+    for (int f=0; f<3; f++) {
+        free(s->data[f]);
+    }
+    memset(s, 0, sizeof(struct Snapshot));
+}
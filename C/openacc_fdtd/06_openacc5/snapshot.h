@@ -0,0 +1,78 @@
+/**
+ * @file snapshot.h
+ * @brief Compressed field snapshots
+ *
+ * A snapshot stores a selection of ex, ey and hz over a region at full
+ * (float64), single (float32) or error-bounded (quantized) precision.
+ * Each field is cut into bands of rows which are encoded in parallel by
+ * a pool of threads:
+ *
+ *   float64/float32 : byte shuffle + LZ (lossless)
+ *   quantized       : q = round(v/(2 tol)), difference along the row,
+ *                     zigzag, byte shuffle + LZ (|v - 2 tol q| <= tol)
+ *
+ * The LZ stage uses the LZ4 block format; a band is stored as is when
+ * it does not shrink.
+ *
+ * Fields reduced by the sampler (sampler.h) keep their factor and mode:
+ * whole and region begin at the global cells of their first samples and
+ * their lengths count samples.
+ *
+ * File: "SNP1", int32 {icnt, nfields, begin[2], length[2], factor, mode},
+ * double time, then per field int32 {comp, precision, nbands, rows per
+ * band}, double tolerance, uint32 {raw size, stored size}[nbands] and
+ * the bands.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "config.h"
+
+#define SNAPSHOT_EX (1u << FIELD_EX)
+#define SNAPSHOT_EY (1u << FIELD_EY)
+#define SNAPSHOT_HZ (1u << FIELD_HZ)
+
+enum SnapshotPrecision {
+    SNAPSHOT_FLOAT64   = 0,
+    SNAPSHOT_FLOAT32   = 1,
+    SNAPSHOT_QUANTIZED = 2
+};
+
+struct SnapshotConfig {
+    unsigned int fields;    // SNAPSHOT_EX | SNAPSHOT_EY | SNAPSHOT_HZ
+    int          precision;
+    double       tolerance; // absolute error bound of SNAPSHOT_QUANTIZED
+    int          nthreads;  // 0: number of online processors
+    int          factor;    // sampling of the fields (sampler.h); 0 or 1: every cell
+    int          mode;
+};
+
+struct Snapshot {
+    int    icnt;
+    double time;
+    struct Range region;
+    int    factor, mode;
+    int    nfields;
+    int    comp[3];
+    double *data[3]; // [length[1]][length[0]]
+};
+
+bool snapshot_write(const char *filename, const struct SnapshotConfig *cfg, int icnt, double time,
+                    const struct Range *whole, const struct Range *region,
+                    const FLOAT *ex, const FLOAT *ey, const FLOAT *hz);
+bool write_snapshot(const struct SnapshotConfig *cfg, int icnt, double time,
+                    const struct Range *whole, const struct Range *region,
+                    const FLOAT *ex, const FLOAT *ey, const FLOAT *hz);
+bool snapshot_read(const char *filename, struct Snapshot *s);
+void snapshot_free(struct Snapshot *s);
+
+#endif /* SNAPSHOT_H */
@@ -0,0 +1,85 @@
+/**
+ * @file snapshot_diff.c
+ * @brief Error of the fields of a snapshot against a reference snapshot
+ *
+ * Usage: ./snapshot_diff <reference.snp> <snapshot.snp> [tolerance]
+ *
+ * For each field of both snapshots, prints the relative L2 error
+ * |f - ref|_2 / |ref|_2 and the max error max|f - ref| / max|ref|.  Used
+ * to validate the single precision build against USE_DOUBLE: the two
+ * runs write float64 snapshots (snapshot.precision = float64) of the
+ * same steps, see the README.  With a tolerance, the exit status is 1
+ * when a relative L2 error exceeds it.  The exit status is 2 when the
+ * snapshots share no field.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "snapshot.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || argc > 4) {
+        fprintf(stderr, "Usage: %s <reference.snp> <snapshot.snp> [tolerance]\n", argv[0]);
+        return 2;
+    }
+    const double tolerance = argc == 4 ? atof(argv[3]) : -1.0;
+
+    struct Snapshot ref, snp;
+    if (!snapshot_read(argv[1], &ref)) return 2;
+    if (!snapshot_read(argv[2], &snp)) {
+        snapshot_free(&ref);
+        return 2;
+    }
+    if (ref.region.length[0] != snp.region.length[0] || ref.region.length[1] != snp.region.length[1] ||
+        ref.region.begin [0] != snp.region.begin [0] || ref.region.begin [1] != snp.region.begin [1]) {
+        fprintf(stderr, "Error: %s and %s have different regions\n", argv[1], argv[2]);
+        snapshot_free(&ref);
+        snapshot_free(&snp);
+        return 2;
+    }
+
+    static const char *names[] = { "ex", "ey", "hz" };
+    const size_t n = (size_t)ref.region.length[0]*ref.region.length[1];
+    int status = 0;
+    int ncompared = 0;
+
+    fprintf(stdout, "# icnt %d (%s), %d (%s)\n", ref.icnt, argv[1], snp.icnt, argv[2]);
+    fprintf(stdout, "# field   rel_l2        rel_max       max|ref|\n");
+    for (int f=0; f<ref.nfields; f++) {
+        if (ref.comp[f] < FIELD_EX || ref.comp[f] > FIELD_HZ) continue;
+        int g = 0;
+        while (g < snp.nfields && snp.comp[g] != ref.comp[f]) g++;
+        if (g == snp.nfields) continue;
+
+        double sum_d = 0.0, sum_r = 0.0, max_d = 0.0, max_r = 0.0;
+        for (size_t k=0; k<n; k++) {
+            const double r = ref.data[f][k];
+            const double d = snp.data[g][k] - r;
+            sum_d += d*d;
+            sum_r += r*r;
+            if (fabs(d) > max_d) max_d = fabs(d);
+            if (fabs(r) > max_r) max_r = fabs(r);
+        }
+        const double rel_l2  = sum_r > 0.0 ? sqrt(sum_d/sum_r) : sqrt(sum_d);
+        const double rel_max = max_r > 0.0 ? max_d/max_r : max_d;
+        fprintf(stdout, "  %-6s  %.6e  %.6e  %.6e\n", names[ref.comp[f]], rel_l2, rel_max, max_r);
+        if (tolerance >= 0.0 && !(rel_l2 <= tolerance)) status = 1;
+        ncompared++;
+    }
+    if (ncompared == 0) {
+        fprintf(stderr, "Error: %s and %s have no field in common\n", argv[1], argv[2]);
+        status = 2;
+    }
+
+    snapshot_free(&ref);
+    snapshot_free(&snp);
+    return status;
+}
@@ -0,0 +1,271 @@
+/**
+ * @file stats.c
+ * @brief In-situ field statistics and energy monitor
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static int max_int(int a, int b) { return a > b ? a : b; }
+static int min_int(int a, int b) { return a < b ? a : b; }
+
+void stats_init(struct Stats *s, const struct StatsConfig *cfg,
+                const struct Range *whole_global, const struct Range *inside_global,
+                const struct Range *whole, const struct Range *inside,
+                const struct Mesh *mesh, double dt, FLOAT e0, FLOAT m0,
+                const FLOAT *cexy, const FLOAT *ceyx, const FLOAT *chzx, const FLOAT *chzy)
+{
+    memset(s, 0, sizeof(struct Stats));
+
+    s->cfg           = *cfg;
+    s->whole         = *whole;
+    s->inside_global = *inside_global;
+    s->mesh          = mesh;
+    s->dt            = dt;
+    s->e0            = e0;
+    s->m0            = m0;
+
+    // The inside rows, and the PML rows at the ends of the domain
+    const int end1        = inside->begin[1] + inside->length[1];
+    const int global_end1 = inside_global->begin[1] + inside_global->length[1];
+    s->j0 = inside->begin[1] == inside_global->begin[1] ? max_int(whole_global->begin[1], whole->begin[1]) : inside->begin[1];
+    s->j1 = end1 == global_end1 ? whole->begin[1] + whole->length[1] : end1;
+    s->j0 -= whole->begin[1];
+    s->j1 -= whole->begin[1];
+
+    // sigma = 2 e0 a/dt, sigma* = 2 m0 a/dt from c = (1 - a)/(1 + a) of the PML coefficients
+    const int nx = whole->length[0];
+    const int ny = whole->length[1];
+    s->nsigma = 2*(nx + ny);
+    s->sigma  = (FLOAT *)malloc(sizeof(FLOAT)*s->nsigma);
+    FLOAT *sigma = s->sigma;
+    const int nsigma = s->nsigma;
+    const FLOAT ge = 2.0*e0/dt;
+    const FLOAT gh = 2.0*m0/dt;
+#pragma acc enter data create(sigma[0:nsigma])
+#pragma acc kernels present(sigma[0:nsigma])
+    {
+#pragma acc loop independent
+        for (int i=0; i<nx; i++) {
+            sigma[     i] = ge*(1.0 - ceyx[i])/(1.0 + ceyx[i]);
+            sigma[nx + i] = gh*(1.0 - chzx[i])/(1.0 + chzx[i]);
+        }
+#pragma acc loop independent
+        for (int j=0; j<ny; j++) {
+            sigma[2*nx      + j] = ge*(1.0 - cexy[j])/(1.0 + cexy[j]);
+            sigma[2*nx + ny + j] = gh*(1.0 - chzy[j])/(1.0 + chzy[j]);
+        }
+    }
+
+    int rank = 0;
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if (initialized) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    }
+    if (rank == 0 && cfg->interval > 0) {
+        s->fp = cfg->filename != NULL ? fopen(cfg->filename, "w") : stdout;
+        if (s->fp == NULL) {
+            fprintf(stderr, "Error: cannot open %s\n", cfg->filename);
+        }
+    }
+}
+
+bool stats_add_region(struct Stats *s, int i0, int j0, int i1, int j1)
+{
+    if (s->nregions >= STATS_MAX_REGIONS || i1 <= i0 || j1 <= j0) {
+        fprintf(stderr, "Error: cannot add the statistics region %d %d %d %d\n", i0, j0, i1, j1);
+        return false;
+    }
+    struct Range *r = &s->regions[s->nregions++];
+    r->begin [0] = i0;
+    r->begin [1] = j0;
+    r->length[0] = i1 - i0;
+    r->length[1] = j1 - j0;
+    return true;
+}
+
+static void write_header(const struct Stats *s)
+{
+    fprintf(s->fp, "# icnt time energy energy_pml power_pml absorbed emax hmax");
+    for (int r=0; r<s->nregions; r++) {
+        fprintf(s->fp, " norm_e%d norm_h%d", r, r);
+    }
+    fprintf(s->fp, "\n");
+}
+
+int stats_update(struct Stats *s, int icnt, double time,
+                 const FLOAT *ex, const FLOAT *ey, const FLOAT *hz, const FLOAT *hzx, const FLOAT *hzy,
+                 const FLOAT *rer_ex, const FLOAT *rer_ey)
+{
+    if (s->cfg.interval <= 0 || icnt % s->cfg.interval != 0) return STATS_RUNNING;
+
+    const int lnx = s->whole.length[0];
+    const int lny = s->whole.length[1];
+    const int j0  = s->j0;
+    const int j1  = s->j1;
+    const int bw0 = s->whole.begin[0];
+    const int bw1 = s->whole.begin[1];
+    const int bi0 = s->inside_global.begin[0];
+    const int bi1 = s->inside_global.begin[1];
+    const int ei0 = bi0 + s->inside_global.length[0];
+    const int ei1 = bi1 + s->inside_global.length[1];
+
+    // Cell widths of the whole range
+    const int    mx = bw0 - s->mesh->whole.begin[0];
+    const int    my = bw1 - s->mesh->whole.begin[1];
+    const FLOAT *dx  = s->mesh->d [0];
+    const FLOAT *dy  = s->mesh->d [1];
+    const FLOAT *dxd = s->mesh->dd[0];
+    const FLOAT *dyd = s->mesh->dd[1];
+    const int   nmx  = s->mesh->whole.length[0];
+    const int   nmy  = s->mesh->whole.length[1];
+
+    const FLOAT *sigma = s->sigma;
+    const int   nsigma = s->nsigma;
+    const FLOAT e0     = s->e0;
+    const FLOAT m0     = s->m0;
+
+    double w_in = 0.0, w_pml = 0.0, p_pml = 0.0;
+    double e2max = 0.0, h2max = 0.0;
+
+#pragma acc kernels present(dx[0:nmx], dy[0:nmy], dxd[0:nmx], dyd[0:nmy], sigma[0:nsigma])
+#pragma acc loop independent reduction(+:w_in,w_pml,p_pml) reduction(max:e2max,h2max)
+    for (int jj=j0; jj<j1; jj++) {
+#pragma acc loop independent reduction(+:w_in,w_pml,p_pml) reduction(max:e2max,h2max)
+        for (int ii=0; ii<lnx; ii++) {
+            const int ix = jj*lnx + ii;
+            const int i  = ii + bw0;
+            const int j  = jj + bw1;
+
+            const FLOAT a_ex = dx [ii + mx]*dyd[jj + my];
+            const FLOAT a_ey = dxd[ii + mx]*dy [jj + my];
+            const FLOAT a_hz = dx [ii + mx]*dy [jj + my];
+            const FLOAT ex2  = ex[ix]*ex[ix];
+            const FLOAT ey2  = ey[ix]*ey[ix];
+            const FLOAT hz2  = hz[ix]*hz[ix];
+
+            // er = 1/rer, and no field in the objects (rer = 0)
+            const FLOAT we = (rer_ex[ix] > 0.0 ? ex2*a_ex/rer_ex[ix] : 0.0) +
+                             (rer_ey[ix] > 0.0 ? ey2*a_ey/rer_ey[ix] : 0.0);
+            const double w = 0.5*(e0*we + m0*hz2*a_hz);
+
+            if (i >= bi0 && i < ei0 && j >= bi1 && j < ei1) {
+                w_in  += w;
+            } else {
+                w_pml += w;
+                p_pml += sigma[2*lnx + jj]*ex2*a_ex + sigma[ii]*ey2*a_ey +
+                         (sigma[lnx + ii]*hzx[ix]*hzx[ix] + sigma[2*lnx + lny + jj]*hzy[ix]*hzy[ix])*a_hz;
+            }
+            const double e2 = ex2 + ey2;
+            e2max = e2 > e2max ? e2 : e2max;
+            h2max = hz2 > h2max ? hz2 : h2max;
+        }
+    }
+
+    // Sums and maxima of all the ranks: energy, energy_pml, power_pml, norms^2 of the regions
+    double sum[3 + 2*STATS_MAX_REGIONS] = { w_in, w_pml, p_pml };
+    double max[2] = { e2max, h2max };
+
+    for (int r=0; r<s->nregions; r++) {
+        const struct Range *g = &s->regions[r];
+        const int ib = max_int(g->begin[0], bw0) - bw0;
+        const int ie = min_int(g->begin[0] + g->length[0], bw0 + lnx) - bw0;
+        const int jb = max_int(g->begin[1] - bw1, j0);
+        const int je = min_int(g->begin[1] + g->length[1] - bw1, j1);
+
+        double se = 0.0, sh = 0.0;
+#pragma acc kernels present(dx[0:nmx], dy[0:nmy], dxd[0:nmx], dyd[0:nmy])
+#pragma acc loop independent reduction(+:se,sh)
+        for (int jj=jb; jj<je; jj++) {
+#pragma acc loop independent reduction(+:se,sh)
+            for (int ii=ib; ii<ie; ii++) {
+                const int ix = jj*lnx + ii;
+                se += ex[ix]*ex[ix]*dx[ii + mx]*dyd[jj + my] + ey[ix]*ey[ix]*dxd[ii + mx]*dy[jj + my];
+                sh += hz[ix]*hz[ix]*dx[ii + mx]*dy[jj + my];
+            }
+        }
+        sum[3 + 2*r    ] = se;
+        sum[3 + 2*r + 1] = sh;
+    }
+
+    int rank = 0;
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if (initialized) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Allreduce(MPI_IN_PLACE, sum, 3 + 2*s->nregions, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        MPI_Allreduce(MPI_IN_PLACE, max, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    }
+
+    // The absorbed power is taken as constant since the last sample
+    const int steps = s->nsamples > 0 ? icnt - s->icnt : icnt;
+    s->absorbed  += sum[2]*steps*s->dt;
+    s->icnt       = icnt;
+    s->time       = time;
+    s->energy     = sum[0];
+    s->energy_pml = sum[1];
+    s->power_pml  = sum[2];
+    s->emax       = sqrt(max[0]);
+    s->hmax       = sqrt(max[1]);
+    for (int r=0; r<s->nregions; r++) {
+        s->norm_e[r] = sqrt(sum[3 + 2*r    ]);
+        s->norm_h[r] = sqrt(sum[3 + 2*r + 1]);
+    }
+
+    // Same status on every rank: all of them have the reduced values
+    const double total = s->energy + s->energy_pml;
+    const int status_prev = s->status;
+    if (!isfinite(total) || !isfinite(s->emax) || (s->cfg.emax_limit > 0.0 && s->emax > s->cfg.emax_limit)) {
+        s->status = STATS_DIVERGED;
+    } else if (s->cfg.tolerance > 0.0 && s->nsamples > 0 && total > 0.0 &&
+               fabs(total - s->energy_prev) <= s->cfg.tolerance*total) {
+        s->status = STATS_CONVERGED;
+    } else {
+        s->status = STATS_RUNNING;
+    }
+    s->energy_prev = total;
+
+    if (rank == 0 && s->fp != NULL) {
+        if (s->nsamples == 0) write_header(s);
+        fprintf(s->fp, "%d %.9e %.9e %.9e %.9e %.9e %.9e %.9e", icnt, time,
+                s->energy, s->energy_pml, s->power_pml, s->absorbed, s->emax, s->hmax);
+        for (int r=0; r<s->nregions; r++) {
+            fprintf(s->fp, " %.9e %.9e", s->norm_e[r], s->norm_h[r]);
+        }
+        fprintf(s->fp, "\n");
+        fflush(s->fp);
+    }
+    if (rank == 0 && s->status != status_prev) {
+        if (s->status == STATS_DIVERGED) {
+            fprintf(stdout, "icnt = %5d: diverged (energy = %e [J/m], max|E| = %e [V/m])\n", icnt, total, s->emax);
+        } else if (s->status == STATS_CONVERGED) {
+            fprintf(stdout, "icnt = %5d: converged (energy = %e [J/m])\n", icnt, total);
+        }
+    }
+    s->nsamples++;
+
+    return s->status;
+}
+
+void stats_free(struct Stats *s)
+{
+    FLOAT *sigma = s->sigma;
+    const int nsigma = s->nsigma;
+#pragma acc exit data delete(sigma[0:nsigma])
+    free(s->sigma);
+    if (s->fp != NULL && s->fp != stdout) {
+        fclose(s->fp);
+    }
+    memset(s, 0, sizeof(struct Stats));
+}
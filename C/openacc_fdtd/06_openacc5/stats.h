@@ -0,0 +1,101 @@
+/**
+ * @file stats.h
+ * @brief In-situ field statistics and energy monitor
+ *
+ * Every interval steps one reduction pass over the cells owned by each
+ * rank (its inside rows, and the PML rows at the ends of the domain)
+ * computes
+ *
+ *   energy     : 1/2 sum (e0 er (ex^2 + ey^2) + m0 hz^2) dA over inside_global
+ *   energy_pml : the same over the PML
+ *   power_pml  : sum (sigma ex^2 + sigma ey^2 + sigma* (hzx^2 + hzy^2)) dA,
+ *                the power absorbed in the PML
+ *   absorbed   : power_pml integrated over the samples (rectangle rule)
+ *   emax, hmax : max |E|, max |hz|
+ *
+ * and the L2 norms sqrt(sum |E|^2 dA), sqrt(sum hz^2 dA) over each region
+ * added with stats_add_region().  The sums are reduced over the ranks.
+ * The energy of the polarization of dispersive media is not included.
+ *
+ * The run is reported as diverged when the energy is not finite or max
+ * |E| exceeds emax_limit, and as converged when the relative change of
+ * the total energy between two samples is below tolerance.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "config.h"
+#include "mesh.h"
+
+#define STATS_MAX_REGIONS 8
+
+enum StatsStatus {
+    STATS_RUNNING   = 0,
+    STATS_CONVERGED = 1,
+    STATS_DIVERGED  = 2
+};
+
+struct StatsConfig {
+    int        interval;   // steps between two samples; 0: off
+    double     emax_limit; // max |E| of a diverged run; 0: no limit
+    double     tolerance;  // relative change of the energy of a converged run; 0: never
+    const char *filename;  // table of the samples (rank 0); NULL: stdout
+};
+
+struct Stats {
+    struct StatsConfig cfg;
+    struct Range whole;
+    struct Range inside_global;
+    int   j0, j1;          // owned rows, whole.begin[1] based
+    const struct Mesh *mesh;
+    FLOAT e0, m0;
+    double dt;
+    FLOAT *sigma;          // [nx] sigma (ey), [nx] sigma* (hzx), [ny] sigma (ex), [ny] sigma* (hzy)
+    int   nsigma;
+
+    int   nregions;
+    struct Range regions[STATS_MAX_REGIONS]; // global cells
+
+    // Last sample
+    int    icnt;
+    double time;
+    double energy, energy_pml, power_pml, absorbed;
+    double emax, hmax;
+    double norm_e[STATS_MAX_REGIONS], norm_h[STATS_MAX_REGIONS];
+    int    status;
+
+    int    nsamples;
+    double energy_prev;
+    FILE   *fp;
+};
+
+void stats_init(struct Stats *s, const struct StatsConfig *cfg,
+                const struct Range *whole_global, const struct Range *inside_global,
+                const struct Range *whole, const struct Range *inside,
+                const struct Mesh *mesh, double dt, FLOAT e0, FLOAT m0,
+                const FLOAT *cexy, const FLOAT *ceyx, const FLOAT *chzx, const FLOAT *chzy);
+bool stats_add_region(struct Stats *s, int i0, int j0, int i1, int j1);
+
+/**
+ * @brief sample the fields when icnt is a multiple of the interval
+ *
+ * Collective over MPI_COMM_WORLD when MPI is initialized; every rank
+ * gets the same status.
+ *
+ * @return STATS_DIVERGED, STATS_CONVERGED or STATS_RUNNING
+ */
+int stats_update(struct Stats *s, int icnt, double time,
+                 const FLOAT *ex, const FLOAT *ey, const FLOAT *hz, const FLOAT *hzx, const FLOAT *hzy,
+                 const FLOAT *rer_ex, const FLOAT *rer_ey);
+void stats_free(struct Stats *s);
+
+#endif /* STATS_H */
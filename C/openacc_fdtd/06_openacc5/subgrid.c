@@ -0,0 +1,299 @@
+/**
+ * @file subgrid.c
+ * @brief Local mesh refinement (subgridding)
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#include "subgrid.h"
+#include "setup.h"
+#include "fdtd2d.h"
+#include <stdlib.h>
+#include <string.h>
+
+void subgrid_init(struct Subgrid *s)
+{
+    memset(s, 0, sizeof(struct Subgrid));
+}
+
+bool subgrid_add_patch(struct Subgrid *s, int i0, int j0, int i1, int j1, int ratio)
+{
+    if (ratio < 2 || ratio > 4 || i0 >= i1 || j0 >= j1) {
+        fprintf(stderr, "Error: invalid patch (%d, %d) - (%d, %d), ratio %d\n", i0, j0, i1, j1, ratio);
+        return false;
+    }
+
+    s->patches = (struct SubgridPatch *)realloc(s->patches, sizeof(struct SubgridPatch)*(s->npatches + 1));
+    struct SubgridPatch *p = &s->patches[s->npatches++];
+    memset(p, 0, sizeof(struct SubgridPatch));
+    p->ratio = ratio;
+    p->c0[0] = i0;
+    p->c0[1] = j0;
+    p->c1[0] = i1;
+    p->c1[1] = j1;
+    return true;
+}
+
+bool subgrid_setup(struct Subgrid *s, const struct Range *whole, const struct Range *inside,
+                   const struct Mesh *mesh, FLOAT dt)
+{
+    s->whole  = *whole;
+    s->inside = *inside;
+
+    const int ib[] = { inside->begin[0], inside->begin[1] };
+    const int ie[] = { inside->begin[0] + inside->length[0], inside->begin[1] + inside->length[1] };
+
+    // Keep the patches of this subdomain
+    int n = 0;
+    for (int k=0; k<s->npatches; k++) {
+        struct SubgridPatch p = s->patches[k];
+        if (p.c1[1] <= ib[1] || p.c0[1] >= ie[1]) continue;
+
+        // The coarse E on the boundary lines and one cell outside must be updated here
+        if (p.c0[0] - 1 < ib[0] || p.c1[0] > ie[0] - 1 ||
+            p.c0[1] - 1 < ib[1] || p.c1[1] > ie[1] - 1) {
+            fprintf(stderr, "Error: patch (%d, %d) - (%d, %d) is not inside one subdomain\n",
+                    p.c0[0], p.c0[1], p.c1[0], p.c1[1]);
+            return false;
+        }
+        s->patches[n++] = p;
+    }
+    s->npatches = n;
+
+    for (int k=0; k<s->npatches; k++) {
+        struct SubgridPatch *p = &s->patches[k];
+        const int r = p->ratio;
+
+        const struct Range fine_inside = { { r*(p->c1[0] - p->c0[0]), r*(p->c1[1] - p->c0[1]) },
+                                           { r*p->c0[0], r*p->c0[1] } };
+        const struct Range fine_whole  = { { fine_inside.length[0] + 3, fine_inside.length[1] + 3 },
+                                           { fine_inside.begin[0] - 1, fine_inside.begin[1] - 1 } };
+        p->inside = fine_inside;
+        p->whole  = fine_whole;
+        p->dt     = dt/r;
+        p->nelems = fine_whole.length[0] * fine_whole.length[1];
+
+        mesh_refine(&p->mesh, mesh, &fine_whole, r);
+
+        const int    ne   = p->nelems;
+        const int    nx   = fine_whole.length[0];
+        const int    ny   = fine_whole.length[1];
+        const size_t size = sizeof(FLOAT)*ne;
+        p->ex    = (FLOAT *)malloc(size);
+        p->ey    = (FLOAT *)malloc(size);
+        p->hz    = (FLOAT *)malloc(size);
+        p->cexly = (FLOAT *)malloc(size);
+        p->ceylx = (FLOAT *)malloc(size);
+        p->chzlx = (FLOAT *)malloc(sizeof(FLOAT)*nx);
+        p->chzly = (FLOAT *)malloc(sizeof(FLOAT)*ny);
+        dispersive_init(&p->dispersive);
+
+        p->nb[0]  = p->c1[0] - p->c0[0] + 2;
+        p->nb[1]  = p->c1[1] - p->c0[1] + 2;
+        p->nbound = 2*(p->nb[0] + p->nb[1]);
+        p->bound  = (FLOAT *)malloc(sizeof(FLOAT)*2*p->nbound);
+        p->cur    = 0;
+
+        FLOAT *ex    = p->ex;
+        FLOAT *ey    = p->ey;
+        FLOAT *hz    = p->hz;
+        FLOAT *cexly = p->cexly;
+        FLOAT *ceylx = p->ceylx;
+        FLOAT *chzlx = p->chzlx;
+        FLOAT *chzly = p->chzly;
+        FLOAT *bound = p->bound;
+        const int nb2 = 2*p->nbound;
+#pragma acc enter data create(ex[0:ne], ey[0:ne], hz[0:ne], cexly[0:ne], ceylx[0:ne], chzlx[0:nx], chzly[0:ny]) \
+    create(bound[0:nb2])
+
+        init_vars(p->whole.length, ex, ey, hz);
+#pragma acc kernels present(bound)
+#pragma acc loop independent
+        for (int i=0; i<nb2; i++) {
+            bound[i] = 0.0;
+        }
+    }
+
+    return true;
+}
+
+void subgrid_set_media(struct SubgridPatch *p, FLOAT e0, FLOAT m0, const struct Dispersive *materials,
+                       const unsigned char *mat, const unsigned int *obj_mask, const FLOAT *er)
+{
+    const int ne = p->nelems;
+    const int nw = OBJECT_MASK_NWORDS(ne);
+
+#pragma acc enter data copyin(obj_mask[0:nw], er[0:ne])
+    set_initial_condition(&p->whole, &p->mesh, p->dt, e0, er, m0, obj_mask,
+                          p->cexly, p->ceylx, p->chzlx, p->chzly);
+
+    // Same materials, with the ADE coefficients of the fine time step
+    for (int m=0; m<materials->nmaterials; m++) {
+        dispersive_add_material(&p->dispersive, &materials->materials[m]);
+    }
+    dispersive_setup(&p->dispersive, &p->whole, &p->inside, p->dt, e0, mat, obj_mask, er,
+                     p->cexly, p->ceylx);
+#pragma acc exit data delete(obj_mask[0:nw], er[0:ne])
+}
+
+static void update_patch(const struct Subgrid *s, struct SubgridPatch *p, FLOAT *ex, FLOAT *ey)
+{
+    const int r    = p->ratio;
+    const int lnx  = s->whole.length[0];
+    const int cb0  = s->whole.begin[0];
+    const int cb1  = s->whole.begin[1];
+    const int i0   = p->c0[0];
+    const int j0   = p->c0[1];
+    const int i1   = p->c1[0];
+    const int j1   = p->c1[1];
+    const int nb0  = p->nb[0];
+    const int nb1  = p->nb[1];
+
+    FLOAT    *bound = p->bound;
+    const int bold  = (1 - p->cur)*p->nbound;
+    const int bnew  =      p->cur *p->nbound;
+
+    // Coarse tangential E on the boundary lines at this step
+#pragma acc kernels present(bound)
+    {
+#pragma acc loop independent
+        for (int k=0; k<nb0; k++) {
+            const int i = i0 - 1 + k - cb0;
+            bound[bnew       + k] = ex[(j0 - cb1)*lnx + i];
+            bound[bnew + nb0 + k] = ex[(j1 - cb1)*lnx + i];
+        }
+#pragma acc loop independent
+        for (int k=0; k<nb1; k++) {
+            const int j = j0 - 1 + k - cb1;
+            bound[bnew + 2*nb0       + k] = ey[j*lnx + i0 - cb0];
+            bound[bnew + 2*nb0 + nb1 + k] = ey[j*lnx + i1 - cb0];
+        }
+    }
+
+    const int lnxf = p->whole.length[0];
+    const int nfx  = p->inside.length[0];
+    const int nfy  = p->inside.length[1];
+    FLOAT *fex = p->ex;
+    FLOAT *fey = p->ey;
+    FLOAT *fhz = p->hz;
+
+    for (int step=0; step<r; step++) {
+        const FLOAT a = (step + 1.0)/r;
+
+        dispersive_update_e(&p->dispersive, fex, fey);
+        calc_ex_ey(&p->whole, &p->inside, fhz, p->cexly, p->ceylx, fex, fey);
+
+        // Fine point (i + 1/2)/r - 1/2 lies between the coarse samples m and m+1 (counted from c0 - 1)
+#pragma acc kernels present(fex, fey, bound)
+        {
+#pragma acc loop independent
+            for (int i=0; i<nfx; i++) {
+                const int   m = (2*i + 1 + r)/(2*r);
+                const FLOAT w = (FLOAT)((2*i + 1 + r) % (2*r))/(2*r);
+                for (int side=0; side<2; side++) {
+                    const int   b  = side*nb0 + m;
+                    const FLOAT v0 = (1.0 - w)*bound[bold + b] + w*bound[bold + b + 1];
+                    const FLOAT v1 = (1.0 - w)*bound[bnew + b] + w*bound[bnew + b + 1];
+                    const int   j  = side == 0 ? 0 : nfy;
+                    fex[(j + 1)*lnxf + i + 1] = (1.0 - a)*v0 + a*v1;
+                }
+            }
+#pragma acc loop independent
+            for (int j=0; j<nfy; j++) {
+                const int   m = (2*j + 1 + r)/(2*r);
+                const FLOAT w = (FLOAT)((2*j + 1 + r) % (2*r))/(2*r);
+                for (int side=0; side<2; side++) {
+                    const int   b  = 2*nb0 + side*nb1 + m;
+                    const FLOAT v0 = (1.0 - w)*bound[bold + b] + w*bound[bold + b + 1];
+                    const FLOAT v1 = (1.0 - w)*bound[bnew + b] + w*bound[bnew + b + 1];
+                    const int   i  = side == 0 ? 0 : nfx;
+                    fey[(j + 1)*lnxf + i + 1] = (1.0 - a)*v0 + a*v1;
+                }
+            }
+        }
+
+        calc_hz(&p->whole, &p->inside, fey, fex, p->chzlx, p->chzly, fhz);
+    }
+
+    // Restriction of the coarse E strictly inside the patch
+    const FLOAT rr = 1.0/r;
+#pragma acc kernels present(fex, fey)
+    {
+#pragma acc loop independent
+        for (int j=j0+1; j<j1; j++) {
+#pragma acc loop independent
+            for (int i=i0; i<i1; i++) {
+                const int jf = r*(j - j0) + 1;
+                const int if0 = r*(i - i0) + 1;
+                FLOAT sum = 0.0;
+                for (int q=0; q<r; q++) {
+                    sum += fex[jf*lnxf + if0 + q];
+                }
+                ex[(j - cb1)*lnx + i - cb0] = sum*rr;
+            }
+        }
+#pragma acc loop independent
+        for (int j=j0; j<j1; j++) {
+#pragma acc loop independent
+            for (int i=i0+1; i<i1; i++) {
+                const int jf0 = r*(j - j0) + 1;
+                const int if_ = r*(i - i0) + 1;
+                FLOAT sum = 0.0;
+                for (int q=0; q<r; q++) {
+                    sum += fey[(jf0 + q)*lnxf + if_];
+                }
+                ey[(j - cb1)*lnx + i - cb0] = sum*rr;
+            }
+        }
+    }
+
+    p->cur = 1 - p->cur;
+}
+
+void subgrid_update(struct Subgrid *s, FLOAT *ex, FLOAT *ey)
+{
+    for (int k=0; k<s->npatches; k++) {
+        update_patch(s, &s->patches[k], ex, ey);
+    }
+}
+
+void subgrid_free(struct Subgrid *s)
+{
+    for (int k=0; k<s->npatches; k++) {
+        struct SubgridPatch *p = &s->patches[k];
+        const int ne  = p->nelems;
+        const int nx  = p->whole.length[0];
+        const int ny  = p->whole.length[1];
+        const int nb2 = 2*p->nbound;
+        FLOAT *ex    = p->ex;
+        FLOAT *ey    = p->ey;
+        FLOAT *hz    = p->hz;
+        FLOAT *cexly = p->cexly;
+        FLOAT *ceylx = p->ceylx;
+        FLOAT *chzlx = p->chzlx;
+        FLOAT *chzly = p->chzly;
+        FLOAT *bound = p->bound;
+        if (ex != NULL) {
+#pragma acc exit data delete(ex[0:ne], ey[0:ne], hz[0:ne], cexly[0:ne], ceylx[0:ne], chzlx[0:nx], chzly[0:ny]) \
+    delete(bound[0:nb2])
+        }
+        free(ex);
+        free(ey);
+        free(hz);
+        free(cexly);
+        free(ceylx);
+        free(chzlx);
+        free(chzly);
+        free(bound);
+        dispersive_free(&p->dispersive);
+        mesh_free(&p->mesh);
+    }
+    free(s->patches);
+    subgrid_init(s);
+}
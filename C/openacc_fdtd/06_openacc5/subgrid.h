@@ -0,0 +1,84 @@
+/**
+ * @file subgrid.h
+ * @brief Local mesh refinement (subgridding)
+ *
+ * A patch refines the coarse cells [i0, i1) x [j0, j1) by a factor of
+ * 2, 3 or 4 in space and time.  The fine fields are advanced by the
+ * same calc_ex_ey() and calc_hz() on their own arrays with a margin of
+ * one cell, ratio fine steps per coarse step.  On a graded coarse mesh
+ * the boundary interpolation below is linear in the cell index.
+ *
+ * Coupling (E-field restriction):
+ *  - coarse to fine: the tangential E on the patch boundary is linearly
+ *    interpolated along the boundary from the coarse E on the boundary
+ *    line and linearly in time between the previous and the current
+ *    coarse step;
+ *  - fine to coarse: the coarse E strictly inside the patch is replaced
+ *    by the average of the ratio fine E on the same coarse edge, so the
+ *    following coarse calc_hz() sees the fine solution.
+ *
+ * A patch must be inside the inside range of one subdomain with at
+ * least one coarse cell to spare.  Sources and objects of the coarse
+ * grid inside a patch are not seen by the fine grid: the media of a
+ * patch are given separately at the fine resolution.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#ifndef SUBGRID_H
+#define SUBGRID_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "config.h"
+#include "dispersive.h"
+#include "mesh.h"
+
+struct SubgridPatch {
+    int   ratio;
+    int   c0[2];   // first coarse cell (global)
+    int   c1[2];   // last coarse cell + 1 (global)
+
+    // Fine grid, global fine index = ratio * coarse index
+    struct Range whole;
+    struct Range inside;
+    struct Mesh mesh; // each coarse cell split into ratio equal parts
+    FLOAT dt;
+    int   nelems;
+
+    FLOAT *ex, *ey, *hz;
+    FLOAT *cexly, *ceylx;
+    FLOAT *chzlx, *chzly; // per column, per row
+    struct Dispersive dispersive;
+
+    // Coarse tangential E on the boundary lines, [2][nbound]
+    // bottom/top ex: c0[0]-1 .. c1[0], left/right ey: c0[1]-1 .. c1[1]
+    int   nb[2];
+    int   nbound;
+    FLOAT *bound;
+    int   cur;
+};
+
+struct Subgrid {
+    int npatches;
+    struct SubgridPatch *patches;
+
+    // Coarse grid of this subdomain
+    struct Range whole;
+    struct Range inside;
+};
+
+void subgrid_init(struct Subgrid *s);
+bool subgrid_add_patch(struct Subgrid *s, int i0, int j0, int i1, int j1, int ratio);
+bool subgrid_setup(struct Subgrid *s, const struct Range *whole, const struct Range *inside,
+                   const struct Mesh *mesh, FLOAT dt);
+void subgrid_set_media(struct SubgridPatch *p, FLOAT e0, FLOAT m0, const struct Dispersive *materials,
+                       const unsigned char *mat, const unsigned int *obj_mask, const FLOAT *er);
+void subgrid_update(struct Subgrid *s, FLOAT *ex, FLOAT *ey);
+void subgrid_free(struct Subgrid *s);
+
+#endif /* SUBGRID_H */
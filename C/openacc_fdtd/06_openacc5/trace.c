@@ -0,0 +1,179 @@
+/**
+ * @file trace.c
+ * @brief Timeline of the phases of a time step (Chrome trace JSON)
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const struct {
+    const char *name;
+    const char *category;
+} trace_phases[TRACE_NPHASES] = {
+    { "step",       "step"    },
+    { "halo_hz",    "mpi"     },
+    { "calc_ex_ey", "compute" },
+    { "pml_e",      "compute" },
+    { "update_e",   "compute" },
+    { "halo_ex",    "mpi"     },
+    { "calc_hz",    "compute" },
+    { "pml_h",      "compute" },
+    { "update_h",   "compute" },
+    { "gather",     "mpi"     },
+    { "write_bmp",  "output"  },
+    { "snapshot",   "output"  },
+    { "stats",      "monitor" }
+};
+
+static double trace_clock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1.0e6 + ts.tv_nsec*1.0e-3;
+}
+
+void trace_init(struct Trace *t, const struct TraceConfig *cfg)
+{
+    memset(t, 0, sizeof(struct Trace));
+    t->cfg    = *cfg;
+    t->rank   = 0;
+    t->nprocs = 1;
+    if (t->cfg.capacity < 0) t->cfg.capacity = 0;
+
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if (initialized) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &t->rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &t->nprocs);
+    }
+    if (t->cfg.capacity == 0) return;
+
+    t->events = (struct TraceEvent *)malloc(sizeof(struct TraceEvent)*t->cfg.capacity);
+    if (t->events == NULL) {
+        fprintf(stderr, "Error: cannot allocate the trace of %d events\n", t->cfg.capacity);
+        t->cfg.capacity = 0;
+    }
+
+    if (initialized) MPI_Barrier(MPI_COMM_WORLD);
+    t->t0 = trace_clock();
+}
+
+void trace_step(struct Trace *t, int icnt)
+{
+    t->icnt = icnt;
+}
+
+void trace_begin(struct Trace *t, int phase)
+{
+    if (t->cfg.capacity == 0) return;
+    t->begin[phase] = trace_clock() - t->t0;
+}
+
+void trace_end(struct Trace *t, int phase)
+{
+    if (t->cfg.capacity == 0) return;
+    struct TraceEvent *e = &t->events[t->nevents % t->cfg.capacity];
+    e->begin = t->begin[phase];
+    e->end   = trace_clock() - t->t0;
+    e->phase = phase;
+    e->icnt  = t->icnt;
+    t->nevents++;
+}
+
+static void write_events(FILE *fp, int rank, const struct TraceEvent *events, int n, bool *first)
+{
+    fprintf(fp, "%s\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"rank %d\"}}",
+            *first ? "" : ",", rank, rank);
+    fprintf(fp, ",\n{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"sort_index\":%d}}",
+            rank, rank);
+    *first = false;
+
+    for (int k=0; k<n; k++) {
+        const struct TraceEvent *e = &events[k];
+        fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":0,"
+                "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"icnt\":%d}}",
+                trace_phases[e->phase].name, trace_phases[e->phase].category, rank,
+                e->begin, e->end - e->begin, e->icnt);
+    }
+}
+
+bool trace_write(const struct Trace *t)
+{
+    if (t->cfg.capacity == 0) return true;
+
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+
+    // The ring from the oldest event
+    const int n = t->nevents < t->cfg.capacity ? (int)t->nevents : t->cfg.capacity;
+    struct TraceEvent *events = (struct TraceEvent *)malloc(sizeof(struct TraceEvent)*(n > 0 ? n : 1));
+    const int head = (int)(t->nevents % t->cfg.capacity);
+    for (int k=0; k<n; k++) {
+        events[k] = t->events[n < t->cfg.capacity ? k : (head + k) % t->cfg.capacity];
+    }
+
+    long dropped = t->nevents - n;
+    if (initialized) {
+        MPI_Allreduce(MPI_IN_PLACE, &dropped, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    }
+
+    const int tag = 0;
+    bool ok = true;
+    if (t->rank == 0) {
+        FILE *fp = fopen(t->cfg.filename, "w");
+        if (fp == NULL) {
+            fprintf(stderr, "Error: cannot open %s\n", t->cfg.filename);
+            ok = false;
+        } else {
+            fprintf(fp, "{\"traceEvents\":[");
+        }
+
+        bool first = true;
+        if (fp != NULL) write_events(fp, 0, events, n, &first);
+
+        // One rank at a time, to keep only one buffer on rank 0
+        for (int r=1; r<t->nprocs; r++) {
+            int nr = 0;
+            MPI_Recv(&nr, 1, MPI_INT, r, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            struct TraceEvent *er = (struct TraceEvent *)malloc(sizeof(struct TraceEvent)*(nr > 0 ? nr : 1));
+            MPI_Recv(er, (int)sizeof(struct TraceEvent)*nr, MPI_BYTE, r, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            if (fp != NULL) write_events(fp, r, er, nr, &first);
+            free(er);
+        }
+
+        if (fp != NULL) {
+            fprintf(fp, "\n],\n\"displayTimeUnit\":\"ms\",\n"
+                    "\"otherData\":{\"nprocs\":%d,\"capacity\":%d,\"dropped\":%ld}}\n",
+                    t->nprocs, t->cfg.capacity, dropped);
+            fclose(fp);
+        }
+        if (dropped > 0) {
+            fprintf(stdout, "trace: %ld oldest events dropped (capacity %d per rank)\n", dropped, t->cfg.capacity);
+        }
+    } else {
+        MPI_Send(&n, 1, MPI_INT, 0, tag, MPI_COMM_WORLD);
+        MPI_Send(events, (int)sizeof(struct TraceEvent)*n, MPI_BYTE, 0, tag, MPI_COMM_WORLD);
+    }
+
+    free(events);
+    return ok;
+}
+
+void trace_free(struct Trace *t)
+{
+    free(t->events);
+    t->events = NULL;
+    t->cfg.capacity = 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file trace.h
+ * @brief Timeline of the phases of a time step (Chrome trace JSON)
+ *
+ * Each rank records the begin and end of the phases (kernels, halo
+ * exchanges, gathers, output) in a ring buffer of cfg.capacity events;
+ * when the buffer is full the oldest events are overwritten.  The
+ * timestamps are taken from a clock started on all the ranks at the
+ * same barrier.  trace_write() collects the events on rank 0 and writes
+ * them in the Chrome trace event format (one process per rank), to be
+ * opened with chrome://tracing or https://ui.perfetto.dev.
+ *
+ * The kernels are synchronous, so the host time of a kernel phase is
+ * its device time.  Only the calling thread is traced, not the output
+ * worker.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include "config.h"
+
+enum TracePhase {
+    TRACE_STEP = 0,     // one time step
+    TRACE_HALO_HZ,
+    TRACE_CALC_EX_EY,
+    TRACE_PML_E,
+    TRACE_UPDATE_E,     // dispersive media, sources, subgrids and monitors of E
+    TRACE_HALO_EX,
+    TRACE_CALC_HZ,
+    TRACE_PML_H,
+    TRACE_UPDATE_H,     // sources, monitors and probes of H
+    TRACE_GATHER,
+    TRACE_OUTPUT,       // images (write_bmp)
+    TRACE_SNAPSHOT,
+    TRACE_STATS,
+    TRACE_NPHASES
+};
+
+struct TraceConfig {
+    int        capacity;  // events kept per rank; 0: off
+    const char *filename; // Chrome trace JSON written by rank 0
+};
+
+struct TraceEvent {
+    double begin, end;    // [us]
+    int    phase;
+    int    icnt;
+};
+
+struct Trace {
+    struct TraceConfig cfg;
+    int    rank, nprocs;
+    double t0;
+    double begin[TRACE_NPHASES];
+    int    icnt;
+    long   nevents;        // recorded so far; the ring holds the last cfg.capacity
+    struct TraceEvent *events;
+};
+
+/**
+ * @brief start the clock of the trace
+ *
+ * Collective over MPI_COMM_WORLD when MPI is initialized.
+ */
+void trace_init(struct Trace *t, const struct TraceConfig *cfg);
+void trace_step(struct Trace *t, int icnt);
+void trace_begin(struct Trace *t, int phase);
+void trace_end(struct Trace *t, int phase);
+
+/**
+ * @brief write the events of all the ranks to cfg.filename
+ *
+ * Collective over MPI_COMM_WORLD when MPI is initialized.
+ */
+bool trace_write(const struct Trace *t);
+void trace_free(struct Trace *t);
+
+#endif /* TRACE_H */
@@ -0,0 +1,94 @@
+/**
+ * @file worker.c
+ * @brief Background worker thread
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$ 
+ */
+
+#include "worker.h"
+#include <string.h>
+
+static void *worker_main(void *arg)
+{
+    struct Worker *w = (struct Worker *)arg;
+
+    pthread_mutex_lock(&w->mutex);
+    for (;;) {
+        while (w->running && w->completed == w->submitted) {
+            pthread_cond_wait(&w->cond, &w->mutex);
+        }
+        if (w->completed == w->submitted) break; // stopped and drained
+
+        const struct WorkerJob job = w->queue[w->completed % WORKER_QUEUE_SIZE];
+        pthread_mutex_unlock(&w->mutex);
+
+        job.func(job.arg);
+
+        pthread_mutex_lock(&w->mutex);
+        w->completed++;
+        pthread_cond_broadcast(&w->cond);
+    }
+    pthread_mutex_unlock(&w->mutex);
+    
+    return NULL;
+}
+
+void worker_start(struct Worker *w)
+{
+    memset(w, 0, sizeof(struct Worker));
+    pthread_mutex_init(&w->mutex, NULL);
+    pthread_cond_init (&w->cond , NULL);
+    w->running = 1;
+    pthread_create(&w->thread, NULL, worker_main, w);
+}
+
+void worker_stop(struct Worker *w)
+{
+    pthread_mutex_lock(&w->mutex);
+    w->running = 0;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->mutex);
+    
+    pthread_join(w->thread, NULL);
+    pthread_cond_destroy (&w->cond);
+    pthread_mutex_destroy(&w->mutex);
+}
+
+long worker_submit(struct Worker *w, void (*func)(void *arg), void *arg)
+{
+    pthread_mutex_lock(&w->mutex);
+    while (w->submitted - w->completed >= WORKER_QUEUE_SIZE) {
+        pthread_cond_wait(&w->cond, &w->mutex);
+    }
+    w->queue[w->submitted % WORKER_QUEUE_SIZE].func = func;
+    w->queue[w->submitted % WORKER_QUEUE_SIZE].arg  = arg;
+    const long ticket = w->submitted++;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->mutex);
+    
+    return ticket;
+}
+
+void worker_wait(struct Worker *w, long ticket)
+{
+    pthread_mutex_lock(&w->mutex);
+    while (w->completed <= ticket) {
+        pthread_cond_wait(&w->cond, &w->mutex);
+    }
+    pthread_mutex_unlock(&w->mutex);
+}
+
+void worker_wait_all(struct Worker *w)
+{
+    pthread_mutex_lock(&w->mutex);
+    while (w->completed < w->submitted) {
+        pthread_cond_wait(&w->cond, &w->mutex);
+    }
+    pthread_mutex_unlock(&w->mutex);
+}
@@ -0,0 +1,60 @@
+/**
+ * @file worker.h
+ * @brief Background worker thread
+ *
+ * A thread that executes submitted jobs in order, so that file output
+ * can overlap the time stepping.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$ 
+ */
+
+#ifndef WORKER_H
+#define WORKER_H
+
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WORKER_QUEUE_SIZE 64
+
+struct WorkerJob {
+    void (*func)(void *arg);
+    void *arg;
+};
+
+struct Worker {
+    pthread_t       thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    struct WorkerJob queue[WORKER_QUEUE_SIZE];
+    long  submitted; // number of submitted jobs
+    long  completed; // number of completed jobs
+    int   running;
+};
+
+void worker_start(struct Worker *w);
+void worker_stop(struct Worker *w);
+
+/**
+ * @brief submit a job; blocks while the queue is full
+ * @return ticket of the job, to be passed to worker_wait()
+ */
+long worker_submit(struct Worker *w, void (*func)(void *arg), void *arg);
+
+/**
+ * @brief wait until the job of the ticket (and all jobs before it) is completed
+ */
+void worker_wait(struct Worker *w, long ticket);
+void worker_wait_all(struct Worker *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORKER_H */
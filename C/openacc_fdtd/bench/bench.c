@@ -0,0 +1,508 @@
+/**
+ * @file bench.c
+ * @brief Benchmark of the FDTD kernels of all the openacc_fdtd variants
+ *
+ * Usage: ./bench [-v variants] [-s sizes] [-t steps] [-r repeat] [-f csv|json] [-o file]
+ *
+ *   -v 01,03,06       variants (default: all; 07, 08: the kernel library)
+ *   -s 256,512,1024   square grid sizes nx = ny (default: 256,512,1024,2048)
+ *   -t 100,1000       steps of a run (default: 100)
+ *   -r 5              runs of each case (default: 5)
+ *   -f csv            output format, csv or json (default: csv)
+ *   -o file           output file (default: stdout)
+ *
+ * The fdtd2d.c of each variant is built into this executable with its
+ * functions prefixed by the variant (see Makefile).  All of them step
+ * the same fields of one rank with the margins of main.c, on the device
+ * with OpenACC or on the host otherwise.  07_kernels_cell and
+ * 08_kernels_axis are the kernels of ../kernels/fdtd2d_kernels.h in the
+ * precision of FLOAT, with the coefficients of 01-05 and of 06; the
+ * fdtd2d.c of 06 calls 08, with the tiles of fdtd2d_set_tile() if any.
+ *
+ * For each case the output gives the elapsed time of a run (min, median,
+ * mean, standard deviation over the runs), Mcells/s and the effective
+ * bandwidth of the fastest run, the time per step of each kernel and the
+ * sum of hz after the last run, which is the same for all the variants.
+ * The bandwidth counts the compulsory traffic of the inside cells:
+ * ex, ey, hz read and written once and each coefficient array read once:
+ * four arrays per cell for 01-05; for 06 and 08 cexly and ceylx per cell
+ * and chzlx and chzly per row and column, which are not counted.  The
+ * PML is not counted.
+ *
+ * A STREAM triad over arrays larger than the caches measures the
+ * bandwidth of the node at startup.  With the flops and the compulsory
+ * bytes of each kernel (KernelModel) the output also gives the achieved
+ * bandwidth of each kernel and its fraction of the roofline
+ * min(peak, flop/byte * bandwidth), where the peak [GFlops] is taken
+ * from the environment variable ROOFLINE_PEAK_GFLOPS (bandwidth roof
+ * only when unset).  A fraction above 1 means the fields of the case
+ * fit in the caches.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "config.h"
+#include "fdtd2d_kernels.h"
+
+#define DECLARE_VARIANT(v)                                                                           \
+    void v##_calc_ex_ey(const struct Range *whole, const struct Range *inside,                       \
+                        const FLOAT *hz, const FLOAT *cexly, const FLOAT *ceylx, FLOAT *ex, FLOAT *ey); \
+    void v##_calc_hz(const struct Range *whole, const struct Range *inside,                          \
+                     const FLOAT *ey, const FLOAT *ex, const FLOAT *chzlx, const FLOAT *chzly, FLOAT *hz); \
+    void v##_pml_boundary_ex(const struct Range *whole, const struct Range *inside,                  \
+                             const FLOAT *hz, const FLOAT *cexy, const FLOAT *cexyl, const FLOAT *rer_ex, \
+                             FLOAT *ex, FLOAT *exy);                                                 \
+    void v##_pml_boundary_ey(const struct Range *whole, const struct Range *inside,                  \
+                             const FLOAT *hz, const FLOAT *ceyx, const FLOAT *ceyxl, const FLOAT *rer_ey, \
+                             FLOAT *ey, FLOAT *eyx);                                                 \
+    void v##_pml_boundary_hz(const struct Range *whole, const struct Range *inside,                  \
+                             const FLOAT *ey, const FLOAT *ex,                                       \
+                             const FLOAT *chzx, const FLOAT *chzxl, const FLOAT *chzy, const FLOAT *chzyl, \
+                             FLOAT *hz, FLOAT *hzx, FLOAT *hzy);
+
+DECLARE_VARIANT(v01)
+DECLARE_VARIANT(v02)
+DECLARE_VARIANT(v03)
+DECLARE_VARIANT(v04)
+DECLARE_VARIANT(v05)
+DECLARE_VARIANT(v06)
+
+struct Variant {
+    const char *name;
+    int        coef_per_cell; // 1: the coefficients of calc_ex_ey/calc_hz are [nelems], 0: [nx], [ny]
+    void (*calc_ex_ey)(const struct Range *, const struct Range *,
+                       const FLOAT *, const FLOAT *, const FLOAT *, FLOAT *, FLOAT *);
+    void (*calc_hz)(const struct Range *, const struct Range *,
+                    const FLOAT *, const FLOAT *, const FLOAT *, const FLOAT *, FLOAT *);
+    void (*pml_boundary_ex)(const struct Range *, const struct Range *,
+                            const FLOAT *, const FLOAT *, const FLOAT *, const FLOAT *, FLOAT *, FLOAT *);
+    void (*pml_boundary_ey)(const struct Range *, const struct Range *,
+                            const FLOAT *, const FLOAT *, const FLOAT *, const FLOAT *, FLOAT *, FLOAT *);
+    void (*pml_boundary_hz)(const struct Range *, const struct Range *, const FLOAT *, const FLOAT *,
+                            const FLOAT *, const FLOAT *, const FLOAT *, const FLOAT *,
+                            FLOAT *, FLOAT *, FLOAT *);
+};
+
+#define VARIANT(v, name, coef_per_cell) \
+    { name, coef_per_cell, v##_calc_ex_ey, v##_calc_hz, v##_pml_boundary_ex, v##_pml_boundary_ey, v##_pml_boundary_hz }
+
+static struct Variant variants[] = {
+    VARIANT(v01, "01_original", 1),
+    VARIANT(v02, "02_openacc1", 1),
+    VARIANT(v03, "03_openacc2", 1),
+    VARIANT(v04, "04_openacc3", 1),
+    VARIANT(v05, "05_openacc4", 1),
+    VARIANT(v06, "06_openacc5", 0),
+    { "07_kernels_cell", 1 }, // set by set_library_kernels()
+    { "08_kernels_axis", 0 },
+};
+static const int nvariants = sizeof(variants)/sizeof(variants[0]);
+
+// The kernels of fdtd2d_kernels.h of the layout of v on the device, in the precision of FLOAT
+static void set_library_kernels(struct Variant *v)
+{
+    const int layout  = v->coef_per_cell ? FDTD2D_LAYOUT_CELL : FDTD2D_LAYOUT_AXIS;
+    const int backend = FDTD2D_BACKEND_DEVICE;
+    v->calc_ex_ey      = FDTD2D_KERNELS(FLOAT, layout, backend)->calc_ex_ey;
+    v->calc_hz         = FDTD2D_KERNELS(FLOAT, layout, backend)->calc_hz;
+    v->pml_boundary_ex = FDTD2D_KERNELS(FLOAT, layout, backend)->pml_boundary_ex;
+    v->pml_boundary_ey = FDTD2D_KERNELS(FLOAT, layout, backend)->pml_boundary_ey;
+    v->pml_boundary_hz = FDTD2D_KERNELS(FLOAT, layout, backend)->pml_boundary_hz;
+}
+
+enum Kernel { K_CALC_EX_EY, K_PML_EX, K_PML_EY, K_CALC_HZ, K_PML_HZ, NKERNELS };
+static const char *kernel_names[NKERNELS] = { "calc_ex_ey", "pml_boundary_ex", "pml_boundary_ey",
+                                              "calc_hz", "pml_boundary_hz" };
+
+// Flops and FLOATs moved per updated cell
+struct KernelModel {
+    int flops;
+    int floats_cell; // coefficients per cell (01-05, 07)
+    int floats_line; // chzlx, chzly per row and column (06, 08)
+    int pml;         // 0: the inside cells, 1: the PML cells
+};
+static const struct KernelModel models[NKERNELS] = {
+    { 6, 7, 7, 0 }, // ex, ey += c (hz - hz); hz, ex rw, ey rw, cexly, ceylx
+    { 5, 5, 5, 1 }, // exy = c exy + rer cl (hz - hz); hz, rer_ex, exy rw, ex
+    { 5, 5, 5, 1 },
+    { 6, 6, 4, 0 }, // hz += -c (ey - ey) + c (ex - ex); ey, ex, hz rw, chzlx, chzly
+    { 9, 7, 7, 1 }, // hzx, hzy, hz = hzx + hzy; ey, ex, hzx rw, hzy rw, hz
+};
+
+struct Fields {
+    int   nelems;
+    FLOAT *ex, *ey, *hz;
+    FLOAT *cexly, *ceylx, *chzlx, *chzly;
+    FLOAT *exy, *eyx, *hzx, *hzy;
+    FLOAT *cexy, *ceyx, *chzx, *chzy;
+    FLOAT *cexyl, *ceyxl, *chzxl, *chzyl;
+    FLOAT *rer_ex, *rer_ey;
+};
+
+struct Result {
+    const char *variant;
+    int    nx, ny, nt, repeat;
+    double tmin, tmedian, tmean, tstddev;
+    double mcells, gbytes;
+    double kernel[NKERNELS]; // [sec/step] of the fastest run
+    double checksum;         // sum of hz
+    double kernel_gbytes[NKERNELS];
+    double kernel_roofline[NKERNELS]; // achieved/attainable flops
+};
+
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec*1.0e-6;
+}
+
+static double stream_bandwidth(int n)
+{
+    FLOAT *a = (FLOAT *)malloc(sizeof(FLOAT)*n);
+    FLOAT *b = (FLOAT *)malloc(sizeof(FLOAT)*n);
+    FLOAT *c = (FLOAT *)malloc(sizeof(FLOAT)*n);
+    const FLOAT s = 3.0;
+    double best = 0.0;
+
+#pragma acc data create(a[0:n], b[0:n], c[0:n])
+    {
+#pragma acc kernels present(a, b, c)
+#pragma acc loop independent
+        for (int i=0; i<n; i++) {
+            a[i] = 0.0;
+            b[i] = 1.0;
+            c[i] = 2.0;
+        }
+
+        // The first pass is not timed
+        for (int r=0; r<6; r++) {
+            const double t0 = now();
+#pragma acc kernels present(a, b, c)
+#pragma acc loop independent
+            for (int i=0; i<n; i++) {
+                a[i] = b[i] + s*c[i];
+            }
+            const double t = now() - t0;
+            if (r > 0 && (best == 0.0 || t < best)) best = t;
+        }
+    }
+
+    free(a);
+    free(b);
+    free(c);
+
+    return 3.0*sizeof(FLOAT)*(double)n/best;
+}
+
+static int parse_list(const char *s, int *values, int max)
+{
+    int n = 0;
+    while (*s != '\0' && n < max) {
+        char *end;
+        values[n++] = (int)strtol(s, &end, 10);
+        s = *end == ',' ? end + 1 : end;
+        if (end == s && *end != '\0') break;
+    }
+    return n;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/**
+ * @brief fill the fields with a smooth pattern and the coefficients of a
+ *        stable uniform grid (normalized units, Courant number 0.2)
+ */
+static void init_fields(struct Fields *f, const struct Range *whole)
+{
+    const int   lnx = whole->length[0];
+    const int   lny = whole->length[1];
+    const FLOAT dt  = 0.2/sqrt(2.0);
+
+    for (int j=0; j<lny; j++) {
+        for (int i=0; i<lnx; i++) {
+            const int ix = j*lnx + i;
+            f->ex[ix] = 0.0;
+            f->ey[ix] = 0.0;
+            f->hz[ix] = sin(0.05*i)*cos(0.07*j);
+            f->exy[ix] = f->eyx[ix] = f->hzx[ix] = f->hzy[ix] = 0.0;
+            f->cexly[ix] = f->ceylx[ix] = f->chzlx[ix] = f->chzly[ix] = dt;
+            f->rer_ex[ix] = f->rer_ey[ix] = 1.0;
+        }
+    }
+    const int n = lnx > lny ? lnx : lny;
+    for (int k=0; k<n; k++) {
+        f->cexy [k] = f->ceyx [k] = f->chzx [k] = f->chzy [k] = 0.9;
+        f->cexyl[k] = f->ceyxl[k] = f->chzxl[k] = f->chzyl[k] = dt;
+    }
+}
+
+static void run_case(const struct Variant *v, struct Fields *f, const struct Range *whole,
+                     const struct Range *inside, int nt, int repeat, double bandwidth, double peak,
+                     struct Result *r)
+{
+    const int nelems = f->nelems;
+    const int nline  = whole->length[0] > whole->length[1] ? whole->length[0] : whole->length[1];
+
+    FLOAT *ex = f->ex, *ey = f->ey, *hz = f->hz;
+    FLOAT *cexly = f->cexly, *ceylx = f->ceylx, *chzlx = f->chzlx, *chzly = f->chzly;
+    FLOAT *exy = f->exy, *eyx = f->eyx, *hzx = f->hzx, *hzy = f->hzy;
+    FLOAT *cexy = f->cexy, *ceyx = f->ceyx, *chzx = f->chzx, *chzy = f->chzy;
+    FLOAT *cexyl = f->cexyl, *ceyxl = f->ceyxl, *chzxl = f->chzxl, *chzyl = f->chzyl;
+    FLOAT *rer_ex = f->rer_ex, *rer_ey = f->rer_ey;
+
+    double *times  = (double *)malloc(sizeof(double)*repeat);
+    double kernel[NKERNELS];
+    double best = -1.0;
+
+    for (int rep=0; rep<repeat; rep++) {
+        init_fields(f, whole);
+#pragma acc update device(ex[0:nelems], ey[0:nelems], hz[0:nelems])                   \
+    device(cexly[0:nelems], ceylx[0:nelems], chzlx[0:nelems], chzly[0:nelems])        \
+    device(exy[0:nelems], eyx[0:nelems], hzx[0:nelems], hzy[0:nelems])                \
+    device(cexy[0:nline], ceyx[0:nline], chzx[0:nline], chzy[0:nline])                \
+    device(cexyl[0:nline], ceyxl[0:nline], chzxl[0:nline], chzyl[0:nline])            \
+    device(rer_ex[0:nelems], rer_ey[0:nelems])
+
+        // One step out of the timing: first touch and device code loading
+        v->calc_ex_ey(whole, inside, hz, cexly, ceylx, ex, ey);
+        v->calc_hz(whole, inside, ey, ex, chzlx, chzly, hz);
+
+        double t[NKERNELS] = { 0.0 };
+        const double t0 = now();
+        for (int n=0; n<nt; n++) {
+            double tk = now();
+            v->calc_ex_ey(whole, inside, hz, cexly, ceylx, ex, ey);
+            double tn = now(); t[K_CALC_EX_EY] += tn - tk; tk = tn;
+            v->pml_boundary_ex(whole, inside, hz, cexy, cexyl, rer_ex, ex, exy);
+            tn = now(); t[K_PML_EX] += tn - tk; tk = tn;
+            v->pml_boundary_ey(whole, inside, hz, ceyx, ceyxl, rer_ey, ey, eyx);
+            tn = now(); t[K_PML_EY] += tn - tk; tk = tn;
+            v->calc_hz(whole, inside, ey, ex, chzlx, chzly, hz);
+            tn = now(); t[K_CALC_HZ] += tn - tk; tk = tn;
+            v->pml_boundary_hz(whole, inside, ey, ex, chzx, chzxl, chzy, chzyl, hz, hzx, hzy);
+            tn = now(); t[K_PML_HZ] += tn - tk;
+        }
+        times[rep] = now() - t0;
+
+        if (best < 0.0 || times[rep] < best) {
+            best = times[rep];
+            for (int k=0; k<NKERNELS; k++) kernel[k] = t[k]/nt;
+        }
+    }
+
+    // 01_original runs on the host
+    if (strcmp(v->name, "01_original") != 0) {
+#pragma acc update self(hz[0:nelems])
+    }
+    r->checksum = 0.0;
+    for (int k=0; k<nelems; k++) r->checksum += hz[k];
+
+    double sum = 0.0, sum2 = 0.0;
+    for (int rep=0; rep<repeat; rep++) {
+        sum  += times[rep];
+        sum2 += times[rep]*times[rep];
+    }
+    qsort(times, repeat, sizeof(double), compare_double);
+
+    const double cells = (double)inside->length[0]*inside->length[1]*nt;
+    // ex, ey, hz read and written, and the coefficients of calc_ex_ey and calc_hz
+    // (cexly, ceylx per cell only for the axis layout)
+    const double bytes = cells*sizeof(FLOAT)*(6 + (v->coef_per_cell ? 4 : 2));
+
+    r->variant = v->name;
+    r->nx      = inside->length[0];
+    r->ny      = inside->length[1];
+    r->nt      = nt;
+    r->repeat  = repeat;
+    r->tmin    = times[0];
+    r->tmedian = repeat % 2 ? times[repeat/2] : 0.5*(times[repeat/2 - 1] + times[repeat/2]);
+    r->tmean   = sum/repeat;
+    r->tstddev = repeat > 1 ? sqrt(fmax(sum2 - sum*sum/repeat, 0.0)/(repeat - 1)) : 0.0;
+    r->mcells  = 1.0e-6*cells/r->tmin;
+    r->gbytes  = 1.0e-9*bytes/r->tmin;
+    memcpy(r->kernel, kernel, sizeof(kernel));
+
+    const double ninside = (double)inside->length[0]*inside->length[1];
+    const double npml    = (double)whole->length[0]*whole->length[1] - ninside;
+    for (int k=0; k<NKERNELS; k++) {
+        const struct KernelModel *m = &models[k];
+        const double n     = m->pml ? npml : ninside;
+        const double flop  = n*m->flops;
+        const double bytes = n*sizeof(FLOAT)*(v->coef_per_cell ? m->floats_cell : m->floats_line);
+        const double attainable = peak > 0.0 && peak < flop/bytes*bandwidth ? peak : flop/bytes*bandwidth;
+        r->kernel_gbytes  [k] = 1.0e-9*bytes/kernel[k];
+        r->kernel_roofline[k] = flop/kernel[k]/attainable;
+    }
+
+    free(times);
+}
+
+static void write_csv(FILE *fp, const struct Result *r, int nresults)
+{
+    fprintf(fp, "variant,nx,ny,nt,repeat,time_min,time_median,time_mean,time_stddev,mcells_per_s,gbytes_per_s");
+    for (int k=0; k<NKERNELS; k++) fprintf(fp, ",%s", kernel_names[k]);
+    for (int k=0; k<NKERNELS; k++) fprintf(fp, ",%s_gbytes_per_s,%s_roofline", kernel_names[k], kernel_names[k]);
+    fprintf(fp, ",checksum\n");
+    for (int i=0; i<nresults; i++) {
+        fprintf(fp, "%s,%d,%d,%d,%d,%.6e,%.6e,%.6e,%.6e,%.3f,%.3f", r[i].variant, r[i].nx, r[i].ny, r[i].nt,
+                r[i].repeat, r[i].tmin, r[i].tmedian, r[i].tmean, r[i].tstddev, r[i].mcells, r[i].gbytes);
+        for (int k=0; k<NKERNELS; k++) fprintf(fp, ",%.6e", r[i].kernel[k]);
+        for (int k=0; k<NKERNELS; k++) fprintf(fp, ",%.3f,%.4f", r[i].kernel_gbytes[k], r[i].kernel_roofline[k]);
+        fprintf(fp, ",%.15e\n", r[i].checksum);
+    }
+}
+
+static void write_json(FILE *fp, const struct Result *r, int nresults, double bandwidth)
+{
+    char hostname[128];
+    gethostname(hostname, sizeof(hostname));
+
+    fprintf(fp, "{\n  \"host\": \"%s\",\n  \"sizeof_float\": %d,\n  \"stream_gbytes_per_s\": %.3f,\n  \"results\": [\n",
+            hostname, (int)sizeof(FLOAT), 1.0e-9*bandwidth);
+    for (int i=0; i<nresults; i++) {
+        fprintf(fp, "    { \"variant\": \"%s\", \"nx\": %d, \"ny\": %d, \"nt\": %d, \"repeat\": %d,\n",
+                r[i].variant, r[i].nx, r[i].ny, r[i].nt, r[i].repeat);
+        fprintf(fp, "      \"time\": { \"min\": %.6e, \"median\": %.6e, \"mean\": %.6e, \"stddev\": %.6e },\n",
+                r[i].tmin, r[i].tmedian, r[i].tmean, r[i].tstddev);
+        fprintf(fp, "      \"mcells_per_s\": %.3f, \"gbytes_per_s\": %.3f, \"checksum\": %.15e,\n",
+                r[i].mcells, r[i].gbytes, r[i].checksum);
+        fprintf(fp, "      \"kernel_time_per_step\": {");
+        for (int k=0; k<NKERNELS; k++) {
+            fprintf(fp, " \"%s\": %.6e%s", kernel_names[k], r[i].kernel[k], k < NKERNELS - 1 ? "," : " },\n");
+        }
+        fprintf(fp, "      \"kernel_roofline\": {");
+        for (int k=0; k<NKERNELS; k++) {
+            fprintf(fp, " \"%s\": { \"gbytes_per_s\": %.3f, \"fraction\": %.4f }%s", kernel_names[k],
+                    r[i].kernel_gbytes[k], r[i].kernel_roofline[k], k < NKERNELS - 1 ? "," : " }");
+        }
+        fprintf(fp, " }%s\n", i < nresults - 1 ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int sizes[64] = { 256, 512, 1024, 2048 };
+    int steps[64] = { 100 };
+    int selected[64];
+    int nsizes = 4, nsteps = 1, nselected = 0;
+    int repeat = 5;
+    const char *format   = "csv";
+    const char *filename = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "v:s:t:r:f:o:")) != -1) {
+        switch (opt) {
+        case 'v': nselected = parse_list(optarg, selected, 64); break;
+        case 's': nsizes    = parse_list(optarg, sizes, 64);    break;
+        case 't': nsteps    = parse_list(optarg, steps, 64);    break;
+        case 'r': repeat    = atoi(optarg);                     break;
+        case 'f': format    = optarg;                           break;
+        case 'o': filename  = optarg;                           break;
+        default:
+            fprintf(stderr, "%s [-v variants] [-s sizes] [-t steps] [-r repeat] [-f csv|json] [-o file]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (repeat < 1 || (strcmp(format, "csv") != 0 && strcmp(format, "json") != 0)) {
+        fprintf(stderr, "Error: invalid repeat or format\n");
+        return 1;
+    }
+    for (int k=0; k<nvariants; k++) {
+        if (variants[k].calc_ex_ey == NULL) set_library_kernels(&variants[k]);
+    }
+    if (nselected == 0) {
+        for (int k=0; k<nvariants; k++) selected[nselected++] = k + 1;
+    }
+    for (int k=0; k<nselected; k++) {
+        if (selected[k] < 1 || selected[k] > nvariants) {
+            fprintf(stderr, "Error: no variant %02d\n", selected[k]);
+            return 1;
+        }
+    }
+
+    struct Result *results = (struct Result *)malloc(sizeof(struct Result)*nselected*nsizes*nsteps);
+    int nresults = 0;
+
+    // Bandwidth over arrays larger than the caches, and the peak of the node if known
+    const double bandwidth = stream_bandwidth(1 << 24);
+    const char   *env      = getenv("ROOFLINE_PEAK_GFLOPS");
+    const double peak      = env != NULL ? atof(env)*1.0e9 : 0.0;
+    fprintf(stderr, "Bandwidth = %.2f [GB/s] (STREAM triad)\n", 1.0e-9*bandwidth);
+
+    const int mgn = 8;
+    for (int s=0; s<nsizes; s++) {
+        // The ranges of main.c with one subdomain
+        const struct Range inside = { { sizes[s], sizes[s] }, { 0, 0 } };
+        const struct Range whole  = { { inside.length[0] + 2*mgn + 1, inside.length[1] + 2*mgn + 1 },
+                                      { inside.begin[0]  - mgn      , inside.begin[1]  - mgn       } };
+        const int nelems = whole.length[0]*whole.length[1];
+        const int nline  = whole.length[0] > whole.length[1] ? whole.length[0] : whole.length[1];
+
+        struct Fields f;
+        FLOAT **cell[] = { &f.ex, &f.ey, &f.hz, &f.cexly, &f.ceylx, &f.chzlx, &f.chzly,
+                           &f.exy, &f.eyx, &f.hzx, &f.hzy, &f.rer_ex, &f.rer_ey };
+        FLOAT **line[] = { &f.cexy, &f.ceyx, &f.chzx, &f.chzy, &f.cexyl, &f.ceyxl, &f.chzxl, &f.chzyl };
+        for (size_t k=0; k<sizeof(cell)/sizeof(cell[0]); k++) *cell[k] = (FLOAT *)malloc(sizeof(FLOAT)*nelems);
+        for (size_t k=0; k<sizeof(line)/sizeof(line[0]); k++) *line[k] = (FLOAT *)malloc(sizeof(FLOAT)*nline);
+        f.nelems = nelems;
+
+        FLOAT *ex = f.ex, *ey = f.ey, *hz = f.hz;
+        FLOAT *cexly = f.cexly, *ceylx = f.ceylx, *chzlx = f.chzlx, *chzly = f.chzly;
+        FLOAT *exy = f.exy, *eyx = f.eyx, *hzx = f.hzx, *hzy = f.hzy;
+        FLOAT *cexy = f.cexy, *ceyx = f.ceyx, *chzx = f.chzx, *chzy = f.chzy;
+        FLOAT *cexyl = f.cexyl, *ceyxl = f.ceyxl, *chzxl = f.chzxl, *chzyl = f.chzyl;
+        FLOAT *rer_ex = f.rer_ex, *rer_ey = f.rer_ey;
+
+#pragma acc data create(ex[0:nelems], ey[0:nelems], hz[0:nelems])                     \
+    create(cexly[0:nelems], ceylx[0:nelems], chzlx[0:nelems], chzly[0:nelems])        \
+    create(exy[0:nelems], eyx[0:nelems], hzx[0:nelems], hzy[0:nelems])                \
+    create(cexy[0:nline], ceyx[0:nline], chzx[0:nline], chzy[0:nline])                \
+    create(cexyl[0:nline], ceyxl[0:nline], chzxl[0:nline], chzyl[0:nline])            \
+    create(rer_ex[0:nelems], rer_ey[0:nelems])
+        {
+            for (int t=0; t<nsteps; t++) {
+                for (int k=0; k<nselected; k++) {
+                    const struct Variant *v = &variants[selected[k] - 1];
+                    fprintf(stderr, "%s %d x %d, %d steps\n", v->name, inside.length[0], inside.length[1], steps[t]);
+                    run_case(v, &f, &whole, &inside, steps[t], repeat, bandwidth, peak, &results[nresults++]);
+                }
+            }
+        }
+
+        for (size_t k=0; k<sizeof(cell)/sizeof(cell[0]); k++) free(*cell[k]);
+        for (size_t k=0; k<sizeof(line)/sizeof(line[0]); k++) free(*line[k]);
+    }
+
+    FILE *fp = filename != NULL ? fopen(filename, "w") : stdout;
+    if (fp == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", filename);
+        return 1;
+    }
+    if (strcmp(format, "json") == 0) {
+        write_json(fp, results, nresults, bandwidth);
+    } else {
+        write_csv(fp, results, nresults);
+    }
+    if (fp != stdout) fclose(fp);
+
+    free(results);
+
+    return 0;
+}
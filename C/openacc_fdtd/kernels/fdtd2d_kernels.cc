@@ -0,0 +1,370 @@
+/**
+ * @file fdtd2d_kernels.cc
+ * @brief FDTD kernels of all the openacc_fdtd variants in one library, for float and double
+ *
+ * (File explanation)
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#include "fdtd2d_kernels.h"
+
+// The compute regions of Fdtd2dDevice run on the device, the ones of
+// Fdtd2dHost on the host (if clause false); without data clauses the
+// arrays are taken from an enclosing data region or managed memory.
+
+template <typename Real, typename Layout, typename Backend>
+void Fdtd2dKernels<Real, Layout, Backend>::calc_ex_ey(const Range *whole, const Range *inside,
+                                                     const Real *hz, const Real *cexly, const Real *ceylx,
+                                                     Real *ex, Real *ey)
+{
+    const bool device = Backend::device;
+
+    const int nx    = inside->length[0];
+    const int ny    = inside->length[1];
+    const int mgn[] = { inside->begin[0] - whole->begin[0],
+                        inside->begin[1] - whole->begin[1] };
+    const int lnx   = whole->length[0];
+
+    const int mgn0  = mgn[0];
+    const int mgn1  = mgn[1];
+
+#pragma acc kernels if(device)
+#pragma acc loop independent
+    for (int j=0; j<ny+1; j++) {
+#pragma acc loop independent
+        for (int i=0; i<nx; i++) {
+            const int ix = (j+mgn1)*lnx + i+mgn0;
+            const int jm = ix - lnx;
+            ex[ix] += cexly[ix]*(hz[ix]-hz[jm]);
+        }
+    }
+
+#pragma acc kernels if(device)
+#pragma acc loop independent
+    for (int j=0; j<ny; j++) {
+#pragma acc loop independent
+        for (int i=0; i<nx+1; i++) {
+            const int ix = (j+mgn1)*lnx + i+mgn0;
+            const int im = ix - 1;
+            ey[ix] += - ceylx[ix]*(hz[ix]-hz[im]);
+        }
+    }
+}
+
+template <typename Real, typename Layout, typename Backend>
+void Fdtd2dKernels<Real, Layout, Backend>::calc_hz(const Range *whole, const Range *inside,
+                                                  const Real *ey, const Real *ex,
+                                                  const Real *chzlx, const Real *chzly, Real *hz)
+{
+    const bool device   = Backend::device;
+    const bool per_cell = Layout::layout == FDTD2D_LAYOUT_CELL;
+
+    const int nx    = inside->length[0];
+    const int ny    = inside->length[1];
+    const int mgn[] = { inside->begin[0] - whole->begin[0],
+                        inside->begin[1] - whole->begin[1] };
+    const int lnx   = whole->length[0];
+
+    const int mgn0  = mgn[0];
+    const int mgn1  = mgn[1];
+
+#pragma acc kernels if(device)
+#pragma acc loop independent
+    for (int j=0; j<ny; j++) {
+#pragma acc loop independent
+        for (int i=0; i<nx; i++) {
+            const int ix = (j+mgn1)*lnx + i+mgn0;
+            const int ip = ix + 1;
+            const int jp = ix + lnx;
+            const int kx = per_cell ? ix : i+mgn0;
+            const int ky = per_cell ? ix : j+mgn1;
+            hz[ix] += - chzlx[kx]*(ey[ip]-ey[ix]) + chzly[ky]*(ex[jp]-ex[ix]);
+        }
+    }
+}
+
+template <typename Real, typename Layout, typename Backend>
+void Fdtd2dKernels<Real, Layout, Backend>::calc_ex_ey_tiled(const Range *whole, const Range *inside, const int tile[2],
+                                                           const Real *hz, const Real *cexly, const Real *ceylx,
+                                                           Real *ex, Real *ey)
+{
+    const bool device = Backend::device;
+
+    const int nx    = inside->length[0];
+    const int ny    = inside->length[1];
+    const int mgn[] = { inside->begin[0] - whole->begin[0],
+                        inside->begin[1] - whole->begin[1] };
+    const int lnx   = whole->length[0];
+
+    const int mgn0  = mgn[0];
+    const int mgn1  = mgn[1];
+
+    // ex on nx x (ny+1) cells, ey on (nx+1) x ny cells
+    const int tx  = tile[0] > 0 && tile[0] < nx+1 ? tile[0] : nx+1;
+    const int ty  = tile[1] > 0 && tile[1] < ny+1 ? tile[1] : ny+1;
+    const int ntx = (nx+1 + tx-1)/tx;
+    const int nty = (ny+1 + ty-1)/ty;
+
+#pragma acc kernels if(device)
+#pragma acc loop independent gang collapse(2)
+    for (int tj=0; tj<nty; tj++) {
+        for (int ti=0; ti<ntx; ti++) {
+            const int i0 = ti*tx;
+            const int j0 = tj*ty;
+            const int i1 = i0 + tx < nx   ? i0 + tx : nx;
+            const int j1 = j0 + ty < ny+1 ? j0 + ty : ny+1;
+#pragma acc loop independent vector collapse(2)
+            for (int j=j0; j<j1; j++) {
+                for (int i=i0; i<i1; i++) {
+                    const int ix = (j+mgn1)*lnx + i+mgn0;
+                    const int jm = ix - lnx;
+                    ex[ix] += cexly[ix]*(hz[ix]-hz[jm]);
+                }
+            }
+        }
+    }
+
+#pragma acc kernels if(device)
+#pragma acc loop independent gang collapse(2)
+    for (int tj=0; tj<nty; tj++) {
+        for (int ti=0; ti<ntx; ti++) {
+            const int i0 = ti*tx;
+            const int j0 = tj*ty;
+            const int i1 = i0 + tx < nx+1 ? i0 + tx : nx+1;
+            const int j1 = j0 + ty < ny   ? j0 + ty : ny;
+#pragma acc loop independent vector collapse(2)
+            for (int j=j0; j<j1; j++) {
+                for (int i=i0; i<i1; i++) {
+                    const int ix = (j+mgn1)*lnx + i+mgn0;
+                    const int im = ix - 1;
+                    ey[ix] += - ceylx[ix]*(hz[ix]-hz[im]);
+                }
+            }
+        }
+    }
+}
+
+template <typename Real, typename Layout, typename Backend>
+void Fdtd2dKernels<Real, Layout, Backend>::calc_hz_tiled(const Range *whole, const Range *inside, const int tile[2],
+                                                        const Real *ey, const Real *ex,
+                                                        const Real *chzlx, const Real *chzly, Real *hz)
+{
+    const bool device   = Backend::device;
+    const bool per_cell = Layout::layout == FDTD2D_LAYOUT_CELL;
+
+    const int nx    = inside->length[0];
+    const int ny    = inside->length[1];
+    const int mgn[] = { inside->begin[0] - whole->begin[0],
+                        inside->begin[1] - whole->begin[1] };
+    const int lnx   = whole->length[0];
+
+    const int mgn0  = mgn[0];
+    const int mgn1  = mgn[1];
+
+    const int tx  = tile[0] > 0 && tile[0] < nx ? tile[0] : nx;
+    const int ty  = tile[1] > 0 && tile[1] < ny ? tile[1] : ny;
+    const int ntx = (nx + tx-1)/tx;
+    const int nty = (ny + ty-1)/ty;
+
+#pragma acc kernels if(device)
+#pragma acc loop independent gang collapse(2)
+    for (int tj=0; tj<nty; tj++) {
+        for (int ti=0; ti<ntx; ti++) {
+            const int i0 = ti*tx;
+            const int j0 = tj*ty;
+            const int i1 = i0 + tx < nx ? i0 + tx : nx;
+            const int j1 = j0 + ty < ny ? j0 + ty : ny;
+#pragma acc loop independent vector collapse(2)
+            for (int j=j0; j<j1; j++) {
+                for (int i=i0; i<i1; i++) {
+                    const int ix = (j+mgn1)*lnx + i+mgn0;
+                    const int ip = ix + 1;
+                    const int jp = ix + lnx;
+                    const int kx = per_cell ? ix : i+mgn0;
+                    const int ky = per_cell ? ix : j+mgn1;
+                    hz[ix] += - chzlx[kx]*(ey[ip]-ey[ix]) + chzly[ky]*(ex[jp]-ex[ix]);
+                }
+            }
+        }
+    }
+}
+
+template <typename Real, typename Layout, typename Backend>
+void Fdtd2dKernels<Real, Layout, Backend>::pml_boundary_ex(const Range *whole, const Range *inside,
+                                                          const Real *hz, const Real *cexy, const Real *cexyl,
+                                                          const Real *rer_ex, Real *ex, Real *exy)
+{
+    const bool device = Backend::device;
+
+    const int bi[] = { inside->begin[0], inside->begin[1] };
+    const int ei[] = { inside->begin[0] + inside->length[0], inside->begin[1] + inside->length[1] };
+    const int bw[] = { whole->begin[0], whole->begin[1] };
+    const int ew[] = { whole->begin[0] + whole->length[0], whole->begin[1] + whole->length[1] };
+
+    const int r[4][4] = { { bw[0], ew[0], bw[1]+1, bi[1] },
+                          { bw[0], ew[0], ei[1]+1, ew[1] },
+                          { bw[0], bi[0], bi[1]  , ei[1]+1},
+                          { ei[0], ew[0], bi[1]  , ei[1]+1} };
+
+    const int lnx = whole->length[0];
+    const int bw0 = bw[0];
+    const int bw1 = bw[1];
+
+#pragma acc kernels if(device)
+#pragma acc loop independent
+    for (int l=0; l<4; l++) {
+#pragma acc loop independent
+        for (int j=r[l][2]; j<r[l][3]; j++) {
+#pragma acc loop independent
+            for (int i=r[l][0]; i<r[l][1]; i++) {
+                const int jj = j - bw1;
+                const int ii = i - bw0;
+
+                const int ix = jj*lnx + ii;
+                const int jm = ix - lnx;
+                exy[ix] = cexy[jj]*exy[ix] + rer_ex[ix]*cexyl[jj]*(hz[ix] - hz[jm]);
+                ex [ix] = exy[ix];
+            }
+        }
+    }
+}
+
+template <typename Real, typename Layout, typename Backend>
+void Fdtd2dKernels<Real, Layout, Backend>::pml_boundary_ey(const Range *whole, const Range *inside,
+                                                          const Real *hz, const Real *ceyx, const Real *ceyxl,
+                                                          const Real *rer_ey, Real *ey, Real *eyx)
+{
+    const bool device = Backend::device;
+
+    const int bi[] = { inside->begin[0], inside->begin[1] };
+    const int ei[] = { inside->begin[0] + inside->length[0], inside->begin[1] + inside->length[1] };
+    const int bw[] = { whole->begin[0], whole->begin[1] };
+    const int ew[] = { whole->begin[0] + whole->length[0], whole->begin[1] + whole->length[1] };
+
+    const int r[4][4] = { { bw[0]+1, ew[0], bw[1], bi[1] },
+                          { bw[0]+1, ew[0], ei[1], ew[1] },
+                          { bw[0]+1, bi[0], bi[1], ei[1] },
+                          { ei[0]+1, ew[0], bi[1], ei[1] } };
+
+    const int lnx = whole->length[0];
+    const int bw0 = bw[0];
+    const int bw1 = bw[1];
+
+#pragma acc kernels if(device)
+#pragma acc loop independent
+    for (int l=0; l<4; l++) {
+#pragma acc loop independent
+        for (int j=r[l][2]; j<r[l][3]; j++) {
+#pragma acc loop independent
+            for (int i=r[l][0]; i<r[l][1]; i++) {
+                const int jj = j - bw1;
+                const int ii = i - bw0;
+
+                const int ix = jj*lnx + ii;
+                const int im = ix - 1;
+                eyx[ix] = ceyx[ii]*eyx[ix] - rer_ey[ix]*ceyxl[ii]*(hz[ix]-hz[im]);
+                ey [ix] = eyx[ix];
+            }
+        }
+    }
+}
+
+template <typename Real, typename Layout, typename Backend>
+void Fdtd2dKernels<Real, Layout, Backend>::pml_boundary_hz(const Range *whole, const Range *inside,
+                                                          const Real *ey, const Real *ex,
+                                                          const Real *chzx, const Real *chzxl,
+                                                          const Real *chzy, const Real *chzyl,
+                                                          Real *hz, Real *hzx, Real *hzy)
+{
+    const bool device = Backend::device;
+
+    const int bi[] = { inside->begin[0], inside->begin[1] };
+    const int ei[] = { inside->begin[0] + inside->length[0], inside->begin[1] + inside->length[1] };
+    const int bw[] = { whole->begin[0], whole->begin[1] };
+    const int ew[] = { whole->begin[0] + whole->length[0], whole->begin[1] + whole->length[1] };
+
+    const int r[4][4] = { { bw[0], ew[0]-1, bw[1], bi[1] },
+                          { bw[0], ew[0]-1, ei[1], ew[1]-1 },
+                          { bw[0], bi[0]  , bi[1], ei[1] },
+                          { ei[0], ew[0]-1, bi[1], ei[1] } };
+
+    const int lnx = whole->length[0];
+    const int bw0 = bw[0];
+    const int bw1 = bw[1];
+
+#pragma acc kernels if(device)
+#pragma acc loop independent
+    for (int l=0; l<4; l++) {
+#pragma acc loop independent
+        for (int j=r[l][2]; j<r[l][3]; j++) {
+#pragma acc loop independent
+            for (int i=r[l][0]; i<r[l][1]; i++) {
+                const int jj = j - bw1;
+                const int ii = i - bw0;
+
+                const int ix = jj*lnx + ii;
+                const int ip = ix + 1;
+                const int jp = ix + lnx;
+                hzx[ix] = chzx[ii]*hzx[ix] - chzxl[ii]*(ey[ip]-ey[ix]);
+                hzy[ix] = chzy[jj]*hzy[ix] + chzyl[jj]*(ex[jp]-ex[ix]);
+                hz [ix] = hzx[ix] + hzy[ix];
+            }
+        }
+    }
+}
+
+template struct Fdtd2dKernels<float,  Fdtd2dLayoutCell, Fdtd2dHost>;
+template struct Fdtd2dKernels<float,  Fdtd2dLayoutCell, Fdtd2dDevice>;
+template struct Fdtd2dKernels<float,  Fdtd2dLayoutAxis, Fdtd2dHost>;
+template struct Fdtd2dKernels<float,  Fdtd2dLayoutAxis, Fdtd2dDevice>;
+template struct Fdtd2dKernels<double, Fdtd2dLayoutCell, Fdtd2dHost>;
+template struct Fdtd2dKernels<double, Fdtd2dLayoutCell, Fdtd2dDevice>;
+template struct Fdtd2dKernels<double, Fdtd2dLayoutAxis, Fdtd2dHost>;
+template struct Fdtd2dKernels<double, Fdtd2dLayoutAxis, Fdtd2dDevice>;
+
+
+// C tables of the instantiations, [layout][backend]
+namespace {
+
+#define FDTD2D_TABLE(Real, Layout, Backend)                       \
+    { Fdtd2dKernels<Real, Layout, Backend>::calc_ex_ey,           \
+      Fdtd2dKernels<Real, Layout, Backend>::calc_hz,              \
+      Fdtd2dKernels<Real, Layout, Backend>::pml_boundary_ex,      \
+      Fdtd2dKernels<Real, Layout, Backend>::pml_boundary_ey,      \
+      Fdtd2dKernels<Real, Layout, Backend>::pml_boundary_hz,      \
+      Fdtd2dKernels<Real, Layout, Backend>::calc_ex_ey_tiled,     \
+      Fdtd2dKernels<Real, Layout, Backend>::calc_hz_tiled }
+
+const Fdtd2dKernelsF32 tables_f32[FDTD2D_NLAYOUTS][FDTD2D_NBACKENDS] = {
+    { FDTD2D_TABLE(float, Fdtd2dLayoutCell, Fdtd2dHost), FDTD2D_TABLE(float, Fdtd2dLayoutCell, Fdtd2dDevice) },
+    { FDTD2D_TABLE(float, Fdtd2dLayoutAxis, Fdtd2dHost), FDTD2D_TABLE(float, Fdtd2dLayoutAxis, Fdtd2dDevice) }
+};
+
+const Fdtd2dKernelsF64 tables_f64[FDTD2D_NLAYOUTS][FDTD2D_NBACKENDS] = {
+    { FDTD2D_TABLE(double, Fdtd2dLayoutCell, Fdtd2dHost), FDTD2D_TABLE(double, Fdtd2dLayoutCell, Fdtd2dDevice) },
+    { FDTD2D_TABLE(double, Fdtd2dLayoutAxis, Fdtd2dHost), FDTD2D_TABLE(double, Fdtd2dLayoutAxis, Fdtd2dDevice) }
+};
+
+#undef FDTD2D_TABLE
+
+bool valid(int layout, int backend)
+{
+    return layout >= 0 && layout < FDTD2D_NLAYOUTS && backend >= 0 && backend < FDTD2D_NBACKENDS;
+}
+
+} // namespace
+
+const struct Fdtd2dKernelsF32 *fdtd2d_kernels_f32(int layout, int backend)
+{
+    return valid(layout, backend) ? &tables_f32[layout][backend] : NULL;
+}
+
+const struct Fdtd2dKernelsF64 *fdtd2d_kernels_f64(int layout, int backend)
+{
+    return valid(layout, backend) ? &tables_f64[layout][backend] : NULL;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file fdtd2d_kernels.h
+ * @brief FDTD kernels of all the openacc_fdtd variants in one library, for float and double
+ *
+ * The kernels of fdtd2d.c (calc_ex_ey, calc_hz and pml_boundary_*) as
+ * the C++ template Fdtd2dKernels<Real, Layout, Backend>:
+ *
+ *   Real    : float or double
+ *   Layout  : Fdtd2dLayoutCell, chzlx and chzly per cell (01-05), or
+ *             Fdtd2dLayoutAxis, chzlx per column and chzly per row (06)
+ *   Backend : Fdtd2dHost (loops on the host) or Fdtd2dDevice (OpenACC
+ *             compute regions; the arrays present on the device, or
+ *             managed memory)
+ *
+ * All the combinations are instantiated in fdtd2d_kernels.cc.  C gets
+ * them through tables of functions with the signatures of fdtd2d.h, one
+ * table type per precision, so that both precisions can be used in one
+ * binary whatever FLOAT is:
+ *
+ *   const struct Fdtd2dKernelsF32 *k = fdtd2d_kernels_f32(FDTD2D_LAYOUT_AXIS, FDTD2D_BACKEND_DEVICE);
+ *   k->calc_ex_ey(&whole, &inside, hz, cexly, ceylx, ex, ey);
+ *
+ * calc_ex_ey_tiled and calc_hz_tiled are the tiled loop nests of
+ * 06_openacc5 (fdtd2d_set_tile() of fdtd2d.h): one gang per tile of
+ * tile[0] x tile[1] cells, a tile of 0 being the whole extent.
+ *
+ * FDTD2D_KERNELS(FLOAT, layout, backend) selects the table of the FLOAT
+ * of config.h (C11 _Generic).  struct Range is the one of config.h; the
+ * library is built with the config.h of 06_openacc5 (see Makefile).
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#ifndef FDTD2D_KERNELS_H
+#define FDTD2D_KERNELS_H
+
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum Fdtd2dLayout {
+    FDTD2D_LAYOUT_CELL = 0, // chzlx, chzly [lnx*lny] (01_original - 05_openacc4)
+    FDTD2D_LAYOUT_AXIS = 1, // chzlx [lnx], chzly [lny] (06_openacc5)
+    FDTD2D_NLAYOUTS    = 2
+};
+
+enum Fdtd2dBackend {
+    FDTD2D_BACKEND_HOST   = 0,
+    FDTD2D_BACKEND_DEVICE = 1,
+    FDTD2D_NBACKENDS      = 2
+};
+
+#define FDTD2D_DECLARE_KERNELS(name, T)                                                             \
+    struct name {                                                                                   \
+        void (*calc_ex_ey)(const struct Range *whole, const struct Range *inside,                    \
+                           const T *hz, const T *cexly, const T *ceylx, T *ex, T *ey);               \
+        void (*calc_hz)(const struct Range *whole, const struct Range *inside,                       \
+                        const T *ey, const T *ex, const T *chzlx, const T *chzly, T *hz);            \
+        void (*pml_boundary_ex)(const struct Range *whole, const struct Range *inside,               \
+                                const T *hz, const T *cexy, const T *cexyl, const T *rer_ex,         \
+                                T *ex, T *exy);                                                      \
+        void (*pml_boundary_ey)(const struct Range *whole, const struct Range *inside,               \
+                                const T *hz, const T *ceyx, const T *ceyxl, const T *rer_ey,         \
+                                T *ey, T *eyx);                                                      \
+        void (*pml_boundary_hz)(const struct Range *whole, const struct Range *inside,               \
+                                const T *ey, const T *ex,                                            \
+                                const T *chzx, const T *chzxl, const T *chzy, const T *chzyl,        \
+                                T *hz, T *hzx, T *hzy);                                              \
+        void (*calc_ex_ey_tiled)(const struct Range *whole, const struct Range *inside,             \
+                                 const int tile[2],                                                 \
+                                 const T *hz, const T *cexly, const T *ceylx, T *ex, T *ey);        \
+        void (*calc_hz_tiled)(const struct Range *whole, const struct Range *inside,                \
+                              const int tile[2],                                                    \
+                              const T *ey, const T *ex, const T *chzlx, const T *chzly, T *hz);     \
+    };
+
+FDTD2D_DECLARE_KERNELS(Fdtd2dKernelsF32, float)
+FDTD2D_DECLARE_KERNELS(Fdtd2dKernelsF64, double)
+
+/**
+ * @brief the kernels of a layout and a backend
+ * @return NULL for an unknown layout or backend
+ */
+const struct Fdtd2dKernelsF32 *fdtd2d_kernels_f32(int layout, int backend);
+const struct Fdtd2dKernelsF64 *fdtd2d_kernels_f64(int layout, int backend);
+
+#ifndef __cplusplus
+#define FDTD2D_KERNELS(T, layout, backend) \
+    _Generic((T)0, float: fdtd2d_kernels_f32, double: fdtd2d_kernels_f64)(layout, backend)
+#endif
+
+#ifdef __cplusplus
+}
+
+struct Fdtd2dLayoutCell { static const int layout = FDTD2D_LAYOUT_CELL; };
+struct Fdtd2dLayoutAxis { static const int layout = FDTD2D_LAYOUT_AXIS; };
+
+struct Fdtd2dHost   { static const bool device = false; };
+struct Fdtd2dDevice { static const bool device = true;  };
+
+/**
+ * @brief The kernels of fdtd2d.c for a precision, a layout of the
+ *        coefficients of calc_hz and a backend
+ *
+ * Defined in fdtd2d_kernels.cc for the explicit instantiations there
+ * (float, double) x (Fdtd2dLayoutCell, Fdtd2dLayoutAxis) x (Fdtd2dHost,
+ * Fdtd2dDevice).
+ */
+template <typename Real, typename Layout, typename Backend>
+struct Fdtd2dKernels {
+    static void calc_ex_ey(const Range *whole, const Range *inside,
+                           const Real *hz, const Real *cexly, const Real *ceylx, Real *ex, Real *ey);
+    static void calc_hz(const Range *whole, const Range *inside,
+                        const Real *ey, const Real *ex, const Real *chzlx, const Real *chzly, Real *hz);
+    static void pml_boundary_ex(const Range *whole, const Range *inside,
+                                const Real *hz, const Real *cexy, const Real *cexyl, const Real *rer_ex,
+                                Real *ex, Real *exy);
+    static void pml_boundary_ey(const Range *whole, const Range *inside,
+                                const Real *hz, const Real *ceyx, const Real *ceyxl, const Real *rer_ey,
+                                Real *ey, Real *eyx);
+    static void pml_boundary_hz(const Range *whole, const Range *inside,
+                                const Real *ey, const Real *ex,
+                                const Real *chzx, const Real *chzxl, const Real *chzy, const Real *chzyl,
+                                Real *hz, Real *hzx, Real *hzy);
+    static void calc_ex_ey_tiled(const Range *whole, const Range *inside, const int tile[2],
+                                 const Real *hz, const Real *cexly, const Real *ceylx, Real *ex, Real *ey);
+    static void calc_hz_tiled(const Range *whole, const Range *inside, const int tile[2],
+                              const Real *ey, const Real *ex, const Real *chzlx, const Real *chzly, Real *hz);
+};
+#endif
+
+#endif /* FDTD2D_KERNELS_H */
@@ -0,0 +1,233 @@
+/**
+ * @file precision_study.cc
+ * @brief Single against double precision of the FDTD kernels, in one binary
+ *
+ * Usage: ./precision_study [-s size] [-t steps] [-i interval] [-l cell|axis] [-b host|device]
+ *
+ *   -s 512      square grid size nx = ny (default: 512)
+ *   -t 10000    steps (default: 10000)
+ *   -i 1000     steps between two lines of the output (default: 1000)
+ *   -l axis     layout of the coefficients of calc_hz (default: axis, 06_openacc5)
+ *   -b device   backend (default: device)
+ *
+ * Steps the same fields in float and in double with the kernels of
+ * fdtd2d_kernels.h (the problem of bench.c: a smooth hz, uniform
+ * coefficients at Courant number 0.2 and a PML margin of 8 cells), and
+ * prints the relative L2 difference |f - d|_2 / |d|_2 of ex, ey and hz
+ * every interval steps, then the time per step of each precision.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <unistd.h>
+#include <sys/time.h>
+#include "fdtd2d_kernels.h"
+
+namespace {
+
+enum Array {
+    EX, EY, HZ, CEXLY, CEYLX, CHZLX, CHZLY, EXY, EYX, HZX, HZY, RER_EX, RER_EY, // [nelems]
+    CEXY, CEYX, CHZX, CHZY, CEXYL, CEYXL, CHZXL, CHZYL,                         // [nline]
+    NARRAYS
+};
+const int ncell_arrays = CEXY;
+
+double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec*1.0e-6;
+}
+
+template <typename Real>
+class Fields {
+public:
+    Fields(const Range &whole, const Range &inside, bool device);
+    ~Fields();
+
+    template <typename Layout, typename Backend>
+    void step();
+    void update_self();
+
+    Range whole, inside;
+    int   nelems, nline;
+    bool  device;
+    Real  *a[NARRAYS];
+};
+
+template <typename Real>
+Fields<Real>::Fields(const Range &whole_, const Range &inside_, bool device_)
+    : whole(whole_), inside(inside_), device(device_)
+{
+    const int lnx = whole.length[0];
+    const int lny = whole.length[1];
+    nelems = lnx*lny;
+    nline  = lnx > lny ? lnx : lny;
+
+    for (int k=0; k<NARRAYS; k++) {
+        a[k] = (Real *)malloc(sizeof(Real)*(k < ncell_arrays ? nelems : nline));
+    }
+
+    // The fields and coefficients of bench.c
+    const double dt = 0.2/sqrt(2.0);
+    for (int j=0; j<lny; j++) {
+        for (int i=0; i<lnx; i++) {
+            const int ix = j*lnx + i;
+            a[EX][ix] = a[EY][ix] = 0.0;
+            a[HZ][ix] = sin(0.05*i)*cos(0.07*j);
+            a[EXY][ix] = a[EYX][ix] = a[HZX][ix] = a[HZY][ix] = 0.0;
+            a[CEXLY][ix] = a[CEYLX][ix] = a[CHZLX][ix] = a[CHZLY][ix] = dt;
+            a[RER_EX][ix] = a[RER_EY][ix] = 1.0;
+        }
+    }
+    for (int k=0; k<nline; k++) {
+        a[CEXY ][k] = a[CEYX ][k] = a[CHZX ][k] = a[CHZY ][k] = 0.9;
+        a[CEXYL][k] = a[CEYXL][k] = a[CHZXL][k] = a[CHZYL][k] = dt;
+    }
+
+    if (device) {
+        for (int k=0; k<NARRAYS; k++) {
+            Real *p = a[k];
+            const int n = k < ncell_arrays ? nelems : nline;
+#pragma acc enter data copyin(p[0:n])
+        }
+    }
+}
+
+template <typename Real>
+Fields<Real>::~Fields()
+{
+    for (int k=0; k<NARRAYS; k++) {
+        Real *p = a[k];
+        const int n = k < ncell_arrays ? nelems : nline;
+        if (device) {
+#pragma acc exit data delete(p[0:n])
+        }
+        free(p);
+    }
+}
+
+template <typename Real>
+template <typename Layout, typename Backend>
+void Fields<Real>::step()
+{
+    typedef Fdtd2dKernels<Real, Layout, Backend> K;
+    Real **f = a;
+    K::calc_ex_ey(&whole, &inside, f[HZ], f[CEXLY], f[CEYLX], f[EX], f[EY]);
+    K::pml_boundary_ex(&whole, &inside, f[HZ], f[CEXY], f[CEXYL], f[RER_EX], f[EX], f[EXY]);
+    K::pml_boundary_ey(&whole, &inside, f[HZ], f[CEYX], f[CEYXL], f[RER_EY], f[EY], f[EYX]);
+    K::calc_hz(&whole, &inside, f[EY], f[EX], f[CHZLX], f[CHZLY], f[HZ]);
+    K::pml_boundary_hz(&whole, &inside, f[EY], f[EX], f[CHZX], f[CHZXL], f[CHZY], f[CHZYL],
+                       f[HZ], f[HZX], f[HZY]);
+}
+
+template <typename Real>
+void Fields<Real>::update_self()
+{
+    if (!device) return;
+    for (int k=EX; k<=HZ; k++) {
+        Real *p = a[k];
+        const int n = nelems;
+#pragma acc update self(p[0:n])
+    }
+}
+
+// |f - d|_2 / |d|_2
+double relative_l2(int n, const float *f, const double *d)
+{
+    double sum_e = 0.0, sum_d = 0.0;
+    for (int k=0; k<n; k++) {
+        const double e = f[k] - d[k];
+        sum_e += e*e;
+        sum_d += d[k]*d[k];
+    }
+    return sum_d > 0.0 ? sqrt(sum_e/sum_d) : sqrt(sum_e);
+}
+
+template <typename Layout, typename Backend>
+void run(const Range &whole, const Range &inside, int nt, int interval)
+{
+    Fields<float>  f(whole, inside, Backend::device);
+    Fields<double> d(whole, inside, Backend::device);
+
+    double time_f = 0.0, time_d = 0.0;
+    fprintf(stdout, "# step  rel_l2_ex     rel_l2_ey     rel_l2_hz\n");
+    for (int n=0; n<nt; ) {
+        const int m = n + interval < nt ? interval : nt - n;
+
+        double t0 = now();
+        for (int k=0; k<m; k++) f.template step<Layout, Backend>();
+#pragma acc wait
+        time_f += now() - t0;
+
+        t0 = now();
+        for (int k=0; k<m; k++) d.template step<Layout, Backend>();
+#pragma acc wait
+        time_d += now() - t0;
+
+        n += m;
+        f.update_self();
+        d.update_self();
+        fprintf(stdout, "%6d  %.6e  %.6e  %.6e\n", n,
+                relative_l2(f.nelems, f.a[EX], d.a[EX]), relative_l2(f.nelems, f.a[EY], d.a[EY]),
+                relative_l2(f.nelems, f.a[HZ], d.a[HZ]));
+    }
+    fprintf(stdout, "# float  %.3f [usec/step]\n", time_f/nt*1.0e6);
+    fprintf(stdout, "# double %.3f [usec/step]\n", time_d/nt*1.0e6);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int size     = 512;
+    int nt       = 10000;
+    int interval = 1000;
+    int layout   = FDTD2D_LAYOUT_AXIS;
+    int backend  = FDTD2D_BACKEND_DEVICE;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:t:i:l:b:")) != -1) {
+        switch (opt) {
+        case 's': size     = atoi(optarg); break;
+        case 't': nt       = atoi(optarg); break;
+        case 'i': interval = atoi(optarg); break;
+        case 'l': layout   = strcmp(optarg, "cell") == 0 ? FDTD2D_LAYOUT_CELL :
+                             strcmp(optarg, "axis") == 0 ? FDTD2D_LAYOUT_AXIS : -1; break;
+        case 'b': backend  = strcmp(optarg, "host")   == 0 ? FDTD2D_BACKEND_HOST :
+                             strcmp(optarg, "device") == 0 ? FDTD2D_BACKEND_DEVICE : -1; break;
+        default:
+            fprintf(stderr, "%s [-s size] [-t steps] [-i interval] [-l cell|axis] [-b host|device]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (size < 1 || nt < 1 || interval < 1 || layout < 0 || backend < 0) {
+        fprintf(stderr, "Error: invalid size, steps, interval, layout or backend\n");
+        return 1;
+    }
+
+    // The ranges of main.c with one subdomain
+    const int mgn = 8;
+    const Range inside = { { size, size }, { 0, 0 } };
+    const Range whole  = { { size + 2*mgn + 1, size + 2*mgn + 1 }, { -mgn, -mgn } };
+
+    fprintf(stdout, "# %d x %d, %s, %s\n", size, size, layout == FDTD2D_LAYOUT_CELL ? "cell" : "axis",
+            backend == FDTD2D_BACKEND_HOST ? "host" : "device");
+    if (layout == FDTD2D_LAYOUT_CELL) {
+        if (backend == FDTD2D_BACKEND_HOST) run<Fdtd2dLayoutCell, Fdtd2dHost  >(whole, inside, nt, interval);
+        else                                run<Fdtd2dLayoutCell, Fdtd2dDevice>(whole, inside, nt, interval);
+    } else {
+        if (backend == FDTD2D_BACKEND_HOST) run<Fdtd2dLayoutAxis, Fdtd2dHost  >(whole, inside, nt, interval);
+        else                                run<Fdtd2dLayoutAxis, Fdtd2dDevice>(whole, inside, nt, interval);
+    }
+
+    return 0;
+}
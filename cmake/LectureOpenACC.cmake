@@ -0,0 +1,137 @@
+# Helpers of the top-level build: one executable per sample directory,
+# built from the SRCS and the flags of the Makefile of the directory, so
+# that the Makefiles stay the reference of every sample.
+
+# lecture_makefile_var(<dir> <var> <out>): the words of "<var> = ..." in <dir>/Makefile
+function(lecture_makefile_var dir var out)
+  set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS "${dir}/Makefile")
+  file(STRINGS "${dir}/Makefile" lines REGEX "^${var}[ \t]*=")
+  set(value "")
+  if(lines)
+    list(GET lines 0 line)
+    string(REGEX REPLACE "^${var}[ \t]*=[ \t]*" "" value "${line}")
+    separate_arguments(value UNIX_COMMAND "${value}")
+  endif()
+  set(${out} "${value}" PARENT_SCOPE)
+endfunction()
+
+# Compile and link options of OpenACC for a sample whose Makefile flags are <flags>
+function(lecture_openacc_options target flags)
+  set(managed FALSE)
+  foreach(f IN LISTS flags)
+    if(f MATCHES "managed")
+      set(managed TRUE)
+    endif()
+  endforeach()
+
+  if(CMAKE_C_COMPILER_ID STREQUAL "NVHPC" OR CMAKE_Fortran_COMPILER_ID STREQUAL "NVHPC")
+    if(LECTURE_ACC_TARGET STREQUAL "gpu")
+      set(gpu "-gpu=${LECTURE_GPU_ARCH}")
+      if(managed)
+        string(APPEND gpu ",managed")
+      endif()
+      set(options -acc=gpu ${gpu} -Minfo=accel)
+    else()
+      set(options -acc=${LECTURE_ACC_TARGET} -Minfo=accel)
+    endif()
+  elseif(CMAKE_C_COMPILER_ID STREQUAL "GNU" OR CMAKE_Fortran_COMPILER_ID STREQUAL "GNU")
+    # Without an offload compiler GCC runs the compute regions on the host
+    set(options -fopenacc)
+    if(NOT LECTURE_ACC_TARGET STREQUAL "gpu")
+      list(APPEND options -foffload=disable)
+    endif()
+  else()
+    set(options ${OpenACC_C_FLAGS})
+  endif()
+
+  target_compile_options(${target} PRIVATE ${options})
+  target_link_options(${target} PRIVATE ${options})
+endfunction()
+
+# lecture_add_sample(<target> <dir> [MAIN <file>] [NAME <executable>] [MPI])
+#
+# <dir>/Makefile gives the sources (SRCS, with main.c replaced by MAIN,
+# looked up in <dir> then in VPATH) and whether the sample uses OpenACC
+# (-acc), OpenMP (-mp) and managed memory; the executable is
+# <build>/<dir>/run (or run_mpi for MPI, or NAME).
+function(lecture_add_sample target dir)
+  cmake_parse_arguments(S "MPI" "MAIN;NAME" "" ${ARGN})
+  set(src_dir "${CMAKE_CURRENT_SOURCE_DIR}/${dir}")
+
+  lecture_makefile_var("${src_dir}" SRCS srcs)
+  if(S_MAIN)
+    list(TRANSFORM srcs REPLACE "^main\\.c$" "${S_MAIN}")
+  endif()
+
+  # The sources that are not in <dir> are in the VPATH of the Makefile
+  # (../../common), which is also on the include path
+  lecture_makefile_var("${src_dir}" VPATH vpath)
+  list(TRANSFORM vpath PREPEND "${src_dir}/")
+  set(paths "")
+  foreach(s IN LISTS srcs)
+    set(path "${src_dir}/${s}")
+    foreach(d IN LISTS vpath)
+      if(NOT EXISTS "${path}" AND EXISTS "${d}/${s}")
+        get_filename_component(path "${d}/${s}" ABSOLUTE)
+      endif()
+    endforeach()
+    list(APPEND paths "${path}")
+  endforeach()
+  set(srcs ${paths})
+
+  set(fortran FALSE)
+  foreach(s IN LISTS srcs)
+    if(s MATCHES "\\.f90$")
+      set(fortran TRUE)
+    endif()
+  endforeach()
+  if(fortran)
+    lecture_makefile_var("${src_dir}" FFLAGS flags)
+  else()
+    lecture_makefile_var("${src_dir}" CFLAGS flags)
+  endif()
+
+  set(name run)
+  if(S_MPI)
+    set(name run_mpi)
+  endif()
+  if(S_NAME)
+    set(name ${S_NAME})
+  endif()
+
+  add_executable(${target} ${srcs})
+  target_include_directories(${target} PRIVATE "${src_dir}" ${vpath})
+  target_compile_options(${target} PRIVATE ${LECTURE_SIMD_FLAGS})
+  set_target_properties(${target} PROPERTIES
+    RUNTIME_OUTPUT_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}/${dir}"
+    OUTPUT_NAME              ${name}
+    Fortran_MODULE_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}/${dir}/modules_${target}")
+
+  if("-acc" IN_LIST flags)
+    lecture_openacc_options(${target} "${flags}")
+  endif()
+  if("-mp" IN_LIST flags)
+    target_link_libraries(${target} PRIVATE OpenMP::OpenMP_Fortran)
+  endif()
+
+  if(NOT fortran)
+    if(LECTURE_PERF_COUNTERS)
+      target_compile_definitions(${target} PRIVATE USE_PERF_COUNTERS)
+    endif()
+    target_link_libraries(${target} PRIVATE m Threads::Threads)
+  endif()
+endfunction()
+
+# Precision, and MPI or the single-process mpi.h of cmake/mpi_serial, of an FDTD sample;
+# LECTURE_FLOAT: single precision everywhere, otherwise the default of the sample
+# (double, single for 06_openacc5)
+function(lecture_fdtd_options target mpi)
+  if(LECTURE_FLOAT)
+    target_compile_definitions(${target} PRIVATE USE_FLOAT)
+  endif()
+  if(mpi)
+    target_link_libraries(${target} PRIVATE MPI::MPI_C MPI::MPI_CXX)
+  else()
+    target_include_directories(${target} BEFORE PRIVATE "${PROJECT_SOURCE_DIR}/cmake/mpi_serial")
+  endif()
+endfunction()
@@ -0,0 +1,34 @@
+# Single against double precision of 06_openacc5: runs RUN and RUN_DOUBLE
+# with ARGS in DIR/float and DIR/double, then compares the snapshot
+# SNAPSHOT of the two with SNAPSHOT_DIFF (relative L2 error <= TOLERANCE).
+#
+#   cmake -DRUN=<run> -DRUN_DOUBLE=<run_double> -DSNAPSHOT_DIFF=<snapshot_diff>
+#         -DDIR=<directory> -DARGS="<arguments>" -DSNAPSHOT=s02000.snp
+#         -DTOLERANCE=1.0e-3 -P LecturePrecisionCheck.cmake
+#
+# Used by the test and the target c_fdtd_06_openacc5_precision_check.
+separate_arguments(args UNIX_COMMAND "${ARGS}")
+
+foreach(precision float double)
+  if(precision STREQUAL "float")
+    set(exe "${RUN}")
+  else()
+    set(exe "${RUN_DOUBLE}")
+  endif()
+  file(MAKE_DIRECTORY "${DIR}/${precision}")
+  file(REMOVE "${DIR}/${precision}/${SNAPSHOT}")
+  execute_process(COMMAND "${exe}" ${args}
+                  WORKING_DIRECTORY "${DIR}/${precision}"
+                  RESULT_VARIABLE status
+                  OUTPUT_FILE "${DIR}/${precision}/run.log")
+  if(NOT status EQUAL 0)
+    message(FATAL_ERROR "${exe} failed (${status}), see ${DIR}/${precision}/run.log")
+  endif()
+endforeach()
+
+execute_process(COMMAND "${SNAPSHOT_DIFF}" "double/${SNAPSHOT}" "float/${SNAPSHOT}" ${TOLERANCE}
+                WORKING_DIRECTORY "${DIR}"
+                RESULT_VARIABLE status)
+if(NOT status EQUAL 0)
+  message(FATAL_ERROR "float and double differ by more than ${TOLERANCE}")
+endif()
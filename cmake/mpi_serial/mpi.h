@@ -0,0 +1,140 @@
+/**
+ * @file mpi.h
+ * @brief Single-process stand-in for MPI (CMake option LECTURE_MPI=OFF)
+ *
+ * Only the part of MPI used by the serial drivers of openacc_fdtd and the
+ * modules they share with main_mpi.c.  MPI is never initialized, so the
+ * modules take their MPI_Initialized() == 0 path; the collectives are the
+ * ones of a single rank (copies), point-to-point calls accept only
+ * MPI_PROC_NULL.
+ *
+ * @author Takashi Shimokawabe
+ * @date 2026/10/19 Created
+ * @version 0.1.0
+ *
+ * $Header$
+ */
+
+#ifndef MPI_SERIAL_MPI_H
+#define MPI_SERIAL_MPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef int MPI_Comm;
+typedef int MPI_Datatype; // size of the element in bytes
+typedef int MPI_Op;
+typedef struct {
+    int MPI_SOURCE;
+    int MPI_TAG;
+    int MPI_ERROR;
+} MPI_Status;
+
+#define MPI_SUCCESS        0
+#define MPI_COMM_WORLD     0
+#define MPI_PROC_NULL      (-2)
+#define MPI_STATUS_IGNORE  ((MPI_Status *)0)
+#define MPI_IN_PLACE       ((void *)1)
+
+#define MPI_BYTE           ((MPI_Datatype)1)
+#define MPI_CHAR           ((MPI_Datatype)sizeof(char))
+#define MPI_INT            ((MPI_Datatype)sizeof(int))
+#define MPI_LONG           ((MPI_Datatype)sizeof(long))
+#define MPI_FLOAT          ((MPI_Datatype)sizeof(float))
+#define MPI_DOUBLE         ((MPI_Datatype)sizeof(double))
+
+#define MPI_SUM            1
+#define MPI_MAX            2
+#define MPI_MIN            3
+
+static inline int MPI_Init(int *argc, char ***argv) { (void)argc; (void)argv; return MPI_SUCCESS; }
+static inline int MPI_Finalize(void) { return MPI_SUCCESS; }
+static inline int MPI_Initialized(int *flag) { *flag = 0; return MPI_SUCCESS; }
+static inline int MPI_Comm_rank(MPI_Comm comm, int *rank) { (void)comm; *rank = 0; return MPI_SUCCESS; }
+static inline int MPI_Comm_size(MPI_Comm comm, int *size) { (void)comm; *size = 1; return MPI_SUCCESS; }
+static inline int MPI_Barrier(MPI_Comm comm) { (void)comm; return MPI_SUCCESS; }
+
+static inline int MPI_Abort(MPI_Comm comm, int errorcode)
+{
+    (void)comm;
+    exit(errorcode);
+    return errorcode;
+}
+
+static inline double MPI_Wtime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1.0e-9*ts.tv_nsec;
+}
+
+static inline int mpi_serial_p2p(int peer, const char *name)
+{
+    if (peer == MPI_PROC_NULL) return MPI_SUCCESS;
+    fprintf(stderr, "Error: %s to rank %d in a build without MPI\n", name, peer);
+    exit(1);
+    return 1;
+}
+
+static inline int MPI_Send(const void *buf, int count, MPI_Datatype type, int dest, int tag, MPI_Comm comm)
+{
+    (void)buf; (void)count; (void)type; (void)tag; (void)comm;
+    return mpi_serial_p2p(dest, "MPI_Send");
+}
+
+static inline int MPI_Recv(void *buf, int count, MPI_Datatype type, int source, int tag, MPI_Comm comm, MPI_Status *status)
+{
+    (void)buf; (void)count; (void)type; (void)tag; (void)comm;
+    if (status != MPI_STATUS_IGNORE) {
+        status->MPI_SOURCE = MPI_PROC_NULL;
+        status->MPI_TAG    = tag;
+        status->MPI_ERROR  = MPI_SUCCESS;
+    }
+    return mpi_serial_p2p(source, "MPI_Recv");
+}
+
+// The collectives of one rank: the send buffer is the result
+static inline int mpi_serial_copy(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type)
+{
+    if (sendbuf != MPI_IN_PLACE && sendbuf != recvbuf && count > 0) {
+        memcpy(recvbuf, sendbuf, (size_t)count*type);
+    }
+    return MPI_SUCCESS;
+}
+
+static inline int MPI_Bcast(void *buf, int count, MPI_Datatype type, int root, MPI_Comm comm)
+{
+    (void)buf; (void)count; (void)type; (void)root; (void)comm;
+    return MPI_SUCCESS;
+}
+
+static inline int MPI_Reduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type, MPI_Op op, int root, MPI_Comm comm)
+{
+    (void)op; (void)root; (void)comm;
+    return mpi_serial_copy(sendbuf, recvbuf, count, type);
+}
+
+static inline int MPI_Allreduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type, MPI_Op op, MPI_Comm comm)
+{
+    (void)op; (void)comm;
+    return mpi_serial_copy(sendbuf, recvbuf, count, type);
+}
+
+static inline int MPI_Gather(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                             void *recvbuf, int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm)
+{
+    (void)recvcount; (void)recvtype; (void)root; (void)comm;
+    return mpi_serial_copy(sendbuf, recvbuf, sendcount, sendtype);
+}
+
+static inline int MPI_Gatherv(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                              void *recvbuf, const int *recvcounts, const int *displs, MPI_Datatype recvtype,
+                              int root, MPI_Comm comm)
+{
+    (void)recvcounts; (void)root; (void)comm;
+    return mpi_serial_copy(sendbuf, (char *)recvbuf + (size_t)displs[0]*recvtype, sendcount, sendtype);
+}
+
+#endif /* MPI_SERIAL_MPI_H */